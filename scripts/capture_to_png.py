@@ -0,0 +1,196 @@
+#!/usr/bin/env python3
+"""Rebuild screenshots from the serial capture stream of src/ScreenCapture.
+
+Usage:
+    python scripts/capture_to_png.py --port /dev/ttyUSB0 [--baud 115200] [--out captures]
+    python scripts/capture_to_png.py --input capture.bin [--out captures]
+
+With --port the script sends 'C' to start capturing (and 'X' on exit), asks
+for a keyframe whenever a packet is lost, and writes captures/frame_NNNNN.png
+each time the screen has changed at a frame marker. Text printed on the same
+port (logs, reports) is passed through to stdout; telemetry frames
+(scripts/telemetry_decode.py) are skipped. --raw saves the received
+bytes so a session can be replayed later with --input.
+
+Needs Pillow, and pyserial for --port (pip install pillow pyserial).
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SYNC = b'\xA5\x5A'
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def rgb565_to_rgb(c):
+    r = (c >> 11) & 0x1F
+    g = (c >> 5) & 0x3F
+    b = c & 0x1F
+    return (r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2)
+
+
+def decode_row(data, w):
+    """Inverse of encodeRow() in ScreenCapture.cpp / pack_image.py."""
+    px = []
+    i = 0
+    while len(px) < w and i < len(data):
+        c = data[i]
+        i += 1
+        n = (c & 0x7F) + 1
+        if c & 0x80:
+            px.extend([struct.unpack_from('<H', data, i)[0]] * n)
+            i += 2
+        else:
+            px.extend(struct.unpack_from('<%dH' % n, data, i))
+            i += 2 * n
+    return px[:w]
+
+
+class Decoder:
+    def __init__(self, out_dir, on_lost=None):
+        self.buf = bytearray()
+        self.out_dir = out_dir
+        self.on_lost = on_lost
+        self.canvas = None
+        self.size = (0, 0)
+        self.dirty = False
+        self.synced = False
+        self.expected_seq = None
+        self.written = 0
+        self.bad_packets = 0
+        self.text = bytearray()
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            start = self.buf.find(SYNC)
+            frame = self.buf.find(b'\x00')
+            if frame >= 0 and (start < 0 or frame < start):
+                # A telemetry frame (0x00, COBS, 0x00) sent between packets: drop it
+                end = self.buf.find(b'\x00', frame + 1)
+                if end < 0:
+                    self._text(self.buf[:frame])
+                    del self.buf[:frame]
+                    return
+                self._text(self.buf[:frame])
+                del self.buf[:end + 1]
+                continue
+            if start < 0:
+                # Keep a possible half sync byte, pass the rest through as text
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self._text(self.buf[:len(self.buf) - keep])
+                del self.buf[:len(self.buf) - keep]
+                return
+            self._text(self.buf[:start])
+            del self.buf[:start]
+            if len(self.buf) < 6:
+                return
+            ptype, seq, length = struct.unpack_from('<BBH', self.buf, 2)
+            if length > 2048:
+                del self.buf[:1]
+                continue
+            total = 6 + length + 2
+            if len(self.buf) < total:
+                return
+            body = bytes(self.buf[2:6 + length])
+            (crc,) = struct.unpack_from('<H', self.buf, 6 + length)
+            if crc16(body) != crc:
+                # Not a packet (or a damaged one): skip the sync byte and rescan
+                self.bad_packets += 1
+                del self.buf[:1]
+                self._lost()
+                continue
+            del self.buf[:total]
+            if self.expected_seq is not None and seq != self.expected_seq:
+                self._lost()
+            self.expected_seq = (seq + 1) & 0xFF
+            self._packet(chr(ptype), body[4:])
+
+    def _text(self, data):
+        self.text += data
+        while b'\n' in self.text:
+            line, _, rest = self.text.partition(b'\n')
+            sys.stdout.write(line.decode('utf-8', 'replace') + '\n')
+            self.text = bytearray(rest)
+
+    def _lost(self):
+        if self.synced:
+            self.synced = False
+            if self.on_lost:
+                self.on_lost()
+
+    def _packet(self, ptype, payload):
+        if ptype == 'K':
+            from PIL import Image
+            w, h = struct.unpack_from('<HH', payload)
+            self.size = (w, h)
+            self.canvas = Image.new('RGB', (w, h))
+            self.synced = True
+            self.dirty = True
+        elif ptype == 'R' and self.canvas is not None:
+            x, y, w = struct.unpack_from('<HHH', payload)
+            row = decode_row(payload[6:], w)
+            for i, c in enumerate(row):
+                if x + i < self.size[0] and y < self.size[1]:
+                    self.canvas.putpixel((x + i, y), rgb565_to_rgb(c))
+            self.dirty = True
+        elif ptype == 'F':
+            frame, flags = struct.unpack_from('<IB', payload)
+            if self.canvas is not None and self.synced and not (flags & 1) and self.dirty:
+                path = os.path.join(self.out_dir, 'frame_%05d.png' % frame)
+                self.canvas.save(path)
+                self.written += 1
+                self.dirty = False
+                print('wrote %s' % path, file=sys.stderr)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument('--port', help='serial port of the device')
+    src.add_argument('--input', help='replay a saved raw capture')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--out', default='captures', help='directory for the PNGs')
+    ap.add_argument('--raw', help='also save the received bytes to this file')
+    args = ap.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+    raw = open(args.raw, 'wb') if args.raw else None
+
+    if args.input:
+        dec = Decoder(args.out)
+        with open(args.input, 'rb') as f:
+            dec.feed(f.read())
+        print('%d PNGs written, %d bad packets' % (dec.written, dec.bad_packets), file=sys.stderr)
+        return 0
+
+    import serial
+    port = serial.Serial(args.port, args.baud, timeout=0.1)
+    dec = Decoder(args.out, on_lost=lambda: port.write(b'K'))
+    port.write(b'C')
+    try:
+        while True:
+            data = port.read(4096)
+            if data:
+                if raw:
+                    raw.write(data)
+                dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        port.write(b'X')
+        print('%d PNGs written, %d bad packets' % (dec.written, dec.bad_packets), file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,179 @@
+// Host-side test of the coroutine runner (src/Coroutine.cpp) on the host
+// clock. Each scenario runs a small coroutine through CoroutineRunner and
+// checks when it is resumed: CO_SLEEP_MS waits its time and no longer, a
+// CO_PIN_EDGE await resumes on the interrupt or on its timeout and leaves the
+// pin detached either way, and CO_I2C_READ completes through I2CBus on a fake
+// device, or fails at once while the bus is down instead of waiting for ever.
+// Exits with status 1 on a failure.
+//
+// Build and run from the project root:
+//   g++ -std=gnu++17 -Iscripts/host -Isrc scripts/coroutine_sim.cpp src/Coroutine.cpp src/I2CBus.cpp -o coroutine_sim
+//   ./coroutine_sim
+
+#include <cstdio>
+#include <cstring>
+#include <Arduino.h>
+#include "Coroutine.h"
+#include "RunLoop.h"
+
+static int failures = 0;
+static int wakes = 0;
+
+// Coroutine.cpp wakes the run loop from pin ISRs
+void RunLoop::wakeFromISR() {
+  wakes++;
+}
+
+static void check(bool ok, const char *what) {
+  printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+static CoroutineRunner &runner = CoroutineRunner::getInstance();
+
+// Runs the loop for `ms`, servicing the runner every millisecond
+static void advance(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    hostClockUs += 1000;
+    runner.service();
+  }
+}
+
+// One register file at 0x44, answering with no delay
+class FakeDevice : public I2CBackend {
+public:
+  uint8_t regs[256] = {};
+  uint32_t transactions = 0;
+
+  bool begin(int, int, uint32_t) override { return true; }
+  uint8_t writeRead(uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen) override {
+    transactions++;
+    if (addr != 0x44) return 2;
+    for (size_t i = 0; i < rxLen; i++) rx[i] = regs[(uint8_t)(tx[0] + i)];
+    (void)txLen;
+    return 0;
+  }
+  uint32_t micros() override { return (uint32_t)hostClockUs; }
+};
+
+static FakeDevice device;
+static I2CBus &i2c = I2CBus::getInstance();
+
+class Sleeper : public Coroutine {
+public:
+  int stage = 0;
+
+protected:
+  void step(uint32_t now) override {
+    CO_BEGIN();
+    stage = 1;
+    CO_SLEEP_MS(50);
+    stage = 2;
+    CO_END();
+  }
+};
+
+class EdgeWaiter : public Coroutine {
+public:
+  static constexpr uint8_t Pin = 27;
+  int stage = 0;
+  bool firstOk = false;
+  uint32_t timedOutAt = 0;
+
+protected:
+  void step(uint32_t now) override {
+    CO_BEGIN();
+    stage = 1;
+    CO_PIN_EDGE(Pin, FALLING, 20);
+    firstOk = lastOk();
+    stage = 2;
+    CO_PIN_EDGE(Pin, FALLING, 20);
+    timedOutAt = now;
+    stage = 3;
+    CO_END();
+  }
+};
+
+class Reader : public Coroutine {
+public:
+  uint8_t buf[2] = {};
+  int stage = 0;
+
+protected:
+  void step(uint32_t now) override {
+    (void)now;
+    CO_BEGIN();
+    stage = 1;
+    CO_I2C_READ(0x44, 0x10, buf, sizeof(buf));
+    stage = 2;
+    CO_END();
+  }
+};
+
+static void testSleep() {
+  Sleeper co;
+  runner.start(co);
+  check(co.stage == 1 && co.running(), "sleep: first step runs on start()");
+  check(runner.msUntilNextResume() == 50, "sleep: runner asks for 50 ms");
+  advance(49);
+  check(co.stage == 1, "sleep: still asleep after 49 ms");
+  advance(1);
+  check(co.stage == 2 && !co.running() && runner.active() == 0, "sleep: resumed and finished at 50 ms");
+}
+
+static void testEdge() {
+  EdgeWaiter co;
+  wakes = 0;
+  runner.start(co);
+  check(hostIsrs[EdgeWaiter::Pin].fn != nullptr, "edge: interrupt attached while waiting");
+  advance(5);
+  check(co.stage == 1, "edge: nothing happens before the edge");
+  hostInterrupt(EdgeWaiter::Pin);
+  check(wakes == 1 && runner.msUntilNextResume() == 0, "edge: ISR wakes the loop, resume is due now");
+  advance(1);
+  check(co.stage == 2 && co.firstOk, "edge: resumed on the edge, lastOk() true");
+
+  uint32_t waitStart = millis();
+  advance(19);
+  check(co.stage == 2, "edge: second wait still pending at 19 ms");
+  advance(1);
+  check(co.stage == 3 && !co.lastOk() && co.timedOutAt - waitStart == 20, "edge: timed out at 20 ms, lastOk() false");
+  check(hostIsrs[EdgeWaiter::Pin].fn == nullptr, "edge: interrupt detached after the timeout");
+}
+
+static void testI2cDown() {
+  // Backend set but begin() not called: the bus is down
+  Reader co;
+  runner.start(co);
+  advance(1);
+  check(co.stage == 2 && !co.running() && !co.lastOk(), "i2c: read fails at once while the bus is down");
+  check(device.transactions == 0 && !i2c.pending(), "i2c: nothing queued for a bus that is down");
+}
+
+static void testI2cRead() {
+  device.regs[0x10] = 0x12;
+  device.regs[0x11] = 0x34;
+  Reader co;
+  runner.start(co);
+  advance(3);
+  check(co.stage == 1 && i2c.pending(), "i2c: waits while the read is queued");
+  i2c.service();
+  check(runner.msUntilNextResume() == 0, "i2c: completion makes the resume due now");
+  advance(1);
+  check(co.stage == 2 && co.lastOk() && co.buf[0] == 0x12 && co.buf[1] == 0x34,
+        "i2c: resumed with the data, lastOk() true");
+}
+
+int main() {
+  hostClockUs = 1000000;
+  i2c.setBackend(&device);
+
+  testSleep();
+  testEdge();
+  testI2cDown();
+  i2c.begin(21, 22);
+  testI2cRead();
+
+  printf("\n%s\n", failures ? "FAILED" : "all passed");
+  return failures ? 1 : 0;
+}
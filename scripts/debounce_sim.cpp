@@ -0,0 +1,176 @@
+// Host-side check of the limit switch debounce state machine (src/Debounce.h).
+// Replays recorded-style bounce patterns and random bounce trains through it,
+// the way LimitSwitch drives it (pin interrupt -> settle timer -> sample),
+// and prints what was detected and how long each press took to be accepted.
+// Exits with status 1 if any scenario doesn't give the expected result.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/debounce_sim.cpp -o debounce_sim
+//   ./debounce_sim [settle_us] [random_presses]
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Debounce.h"
+
+// Interrupt latency added to every edge
+static const uint64_t IsrUs = 5;
+
+struct Transition {
+  uint64_t us;
+  bool level;
+};
+
+struct Outcome {
+  int presses = 0;
+  int releases = 0;
+  int glitches = 0;
+  uint32_t maxReactionUs = 0; // first edge of a press until it was accepted
+};
+
+// Pin level at time t, starting released
+static bool levelAt(const std::vector<Transition> &pin, uint64_t t) {
+  auto it = std::upper_bound(pin.begin(), pin.end(), t, [](uint64_t us, const Transition &tr) { return us < tr.us; });
+  return it == pin.begin() ? false : (it - 1)->level;
+}
+
+static Outcome run(const std::vector<Transition> &pin, uint32_t settleUs) {
+  Debounce deb(false, settleUs);
+  Outcome o;
+  size_t next = 0;
+  bool timerArmed = false;
+  uint64_t timerAt = 0;
+
+  for (;;) {
+    uint64_t edgeAt = next < pin.size() ? pin[next].us + IsrUs : UINT64_MAX;
+    if (!timerArmed && edgeAt == UINT64_MAX) break;
+
+    if (edgeAt <= timerAt || !timerArmed) {
+      if (deb.edge(edgeAt)) {
+        timerArmed = true;
+        timerAt = edgeAt + settleUs;
+      }
+      next++;
+      continue;
+    }
+
+    uint64_t now = timerAt;
+    timerArmed = false;
+    bool level = levelAt(pin, now);
+    switch (deb.expire(level, now)) {
+    case Debounce::CHANGED:
+      if (level) {
+        o.presses++;
+        uint32_t us = (uint32_t)(now - deb.firstEdge() + IsrUs);
+        if (us > o.maxReactionUs) o.maxReactionUs = us;
+      } else {
+        o.releases++;
+      }
+      break;
+    case Debounce::REARM:
+      timerArmed = true;
+      timerAt = now + deb.rearmUs(now);
+      break;
+    case Debounce::GLITCH:
+      o.glitches++;
+      break;
+    default:
+      break;
+    }
+  }
+  return o;
+}
+
+// Contact bounce: `edges` alternating transitions spread over bounceUs, ending at `level`
+static void bounce(std::vector<Transition> &pin, uint64_t at, bool level, int edges, uint32_t bounceUs) {
+  if (edges % 2 == 0) edges++;
+  for (int i = 0; i < edges; i++) {
+    pin.push_back({at + (uint64_t)bounceUs * i / (edges > 1 ? edges - 1 : 1), i % 2 == 0 ? level : !level});
+  }
+}
+
+struct Scenario {
+  const char *name;
+  std::vector<Transition> pin;
+  int presses, releases, glitches;
+};
+
+int main(int argc, char **argv) {
+  uint32_t settleUs = argc > 1 ? (uint32_t)atoi(argv[1]) : 1000;
+  int randomPresses = argc > 2 ? atoi(argv[2]) : 10000;
+
+  std::vector<Scenario> scenarios;
+  scenarios.push_back({"clean press and release", {{1000, true}, {200000, false}}, 1, 1, 0});
+  {
+    Scenario s{"press bouncing for 400us", {}, 1, 1, 0};
+    bounce(s.pin, 1000, true, 9, 400);
+    bounce(s.pin, 300000, false, 5, 300);
+    scenarios.push_back(s);
+  }
+  {
+    Scenario s{"press bouncing for 3x the settle time", {}, 1, 1, 0};
+    bounce(s.pin, 1000, true, 31, 3 * settleUs);
+    bounce(s.pin, 300000, false, 31, 3 * settleUs);
+    scenarios.push_back(s);
+  }
+  scenarios.push_back({"50us noise spike", {{1000, true}, {1050, false}}, 0, 0, 1});
+  {
+    Scenario s{"noise burst ending released", {}, 0, 0, 1};
+    bounce(s.pin, 1000, false, 8, 200); // even count: ends where it started
+    s.pin.back().level = false;
+    scenarios.push_back(s);
+  }
+  {
+    // Two half-settle pulses with quiet gaps: glitches, then a real press
+    uint64_t S = settleUs;
+    scenarios.push_back({"2 short pulses, then pressed",
+                         {{1000, true}, {1000 + S / 2, false}, {1000 + 2 * S, true}, {1000 + 5 * S / 2, false},
+                          {1000 + 4 * S, true}, {300000, false}},
+                         1, 1, 2});
+  }
+  scenarios.push_back({"spike during a press", {{1000, true}, {100000, false}, {100030, true}, {200000, false}}, 1, 1, 1});
+
+  int failures = 0;
+  printf("settle %luus, interrupt latency %luus\n", (unsigned long)settleUs, (unsigned long)IsrUs);
+  printf("%-40s %8s %8s %8s %12s\n", "scenario", "presses", "releases", "glitches", "reaction_us");
+  for (const Scenario &s : scenarios) {
+    Outcome o = run(s.pin, settleUs);
+    bool ok = o.presses == s.presses && o.releases == s.releases && o.glitches == s.glitches;
+    printf("%-40s %8d %8d %8d %12lu%s\n", s.name, o.presses, o.releases, o.glitches, (unsigned long)o.maxReactionUs,
+           ok ? "" : "  FAIL");
+    if (!ok) failures++;
+  }
+
+  // Random bounce trains of up to 5 ms, with gaps shorter than the settle time
+  // (a longer gap is indistinguishable from a glitch followed by a press).
+  // Every press must be seen exactly once, within a settle time of the end of
+  // its bounce.
+  srand(1);
+  std::vector<Transition> pin;
+  uint64_t t = 1000;
+  uint32_t worst = 0, worstBounce = 0;
+  auto randomBounce = [&](bool level) {
+    int edges = 1 + 2 * (rand() % 20);
+    uint32_t longest = (edges - 1) * (settleUs - 1);
+    uint32_t bounceUs = rand() % ((longest < 5000 ? longest : 5000) + 1);
+    bounce(pin, t, level, edges, bounceUs);
+    return bounceUs;
+  };
+  for (int i = 0; i < randomPresses; i++) {
+    uint32_t bounceUs = randomBounce(true);
+    if (bounceUs > worstBounce) worstBounce = bounceUs;
+    t += 50000 + rand() % 50000;
+    randomBounce(false);
+    t += 50000 + rand() % 50000;
+  }
+  Outcome o = run(pin, settleUs);
+  worst = o.maxReactionUs;
+  bool ok = o.presses == randomPresses && o.releases == randomPresses && o.glitches == 0 &&
+            worst <= worstBounce + settleUs + IsrUs;
+  printf("%d random bounce trains: presses=%d releases=%d glitches=%d worst reaction=%luus%s\n", randomPresses,
+         o.presses, o.releases, o.glitches, (unsigned long)worst, ok ? "" : "  FAIL");
+  if (!ok) failures++;
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+// Host-side test of FileManager's LVGL filesystem driver (src/FileManager.cpp)
+// against a fake SD card backed by a temporary directory (scripts/host/SD.h).
+// Checks reads at and past the end of files that don't end on a sector
+// boundary, random seek/read sequences against the file contents, that
+// writes through LVGL and the append queue are seen by open read handles, and
+// prints card traffic and modelled throughput for sequential and random reads
+// with and without the read-ahead buffer. Exits with status 1 on a failure.
+//
+// Build and run from the project root:
+//   g++ -std=gnu++17 -DARDUINO -Iscripts/host -Isrc scripts/fs_sim.cpp src/FileManager.cpp src/SpiArbiter.cpp
+//       src/EventBus.cpp src/MemoryMonitor.cpp src/StaticAlloc.cpp -o fs_sim
+//   ./fs_sim
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "FileManager.h"
+
+static FileManager fileManager;
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-58s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+static std::string root;
+
+static std::vector<uint8_t> makeFile(const char *name, size_t size, uint32_t seed) {
+  std::vector<uint8_t> data(size);
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = (uint8_t)(seed >> 16);
+  }
+  FILE *f = fopen((root + name).c_str(), "wb");
+  fwrite(data.data(), 1, size, f);
+  fclose(f);
+  return data;
+}
+
+// What LVGL's lv_fs_* calls do once the drive letter is stripped
+struct LvFile {
+  void *h = nullptr;
+
+  bool open(const char *path, lv_fs_mode_t mode = LV_FS_MODE_RD) {
+    h = hostFsDriver->open_cb(hostFsDriver, path, mode);
+    return h != nullptr;
+  }
+  void close() {
+    if (h) hostFsDriver->close_cb(hostFsDriver, h);
+    h = nullptr;
+  }
+  uint32_t read(void *buf, uint32_t len) {
+    uint32_t br = 0;
+    hostFsDriver->read_cb(hostFsDriver, h, buf, len, &br);
+    return br;
+  }
+  uint32_t write(const void *buf, uint32_t len) {
+    uint32_t bw = 0;
+    hostFsDriver->write_cb(hostFsDriver, h, buf, len, &bw);
+    return bw;
+  }
+  void seek(uint32_t pos, lv_fs_whence_t whence = LV_FS_SEEK_SET) { hostFsDriver->seek_cb(hostFsDriver, h, pos, whence); }
+};
+
+static void testEndOfFile() {
+  std::vector<uint8_t> data = makeFile("/short.bin", 100, 1);
+  LvFile f;
+  f.open("/short.bin");
+  uint8_t buf[600];
+  check(f.read(buf, 200) == 100 && memcmp(buf, data.data(), 100) == 0, "short file: read past the end is short");
+  check(f.read(buf, 10) == 0, "short file: read at the end returns 0");
+  f.seek(50);
+  check(f.read(buf, 60) == 50 && memcmp(buf, data.data() + 50, 50) == 0, "short file: read across the end");
+  f.seek(300);
+  check(f.read(buf, 10) == 0, "short file: read after seeking past the end");
+  f.seek(4000);
+  check(f.read(buf, 10) == 0, "short file: read after seeking several sectors past the end");
+  f.close();
+
+  std::vector<uint8_t> big = makeFile("/odd.bin", 3 * 512 + 17, 2);
+  f.open("/odd.bin");
+  std::vector<uint8_t> all(big.size() + 512);
+  check(f.read(all.data(), all.size()) == big.size() && memcmp(all.data(), big.data(), big.size()) == 0,
+        "unaligned file: one large read returns the whole file");
+  check(f.read(buf, 512) == 0, "unaligned file: then 0 at the end");
+  f.close();
+}
+
+static void testRandomReads() {
+  std::vector<uint8_t> data = makeFile("/random.bin", 20000, 3);
+  LvFile f;
+  f.open("/random.bin");
+  srand(7);
+  bool ok = true;
+  std::vector<uint8_t> buf(5000);
+  for (int i = 0; i < 20000 && ok; i++) {
+    uint32_t pos = rand() % (data.size() + 600);
+    uint32_t len = rand() % 4 == 0 ? rand() % 5000 : rand() % 300;
+    if (rand() % 3) {
+      f.seek(pos);
+    } else {
+      hostFsDriver->tell_cb(hostFsDriver, f.h, &pos); // carry on from the last read
+    }
+    uint32_t want = pos >= data.size() ? 0 : std::min<uint32_t>(len, data.size() - pos);
+    uint32_t got = f.read(buf.data(), len);
+    ok = got == want && memcmp(buf.data(), data.data() + (pos < data.size() ? pos : 0), got) == 0;
+  }
+  f.close();
+  check(ok, "20000 random seeks and reads match the file");
+}
+
+static void testWritesInvalidate() {
+  makeFile("/shared.bin", 1000, 4);
+  LvFile reader;
+  reader.open("/shared.bin");
+  uint8_t buf[64];
+  reader.read(buf, 64); // fills the read-ahead buffer
+
+  LvFile writer;
+  writer.open("/shared.bin", LV_FS_MODE_WR | LV_FS_MODE_RD);
+  uint8_t patch[16];
+  memset(patch, 0xA5, sizeof(patch));
+  writer.seek(8);
+  writer.write(patch, sizeof(patch));
+  writer.close();
+
+  reader.seek(8);
+  check(reader.read(buf, 16) == 16 && memcmp(buf, patch, 16) == 0, "read handle sees a write through another handle");
+
+  // Append through the queue: data past the old end becomes readable
+  reader.seek(1000);
+  check(reader.read(buf, 16) == 0, "read handle at the end before an append");
+  uint8_t tail[32];
+  memset(tail, 0x5A, sizeof(tail));
+  fileManager.queueAppend("/shared.bin", tail, sizeof(tail));
+  while (fileManager.appendPending()) fileManager.service();
+  reader.seek(1000);
+  check(reader.read(buf, 32) == 32 && memcmp(buf, tail, 32) == 0, "read handle sees data appended by the queue");
+  reader.close();
+}
+
+struct Traffic {
+  uint32_t reads;
+  uint64_t bytes;
+  uint64_t us;
+};
+
+// Reads `total` bytes in `chunk`-sized requests, sequentially or at random
+// offsets, through the driver or straight from the card
+static Traffic measure(const std::vector<uint8_t> &data, uint32_t chunk, bool sequential, bool direct) {
+  HostCard before = hostCard;
+  uint64_t t0 = hostClockUs;
+  std::vector<uint8_t> buf(chunk);
+  srand(11);
+  uint32_t requests = (uint32_t)(data.size() / chunk);
+  if (direct) {
+    File file = SD.open("/image.bin");
+    for (uint32_t i = 0; i < requests; i++) {
+      uint32_t pos = sequential ? i * chunk : (rand() % requests) * chunk;
+      if (file.position() != pos) file.seek(pos);
+      file.read(buf.data(), chunk);
+    }
+    file.close();
+  } else {
+    LvFile f;
+    f.open("/image.bin");
+    for (uint32_t i = 0; i < requests; i++) {
+      if (!sequential) f.seek((rand() % requests) * chunk);
+      f.read(buf.data(), chunk);
+    }
+    f.close();
+  }
+  return {hostCard.reads - before.reads, hostCard.bytesRead - before.bytesRead, hostClockUs - t0};
+}
+
+static void throughput() {
+  std::vector<uint8_t> data = makeFile("/image.bin", 64 * 1024, 5);
+  printf("\n64 KB file, card model %luus per command + %luus per KB\n", (unsigned long)HostCard::CommandUs,
+         (unsigned long)HostCard::UsPerKB);
+  printf("%-26s %-10s %8s %10s %10s %8s\n", "pattern", "path", "commands", "card bytes", "time us", "KB/s");
+  struct Pattern {
+    const char *name;
+    uint32_t chunk;
+    bool sequential;
+  } patterns[] = {
+      {"sequential 64 B", 64, true},
+      {"sequential 480 B (a row)", 480, true},
+      {"sequential 4 KB", 4096, true},
+      {"random 64 B", 64, false},
+      {"random 480 B", 480, false},
+  };
+  for (const Pattern &p : patterns) {
+    for (int direct = 1; direct >= 0; direct--) {
+      Traffic t = measure(data, p.chunk, p.sequential, direct);
+      printf("%-26s %-10s %8lu %10llu %10llu %8lu\n", p.name, direct ? "card" : "read-ahead", (unsigned long)t.reads,
+             (unsigned long long)t.bytes, (unsigned long long)t.us,
+             (unsigned long)(t.us ? data.size() * 1000 / t.us : 0));
+    }
+  }
+  fileManager.reportFs(Serial);
+}
+
+int main() {
+  char dir[] = "/tmp/fs_simXXXXXX";
+  if (!mkdtemp(dir)) return 1;
+  root = dir;
+  SD.setRoot(root);
+  fileManager.begin();
+  fileManager.registerLvglDriver('S');
+
+  // A read that never returns would otherwise hang rather than fail
+  setvbuf(stdout, nullptr, _IONBF, 0);
+  signal(SIGALRM, [](int) {
+    printf("FAIL: timed out\n");
+    _exit(1);
+  });
+  alarm(20);
+  testEndOfFile();
+  testRandomReads();
+  testWritesInvalidate();
+  throughput();
+
+  std::string cmd = "rm -rf " + root;
+  if (system(cmd.c_str()) != 0) fprintf(stderr, "couldn't remove %s\n", root.c_str());
+  return failures ? 1 : 0;
+}
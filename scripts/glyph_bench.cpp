@@ -0,0 +1,173 @@
+// Host benchmark for the glyph cache: how long LVGL takes to redraw a sensor
+// value drawn by a montserrat_28 label, and by a GlyphReadout
+// (src/GlyphCache.cpp) of the same size, colours and font. Both are put
+// through the same sequence of values ("18.0°C" .. "37.9°C"), one
+// lv_refr_now() per value, so each update redraws exactly the widget's area.
+// Prints the median, mean and fastest update for each, the bytes flushed per
+// update, and how many pixels of the two differ for the same value (the cache
+// blends onto a fixed background, so this should be close to zero).
+//
+// Host times are not ESP32 times; the ratio between the two is what carries
+// over. Build and run from the project root, after a PlatformIO build has
+// fetched LVGL into .pio/libdeps:
+//   scripts/glyph_bench.sh [updates]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <Arduino.h>
+#include <lvgl.h>
+#include "GlyphCache.h"
+
+// Same resolution and draw buffer as TemplateCode
+static constexpr lv_coord_t Width = 320;
+static constexpr lv_coord_t Height = 240;
+static lv_color_t drawBuf[Width * Height / 10];
+static uint16_t frame[Width * Height];
+
+// Same size and placement as the readouts in MainInterface
+static constexpr lv_coord_t ValueWidth = 200;
+static constexpr lv_coord_t ValueY = 60;
+
+extern "C" unsigned long hostMillis(void) {
+  return millis();
+}
+
+static uint64_t flushedBytes = 0;
+
+static void flushFrame(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *px) {
+  lv_coord_t w = area->x2 - area->x1 + 1;
+  for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+    memcpy(&frame[y * Width + area->x1], px + (y - area->y1) * w, w * sizeof(lv_color_t));
+  }
+  flushedBytes += (uint64_t)w * (area->y2 - area->y1 + 1) * sizeof(lv_color_t);
+  lv_disp_flush_ready(drv);
+}
+
+static uint64_t nowNs() {
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static void valueText(int i, char *buf, size_t len) {
+  int tenths = 180 + i % 200;
+  snprintf(buf, len, "%d.%d°C", tenths / 10, tenths % 10);
+}
+
+static lv_obj_t *blackScreen() {
+  lv_obj_t *scr = lv_obj_create(NULL);
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x000000), LV_PART_MAIN);
+  lv_obj_clear_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+  return scr;
+}
+
+struct Result {
+  std::vector<uint64_t> ns;
+  uint64_t bytes = 0;
+};
+
+// Loads `scr`, then times one refresh per value through `set`
+template <typename Set>
+static Result run(lv_disp_t *disp, lv_obj_t *scr, int updates, Set set) {
+  lv_scr_load(scr);
+  set(0);
+  lv_refr_now(disp);
+  flushedBytes = 0;
+
+  Result r;
+  r.ns.reserve(updates);
+  for (int i = 1; i <= updates; i++) {
+    uint64_t start = nowNs();
+    set(i);
+    lv_refr_now(disp);
+    r.ns.push_back(nowNs() - start);
+  }
+  r.bytes = flushedBytes;
+  return r;
+}
+
+static void print(const char *name, Result &r) {
+  std::sort(r.ns.begin(), r.ns.end());
+  uint64_t sum = 0;
+  for (uint64_t v : r.ns) sum += v;
+  printf("%-8s updates=%zu median=%.1fus mean=%.1fus min=%.1fus bytes/update=%llu\n", name, r.ns.size(),
+         r.ns[r.ns.size() / 2] / 1000.0, sum / 1000.0 / r.ns.size(), r.ns.front() / 1000.0,
+         (unsigned long long)(r.bytes / r.ns.size()));
+}
+
+static double median(const Result &r) {
+  return r.ns[r.ns.size() / 2];
+}
+
+int main(int argc, char **argv) {
+  int updates = argc > 1 ? atoi(argv[1]) : 2000;
+  if (updates < 1) updates = 1;
+
+  lv_init();
+  static lv_disp_draw_buf_t drawBufDsc;
+  lv_disp_draw_buf_init(&drawBufDsc, drawBuf, nullptr, Width * Height / 10);
+  static lv_disp_drv_t drv;
+  lv_disp_drv_init(&drv);
+  drv.hor_res = Width;
+  drv.ver_res = Height;
+  drv.flush_cb = flushFrame;
+  drv.draw_buf = &drawBufDsc;
+  lv_disp_t *disp = lv_disp_drv_register(&drv);
+
+  // Label, styled as the value labels were before the glyph cache
+  lv_obj_t *labelScreen = blackScreen();
+  lv_obj_t *label = lv_label_create(labelScreen);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_28, 0);
+  lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+  lv_label_set_long_mode(label, LV_LABEL_LONG_CLIP);
+  lv_obj_set_size(label, ValueWidth, lv_font_get_line_height(&lv_font_montserrat_28));
+  lv_obj_align(label, LV_ALIGN_TOP_MID, 0, ValueY);
+
+  static GlyphCache glyphs;
+  if (!glyphs.build(&lv_font_montserrat_28, lv_color_hex(0xFFFFFF), lv_color_hex(0x000000))) {
+    fprintf(stderr, "glyph cache build failed\n");
+    return 1;
+  }
+  static GlyphReadout readout;
+  lv_obj_t *readoutScreen = blackScreen();
+  lv_obj_align(readout.create(readoutScreen, glyphs, ValueWidth), LV_ALIGN_TOP_MID, 0, ValueY);
+
+  char text[GlyphReadout::MaxText];
+  auto setLabel = [&](int i) {
+    valueText(i, text, sizeof(text));
+    lv_label_set_text(label, text);
+  };
+  auto setReadout = [&](int i) {
+    valueText(i, text, sizeof(text));
+    readout.setText(text);
+  };
+
+  // Same value on both: count the pixels that differ
+  std::vector<uint16_t> labelFrame(frame, frame + Width * Height);
+  uint32_t differing = 0;
+  for (int i = 0; i < 200; i += 37) {
+    lv_scr_load(labelScreen);
+    setLabel(i);
+    lv_refr_now(disp);
+    labelFrame.assign(frame, frame + Width * Height);
+    lv_scr_load(readoutScreen);
+    setReadout(i);
+    lv_refr_now(disp);
+    for (size_t p = 0; p < labelFrame.size(); p++) differing += labelFrame[p] != frame[p];
+  }
+
+  // Warm up caches once each, then measure
+  run(disp, labelScreen, 100, setLabel);
+  run(disp, readoutScreen, 100, setReadout);
+  Result labelRun = run(disp, labelScreen, updates, setLabel);
+  Result readoutRun = run(disp, readoutScreen, updates, setReadout);
+
+  print("label", labelRun);
+  print("readout", readoutRun);
+  printf("readout is %.2fx the speed of the label (median), cache %zu B, %lu pixels differ over 6 values\n",
+         median(labelRun) / median(readoutRun), glyphs.bytesUsed(), (unsigned long)differing);
+  return 0;
+}
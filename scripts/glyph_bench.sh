@@ -0,0 +1,14 @@
+#!/bin/bash
+# Builds and runs the glyph cache benchmark (scripts/glyph_bench.cpp) against
+# the LVGL that PlatformIO fetched (see host_lvgl.sh). The optional argument
+# is the number of updates to time for each widget. Needs gcc and g++.
+set -eo pipefail
+
+cd "$(dirname "$0")/.."
+source scripts/host_lvgl.sh
+
+g++ -std=gnu++17 -DARDUINO "${LVGL_FLAGS[@]}" -Isrc \
+  scripts/glyph_bench.cpp src/GlyphCache.cpp \
+  "${LVGL_OBJS[@]}" -lm -o "$LVGL_OUT/glyph_bench"
+
+"$LVGL_OUT/glyph_bench" "$@"
@@ -0,0 +1,91 @@
+#pragma once
+
+// Just enough of the Arduino API to build firmware modules on the host (see
+// scripts/README.md). Time only moves when a host program or a fake device
+// advances hostClockUs, so runs are repeatable.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef __cplusplus
+// LVGL's C sources include this for the tick (LV_TICK_CUSTOM in lv_conf.h);
+// the host program defines hostMillis()
+unsigned long hostMillis(void);
+#define millis() hostMillis()
+#else
+
+inline uint64_t hostClockUs = 0;
+
+inline unsigned long micros() { return (unsigned long)hostClockUs; }
+inline unsigned long millis() { return (unsigned long)(hostClockUs / 1000); }
+inline void delay(unsigned long ms) { hostClockUs += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { hostClockUs += us; }
+
+// Pin interrupts: attach records the handler, and a host program calls
+// hostInterrupt(pin) to fire it
+#define IRAM_ATTR
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+struct HostIsr {
+  void (*fn)(void *);
+  void *arg;
+};
+inline HostIsr hostIsrs[64] = {};
+
+inline int digitalPinToInterrupt(uint8_t pin) { return pin < 64 ? pin : -1; }
+inline void attachInterruptArg(uint8_t pin, void (*fn)(void *), void *arg, int) { hostIsrs[pin] = {fn, arg}; }
+inline void detachInterrupt(uint8_t pin) { hostIsrs[pin] = {}; }
+inline bool hostInterrupt(uint8_t pin) {
+  if (!hostIsrs[pin].fn) return false;
+  hostIsrs[pin].fn(hostIsrs[pin].arg);
+  return true;
+}
+
+class Print {
+public:
+  virtual ~Print() = default;
+  virtual size_t write(uint8_t b) = 0;
+  virtual size_t write(const uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (n < len && write(buf[n])) n++;
+    return n;
+  }
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+  size_t print(const char *s) { return write(s); }
+  size_t println(const char *s = "") { return write(s) + write("\n"); }
+
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3))) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+  }
+};
+
+class Stream : public Print {
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+// stdout
+class HostSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t b) override { return fputc(b, stdout) == EOF ? 0 : 1; }
+  using Print::write;
+};
+
+inline HostSerial Serial;
+
+#endif
@@ -0,0 +1,102 @@
+#pragma once
+
+// SD card backed by a host directory (SD.setRoot()). Every card access
+// advances hostClockUs by a simple SPI card model, so throughput figures from
+// host programs reflect how many commands and bytes a pattern costs:
+// CommandUs per read/write call plus UsPerKB per kilobyte moved, in whole
+// 512-byte sectors as the card transfers them.
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct HostCard {
+  static constexpr uint32_t CommandUs = 250; // command, token wait, CRC
+  static constexpr uint32_t UsPerKB = 450;   // ~20 MHz SPI with gaps
+  uint32_t reads = 0;
+  uint32_t writes = 0;
+  uint64_t bytesRead = 0;
+  uint64_t bytesWritten = 0;
+
+  // Bytes moved for an access of len bytes at pos
+  static uint64_t sectorBytes(size_t pos, size_t len) {
+    return len ? ((uint64_t)(pos + len + 511) / 512 - pos / 512) * 512 : 0;
+  }
+  void charge(uint64_t bytes) { hostClockUs += CommandUs + bytes * UsPerKB / 1024; }
+};
+
+inline HostCard hostCard;
+
+class File : public Print {
+public:
+  File() = default;
+  File(FILE *f, const std::string &path) : fp(f, fclose), path(path) {}
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *buf, size_t len) override {
+    if (!fp) return 0;
+    size_t pos = position();
+    size_t n = fwrite(buf, 1, len, fp.get());
+    fflush(fp.get());
+    uint64_t moved = HostCard::sectorBytes(pos, n);
+    hostCard.writes++;
+    hostCard.bytesWritten += moved;
+    hostCard.charge(moved);
+    return n;
+  }
+  int read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  size_t read(uint8_t *buf, size_t len) {
+    if (!fp) return 0;
+    size_t pos = position();
+    size_t n = fread(buf, 1, len, fp.get());
+    uint64_t moved = HostCard::sectorBytes(pos, n);
+    hostCard.reads++;
+    hostCard.bytesRead += moved;
+    hostCard.charge(moved);
+    return n;
+  }
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) { return fp && fseek(fp.get(), pos, mode) == 0; }
+  size_t position() const { return fp ? (size_t)ftell(fp.get()) : 0; }
+  size_t size() const {
+    struct stat st;
+    return fp && fstat(fileno(fp.get()), &st) == 0 ? (size_t)st.st_size : 0;
+  }
+  void flush() {
+    if (fp) fflush(fp.get());
+  }
+  void close() { fp.reset(); }
+  operator bool() const { return (bool)fp; }
+  const char *name() const { return path.c_str(); }
+
+private:
+  std::shared_ptr<FILE> fp;
+  std::string path;
+};
+
+class SDFS {
+public:
+  void setRoot(const std::string &dir) { root = dir; }
+  bool begin(uint8_t = 5) { return !root.empty(); }
+  bool exists(const char *path) { return access((root + path).c_str(), F_OK) == 0; }
+  bool remove(const char *path) { return unlink((root + path).c_str()) == 0; }
+  File open(const char *path, const char *mode = FILE_READ) {
+    FILE *f = fopen((root + path).c_str(), mode);
+    return f ? File(f, path) : File();
+  }
+
+private:
+  std::string root;
+};
+
+inline SDFS SD;
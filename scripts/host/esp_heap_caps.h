@@ -0,0 +1,11 @@
+#pragma once
+
+// Fixed heap figures for host builds
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+
+inline size_t heap_caps_get_free_size(uint32_t) { return 160 * 1024; }
+inline size_t heap_caps_get_largest_free_block(uint32_t) { return 110 * 1024; }
+inline size_t heap_caps_get_minimum_free_size(uint32_t) { return 150 * 1024; }
@@ -0,0 +1,5 @@
+#pragma once
+
+#include <stdio.h>
+
+#define esp_rom_printf printf
@@ -0,0 +1,23 @@
+#pragma once
+
+// A single "loop" task for host builds
+#include <freertos/FreeRTOS.h>
+#include <string.h>
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return (TaskHandle_t)1; }
+inline TaskHandle_t xTaskGetHandle(const char *name) { return strcmp(name, "loop") == 0 ? (TaskHandle_t)1 : nullptr; }
+inline UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 4096; }
+
+// There is no second task to start: creating one fails, and callers that
+// check for that do the work inline instead
+typedef void (*TaskFunction_t)(void *);
+#define pdTRUE 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *task,
+                                          BaseType_t) {
+  if (task) *task = nullptr;
+  return pdFAIL;
+}
+inline void xTaskNotifyGive(TaskHandle_t) {}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
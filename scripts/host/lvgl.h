@@ -0,0 +1,114 @@
+#pragma once
+
+// The parts of the LVGL 8.3 API used by FileManager, MemoryMonitor and
+// ScreenCapture, for host programs that don't render. The display is a
+// plain struct the program fills in; lv_obj_invalidate_area() only records
+// the area so the program can "render" it.
+
+#include <stdint.h>
+#include <string.h>
+
+typedef uint8_t lv_fs_res_t;
+enum {
+  LV_FS_RES_OK = 0,
+  LV_FS_RES_HW_ERR,
+  LV_FS_RES_FS_ERR,
+  LV_FS_RES_NOT_EX,
+  LV_FS_RES_FULL,
+  LV_FS_RES_LOCKED,
+  LV_FS_RES_DENIED,
+  LV_FS_RES_BUSY,
+  LV_FS_RES_TOUT,
+  LV_FS_RES_NOT_IMP,
+  LV_FS_RES_OUT_OF_MEM,
+  LV_FS_RES_INV_PARAM,
+  LV_FS_RES_UNKNOWN,
+};
+
+typedef uint8_t lv_fs_mode_t;
+enum {
+  LV_FS_MODE_WR = 0x01,
+  LV_FS_MODE_RD = 0x02,
+};
+
+typedef enum {
+  LV_FS_SEEK_SET = 0x00,
+  LV_FS_SEEK_CUR = 0x01,
+  LV_FS_SEEK_END = 0x02,
+} lv_fs_whence_t;
+
+typedef struct _lv_fs_drv_t {
+  char letter;
+  uint16_t cache_size;
+  bool (*ready_cb)(struct _lv_fs_drv_t *drv);
+  void *(*open_cb)(struct _lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+  lv_fs_res_t (*close_cb)(struct _lv_fs_drv_t *drv, void *file_p);
+  lv_fs_res_t (*read_cb)(struct _lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br);
+  lv_fs_res_t (*write_cb)(struct _lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw);
+  lv_fs_res_t (*seek_cb)(struct _lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence);
+  lv_fs_res_t (*tell_cb)(struct _lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+  void *user_data;
+} lv_fs_drv_t;
+
+// The last registered driver, for host programs to call directly
+inline lv_fs_drv_t *hostFsDriver = nullptr;
+
+inline void lv_fs_drv_init(lv_fs_drv_t *drv) { memset(drv, 0, sizeof(*drv)); }
+inline void lv_fs_drv_register(lv_fs_drv_t *drv) { hostFsDriver = drv; }
+
+typedef struct {
+  uint32_t total_size;
+  uint32_t free_cnt;
+  uint32_t free_size;
+  uint32_t free_biggest_size;
+  uint32_t used_cnt;
+  uint32_t max_used;
+  uint8_t used_pct;
+  uint8_t frag_pct;
+} lv_mem_monitor_t;
+
+inline bool lv_is_initialized(void) { return false; }
+inline void lv_mem_monitor(lv_mem_monitor_t *mon) { memset(mon, 0, sizeof(*mon)); }
+
+typedef int16_t lv_coord_t;
+
+typedef struct {
+  lv_coord_t x1;
+  lv_coord_t y1;
+  lv_coord_t x2;
+  lv_coord_t y2;
+} lv_area_t;
+
+// RGB565, LV_COLOR_16_SWAP 0
+typedef union {
+  uint16_t full;
+} lv_color_t;
+
+typedef struct {
+  lv_coord_t hor_res;
+  lv_coord_t ver_res;
+} lv_disp_drv_t;
+
+typedef struct {
+  lv_disp_drv_t *driver;
+  uint16_t inv_p;  // invalidated areas waiting to be drawn
+  lv_area_t inv_areas[32];
+} lv_disp_t;
+
+typedef struct _lv_obj_t lv_obj_t;
+
+inline lv_disp_t *hostDisp = nullptr;
+
+inline lv_disp_t *lv_disp_get_default(void) { return hostDisp; }
+inline lv_obj_t *lv_scr_act(void) { return nullptr; }
+
+inline void lv_area_set(lv_area_t *a, lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2) {
+  a->x1 = x1;
+  a->y1 = y1;
+  a->x2 = x2;
+  a->y2 = y2;
+}
+
+inline void lv_obj_invalidate_area(const lv_obj_t *, const lv_area_t *area) {
+  if (hostDisp && hostDisp->inv_p < 32) hostDisp->inv_areas[hostDisp->inv_p++] = *area;
+}
@@ -0,0 +1,27 @@
+# Sourced by render_test.sh and glyph_bench.sh from the project root: compiles
+# the LVGL that PlatformIO fetched for an environment (PIO_ENV, default
+# jc2432w328r), configured with "template files/lv_conf.h", into
+# .pio/host_lvgl. An LVGL source is only recompiled when it or lv_conf.h is
+# newer than its object. Sets LVGL_FLAGS (compiler flags for code that
+# includes lvgl.h) and LVGL_OBJS.
+
+PIO_ENV="${PIO_ENV:-jc2432w328r}"
+LVGL=".pio/libdeps/$PIO_ENV/lvgl"
+LVGL_OUT=".pio/host_lvgl"
+
+if [ ! -f "$LVGL/lvgl.h" ]; then
+  echo "LVGL not found in $LVGL; run 'pio pkg install -e $PIO_ENV' (or a build) first" >&2
+  exit 2
+fi
+
+# The real LVGL comes before the host shims, which have a render-less lvgl.h
+LVGL_FLAGS=(-O2 -DLV_CONF_INCLUDE_SIMPLE "-I$LVGL" "-Itemplate files" -Iscripts/host)
+mkdir -p "$LVGL_OUT"
+
+find "$LVGL/src" -name '*.c' | while read -r src; do
+  obj="$LVGL_OUT/$(echo "${src#$LVGL/src/}" | tr / _ | sed 's/\.c$/.o/')"
+  if [ ! -f "$obj" ] || [ "$src" -nt "$obj" ] || [ "template files/lv_conf.h" -nt "$obj" ]; then
+    gcc "${LVGL_FLAGS[@]}" -c "$src" -o "$obj"
+  fi
+done
+LVGL_OBJS=("$LVGL_OUT"/*.o)
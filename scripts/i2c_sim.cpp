@@ -0,0 +1,194 @@
+// Host-side test of the I2C bus manager (src/I2CBus.cpp) on a fake bus.
+// FakeBus implements I2CBackend with a 256-byte register file per device and
+// a clock that advances by the time each transaction takes at 400 kHz, and
+// logs every transaction. The scenarios check that queued requests run in
+// priority order (oldest first within a priority), which reads are merged
+// into one transaction, that long reads and missing devices are handled, and
+// that service() stops at its time budget. Exits with status 1 on a failure.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/i2c_sim.cpp src/I2CBus.cpp -o i2c_sim
+//   ./i2c_sim
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "I2CBus.h"
+
+struct Transaction {
+  uint8_t addr;
+  uint8_t reg;
+  size_t len;
+  bool read;
+};
+
+class FakeBus : public I2CBackend {
+public:
+  static constexpr uint32_t SetupUs = 30;   // start, address, stop
+  static constexpr uint32_t ByteUs = 23;    // 9 bits at 400 kHz
+
+  uint32_t clockUs = 0;
+  std::vector<Transaction> log;
+  uint8_t regs[128][256] = {};
+  bool present[128] = {};
+
+  bool begin(int, int, uint32_t) override { return true; }
+
+  uint8_t writeRead(uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen) override {
+    clockUs += SetupUs + (uint32_t)(1 + txLen + rxLen) * ByteUs;
+    log.push_back({addr, tx[0], rx ? rxLen : txLen - 1, rx != nullptr});
+    if (!present[addr]) return 2; // address NACK, as Wire reports it
+    if (rxLen > I2CBus::MaxReadChunk) return 4; // past Wire's receive buffer
+    uint8_t reg = tx[0];
+    for (size_t i = 1; i < txLen; i++) regs[addr][(uint8_t)(reg + i - 1)] = tx[i];
+    for (size_t i = 0; i < rxLen; i++) rx[i] = regs[addr][(uint8_t)(reg + i)];
+    return 0;
+  }
+
+  uint32_t micros() override { return clockUs; }
+};
+
+static FakeBus bus;
+static I2CBus &i2c = I2CBus::getInstance();
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// Records the order requests completed in and whether each succeeded
+struct Completion {
+  int id;
+  bool ok;
+};
+static std::vector<Completion> done;
+
+static void onDone(const I2CBus::Request &, bool ok, void *ctx) {
+  done.push_back({(int)(intptr_t)ctx, ok});
+}
+
+static I2CBus::Request read(int id, uint8_t addr, uint8_t reg, uint8_t *rx, uint8_t len, I2CBus::Priority p) {
+  return {addr, reg, rx, nullptr, len, p, onDone, (void *)(intptr_t)id};
+}
+
+static void reset() {
+  bus.log.clear();
+  done.clear();
+}
+
+static void testPriorityOrder() {
+  reset();
+  uint8_t a[2], b[2], c[2], d[2], e[2];
+  i2c.submit(read(1, 0x40, 0x00, a, 2, I2CBus::PRIORITY_BACKGROUND));
+  i2c.submit(read(2, 0x44, 0x00, b, 2, I2CBus::PRIORITY_SENSOR));
+  i2c.submit(read(3, 0x15, 0x00, c, 2, I2CBus::PRIORITY_TOUCH));
+  i2c.submit(read(4, 0x48, 0x00, d, 2, I2CBus::PRIORITY_SENSOR));
+  i2c.submit(read(5, 0x15, 0x10, e, 2, I2CBus::PRIORITY_TOUCH));
+  i2c.service(100000);
+  std::vector<int> order;
+  for (const Completion &c : done) order.push_back(c.id);
+  check(order == std::vector<int>({3, 5, 2, 4, 1}), "touch, then sensors oldest first, then background");
+  check(!i2c.pending(), "queue drained");
+}
+
+static void testBatching() {
+  reset();
+  for (int i = 0; i < 64; i++) bus.regs[0x44][i] = (uint8_t)(0x80 + i);
+  uint8_t a[2], b[2], c[4], far[2];
+  i2c.submit(read(1, 0x44, 0x00, a, 2, I2CBus::PRIORITY_SENSOR));
+  i2c.submit(read(2, 0x44, 0x02, b, 2, I2CBus::PRIORITY_SENSOR));    // touches a
+  i2c.submit(read(3, 0x44, 0x01, c, 4, I2CBus::PRIORITY_SENSOR));    // overlaps both
+  i2c.submit(read(4, 0x44, 0x20, far, 2, I2CBus::PRIORITY_SENSOR));  // gap: separate
+  i2c.service(100000);
+  check(bus.log.size() == 2 && bus.log[0].reg == 0x00 && bus.log[0].len == 5,
+        "adjacent and overlapping reads merged into one");
+  check(bus.log.size() == 2 && bus.log[1].reg == 0x20 && bus.log[1].len == 2, "read with a gap runs on its own");
+  check(a[0] == 0x80 && a[1] == 0x81 && b[0] == 0x82 && b[1] == 0x83 && c[0] == 0x81 && c[3] == 0x84 &&
+            far[0] == 0xA0,
+        "each merged read gets its own registers");
+
+  // Windows merge only while the combined read fits in MaxBatchBytes
+  reset();
+  uint8_t x[20], y[20];
+  i2c.submit(read(5, 0x44, 0x00, x, 20, I2CBus::PRIORITY_SENSOR));
+  i2c.submit(read(6, 0x44, 0x14, y, 20, I2CBus::PRIORITY_SENSOR));
+  i2c.service(100000);
+  check(bus.log.size() == 2 && x[0] == 0x80 && y[0] == 0x94, "reads over MaxBatchBytes together are not merged");
+
+  // Other devices and writes are never merged
+  reset();
+  uint8_t p[2], q[2];
+  const uint8_t val[1] = {0x55};
+  i2c.submit(read(7, 0x44, 0x00, p, 2, I2CBus::PRIORITY_SENSOR));
+  i2c.submit({0x44, 0x02, nullptr, val, 1, I2CBus::PRIORITY_SENSOR, onDone, (void *)8});
+  i2c.submit(read(9, 0x48, 0x02, q, 2, I2CBus::PRIORITY_SENSOR));
+  i2c.service(100000);
+  check(bus.log.size() == 3 && bus.regs[0x44][0x02] == 0x55, "writes and other devices run separately");
+  const I2CBus::DeviceStats *st = i2c.stats(0x44);
+  check(st && st->batched == 2, "batched counter counts the reads that rode along");
+}
+
+static void testLongReadsAndErrors() {
+  reset();
+  for (int i = 0; i < 256; i++) bus.regs[0x50][i] = (uint8_t)i;
+  // Guard bytes either side catch a read that overruns its buffer
+  uint8_t guarded[4 + 200 + 4];
+  memset(guarded, 0xEE, sizeof(guarded));
+  i2c.submit(read(1, 0x50, 0x10, guarded + 4, 200, I2CBus::PRIORITY_BACKGROUND));
+  uint8_t small[2];
+  i2c.submit(read(2, 0x50, 0x12, small, 2, I2CBus::PRIORITY_BACKGROUND));
+  i2c.service(100000);
+  bool intact = guarded[3] == 0xEE && guarded[204] == 0xEE;
+  check(done.size() == 2 && done[0].ok && guarded[4] == 0x10 && guarded[203] == 0xD7 && intact,
+        "200-byte read lands in its own buffer");
+  check(bus.log.size() == 3 && bus.log[0].reg == 0x10 && bus.log[0].len == 128 && bus.log[1].reg == 0x90 &&
+            bus.log[1].len == 72,
+        "200-byte read split at Wire's 128-byte buffer");
+  check(small[0] == 0x12, "small read next to it still served");
+
+  uint8_t big[64] = {};
+  check(!i2c.submit({0x50, 0x00, nullptr, big, sizeof(big), I2CBus::PRIORITY_SENSOR, onDone, nullptr}),
+        "write longer than MaxBatchBytes rejected by submit()");
+
+  reset();
+  uint8_t r[2];
+  i2c.submit(read(3, 0x77, 0x00, r, 2, I2CBus::PRIORITY_SENSOR)); // nothing at 0x77
+  i2c.service(100000);
+  const I2CBus::DeviceStats *st = i2c.stats(0x77);
+  check(done.size() == 1 && !done[0].ok && st && st->errors == 1, "missing device fails the request and counts");
+}
+
+static void testBudget() {
+  reset();
+  uint8_t rx[8][2];
+  for (int i = 0; i < 8; i++) i2c.submit(read(i, (uint8_t)(0x40 + i), 0x00, rx[i], 2, I2CBus::PRIORITY_BACKGROUND));
+  uint32_t perRead = FakeBus::SetupUs + 4 * FakeBus::ByteUs;
+  i2c.service(perRead * 3 - 1);
+  check(done.size() == 3 && i2c.pending(), "service() stops once the budget is spent");
+  uint32_t start = bus.clockUs;
+  i2c.submit(read(100, 0x15, 0x00, rx[0], 2, I2CBus::PRIORITY_TOUCH));
+  i2c.service(1);
+  check(done.size() == 4 && done.back().id == 100 && bus.clockUs - start == perRead,
+        "a touch read queued later goes next");
+  i2c.service(100000);
+  check(done.size() == 9 && !i2c.pending(), "the rest runs on the next call");
+}
+
+int main() {
+  bus.present[0x15] = bus.present[0x40] = bus.present[0x44] = bus.present[0x48] = bus.present[0x50] = true;
+  for (int i = 0x40; i < 0x48; i++) bus.present[i] = true;
+  i2c.setBackend(&bus);
+  uint8_t early[2];
+  check(!i2c.submit(read(0, 0x40, 0x00, early, 2, I2CBus::PRIORITY_SENSOR)) && !i2c.pending(),
+        "submit() refused before begin()");
+  i2c.begin(21, 22);
+
+  testPriorityOrder();
+  testBatching();
+  testLongReadsAndErrors();
+  testBudget();
+
+  printf("\nbus time %luus, %s\n", (unsigned long)bus.clockUs, failures ? "FAILED" : "all passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Build the id -> format string table for deferred logging (src/DeferredLog.h).
+
+Usage:
+    python scripts/intern_logs.py [--src src] [--out log_strings.json]
+
+Finds every LOG_TRACE/INFO/WARN/ERROR call in the sources, hashes its format
+string exactly as DeferredLog::hash() does (32-bit FNV-1a over the bytes of
+the literal) and writes {"<id>": {"fmt", "level", "file", "line"}} as JSON for
+scripts/telemetry_decode.py --strings. Two different strings with the same id
+fail the build; rewording either one fixes it.
+
+As a PlatformIO pre: script it runs on every build and writes
+$BUILD_DIR/log_strings.json, next to firmware.bin.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+CALL = re.compile(r'\bLOG_(TRACE|INFO|WARN|ERROR)\(\s*((?:"(?:[^"\\\n]|\\.)*"\s*)+)')
+LITERAL = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+ESCAPES = {'n': 10, 't': 9, 'r': 13, 'a': 7, 'b': 8, 'f': 12, 'v': 11, '\\': 92, '"': 34, "'": 39, '?': 63}
+SOURCE_EXT = ('.c', '.cpp', '.h', '.hpp', '.ino')
+
+
+def unescape(s):
+    """Bytes of a C string literal body, as the compiler would store them."""
+    out = bytearray()
+    raw = s.encode('utf-8')
+    i = 0
+    while i < len(raw):
+        c = raw[i]
+        i += 1
+        if c != 0x5C:
+            out.append(c)
+            continue
+        e = chr(raw[i])
+        i += 1
+        if e in ESCAPES:
+            out.append(ESCAPES[e])
+        elif e == 'x':
+            j = i
+            while j < len(raw) and chr(raw[j]) in '0123456789abcdefABCDEF':
+                j += 1
+            out.append(int(raw[i:j], 16) & 0xFF)
+            i = j
+        elif e in '01234567':
+            j = i - 1
+            while j < len(raw) and j < i + 2 and chr(raw[j]) in '01234567':
+                j += 1
+            out.append(int(raw[i - 1:j], 8) & 0xFF)
+            i = j
+        else:
+            raise ValueError('unsupported escape \\%s' % e)
+    return bytes(out)
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def scan(src_dir):
+    table = {}
+    errors = []
+    for root, _, files in os.walk(src_dir):
+        for name in sorted(files):
+            if not name.endswith(SOURCE_EXT):
+                continue
+            path = os.path.join(root, name)
+            with open(path, encoding='utf-8', errors='replace') as f:
+                text = f.read()
+            for m in CALL.finditer(text):
+                fmt = b''.join(unescape(s) for s in LITERAL.findall(m.group(2)))
+                line = text.count('\n', 0, m.start()) + 1
+                rel = os.path.relpath(path, src_dir)
+                key = '%08x' % fnv1a(fmt)
+                entry = {'fmt': fmt.decode('utf-8', errors='replace'), 'level': m.group(1), 'file': rel, 'line': line}
+                prev = table.get(key)
+                if prev is None:
+                    table[key] = entry
+                elif prev['fmt'] != entry['fmt']:
+                    errors.append('%s:%d and %s:%d: format strings share id %s' %
+                                  (prev['file'], prev['line'], rel, line, key))
+    return table, errors
+
+
+def run(src_dir, out_path):
+    table, errors = scan(src_dir)
+    if errors:
+        for e in errors:
+            print('intern_logs: ' + e, file=sys.stderr)
+        return False
+    os.makedirs(os.path.dirname(out_path) or '.', exist_ok=True)
+    with open(out_path, 'w') as f:
+        json.dump(table, f, indent=1, sort_keys=True)
+    print('intern_logs: %d format strings -> %s' % (len(table), out_path))
+    return True
+
+
+try:
+    Import('env')  # noqa: F821 - defined when run by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    if not run(env.subst('$PROJECT_SRC_DIR'), os.path.join(env.subst('$BUILD_DIR'), 'log_strings.json')):
+        env.Exit(1)
+elif __name__ == '__main__':
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('--src', default='src', help='source directory to scan')
+    ap.add_argument('--out', default='log_strings.json')
+    args = ap.parse_args()
+    sys.exit(0 if run(args.src, args.out) else 1)
@@ -0,0 +1,52 @@
+// Host-side simulator for RGB LED effect timelines (src/LedTimeline.h).
+// Prints the duty the LEDC hardware would drive on each channel as CSV, so an
+// effect can be plotted or checked without flashing a board.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/led_timeline_sim.cpp -o led_sim
+//   ./led_sim breathe 0x0000FF 2000 6000 > breathe.csv
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "LedTimeline.h"
+
+static void usage() {
+  fprintf(stderr,
+          "usage: led_sim fade <color> <ms> [total_ms] [step_ms]\n"
+          "       led_sim breathe <color> <period_ms> [total_ms] [step_ms]\n"
+          "       led_sim blink <color> <on_ms> <off_ms> [total_ms] [step_ms]\n");
+}
+
+int main(int argc, char **argv) {
+  if (argc < 4) {
+    usage();
+    return 1;
+  }
+  const char *effect = argv[1];
+  uint32_t color = (uint32_t)strtoul(argv[2], nullptr, 0);
+  led::Timeline tl;
+  int next = 4;
+  if (strcmp(effect, "fade") == 0) {
+    tl = led::Timeline::fade(color, (uint16_t)atoi(argv[3]));
+  } else if (strcmp(effect, "breathe") == 0) {
+    tl = led::Timeline::breathe(color, (uint16_t)atoi(argv[3]));
+  } else if (strcmp(effect, "blink") == 0 && argc >= 5) {
+    tl = led::Timeline::blink(color, (uint16_t)atoi(argv[3]), (uint16_t)atoi(argv[4]));
+    next = 5;
+  } else {
+    usage();
+    return 1;
+  }
+
+  uint32_t total = argc > next ? (uint32_t)atoi(argv[next]) : tl.durationMs() * (tl.loops() ? 3 : 1);
+  uint32_t step = argc > next + 1 ? (uint32_t)atoi(argv[next + 1]) : 10;
+  if (step == 0) step = 1;
+
+  printf("t_ms,red,green,blue\n");
+  for (uint32_t t = 0; t <= total; t += step) {
+    led::Duty d = tl.sample(t, 0x000000);
+    printf("%u,%u,%u,%u\n", t, d.r, d.g, d.b);
+  }
+  return 0;
+}
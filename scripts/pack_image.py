@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Pack an image into the compressed RGB565 asset format read by src/CompressedImage.
+
+Usage:
+    python scripts/pack_image.py icon.png src/ui/img_icon.c [--name img_icon] [--rows-per-strip 8]
+
+Writes a C file declaring `const lv_img_dsc_t <name>` (cf = LV_IMG_CF_RAW) that can
+be passed to lv_img_set_src() once CompressedImage::begin() has run, and prints the
+flash size compared with a raw RGB565 array.
+
+Needs Pillow (pip install pillow).
+"""
+
+import argparse
+import os
+import struct
+import sys
+import time
+
+MAX_PACKET = 128
+
+
+def to_rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def encode_row(pixels):
+    """RLE-code one row: runs of >= 2 equal pixels as repeat packets, the rest as literals."""
+    out = bytearray()
+    i = 0
+    n = len(pixels)
+    literal = []
+
+    def flush_literal():
+        while literal:
+            chunk = literal[:MAX_PACKET]
+            del literal[:MAX_PACKET]
+            out.append(len(chunk) - 1)
+            for px in chunk:
+                out.extend(struct.pack('<H', px))
+
+    while i < n:
+        run = 1
+        while i + run < n and run < MAX_PACKET and pixels[i + run] == pixels[i]:
+            run += 1
+        if run >= 2:
+            flush_literal()
+            out.append(0x80 | (run - 1))
+            out += struct.pack('<H', pixels[i])
+            i += run
+        else:
+            literal.append(pixels[i])
+            i += 1
+    flush_literal()
+    return bytes(out)
+
+
+def decode(blob):
+    """Reference decoder, used to verify the output and time decoding."""
+    w, h = struct.unpack_from('<HH', blob, 4)
+    rows_per_strip = blob[9]
+    data_size = struct.unpack_from('<I', blob, 12)[0]
+    strips = (h + rows_per_strip - 1) // rows_per_strip
+    pos = 16 + strips * 4
+    end = pos + data_size
+    pixels = []
+    for _ in range(h):
+        x = 0
+        while x < w:
+            c = blob[pos]
+            pos += 1
+            n = (c & 0x7F) + 1
+            if c & 0x80:
+                px = struct.unpack_from('<H', blob, pos)[0]
+                pos += 2
+                pixels.extend([px] * n)
+            else:
+                pixels.extend(struct.unpack_from('<%dH' % n, blob, pos))
+                pos += 2 * n
+            x += n
+    assert pos == end, 'decoder consumed %d of %d bytes' % (pos - (end - data_size), data_size)
+    return pixels
+
+
+def pack(pixels, w, h, rows_per_strip):
+    rows = [encode_row(pixels[y * w:(y + 1) * w]) for y in range(h)]
+    strip_offsets = []
+    data = bytearray()
+    for y, row in enumerate(rows):
+        if y % rows_per_strip == 0:
+            strip_offsets.append(len(data))
+        data += row
+    header = b'CYI1' + struct.pack('<HHBBHI', w, h, 0, rows_per_strip, 0, len(data))
+    return header + b''.join(struct.pack('<I', o) for o in strip_offsets) + bytes(data)
+
+
+def write_c(path, name, blob, w, h):
+    lines = []
+    for i in range(0, len(blob), 16):
+        lines.append('    ' + ', '.join('0x%02x' % b for b in blob[i:i + 16]) + ',')
+    with open(path, 'w') as f:
+        f.write('// Generated by scripts/pack_image.py - do not edit\n')
+        f.write('#include <lvgl.h>\n\n')
+        f.write('static const uint8_t %s_data[] = {\n%s\n};\n\n' % (name, '\n'.join(lines)))
+        f.write('const lv_img_dsc_t %s = {\n' % name)
+        f.write('    .header = {.cf = LV_IMG_CF_RAW, .always_zero = 0, .reserved = 0, .w = %d, .h = %d},\n' % (w, h))
+        f.write('    .data_size = sizeof(%s_data),\n' % name)
+        f.write('    .data = %s_data,\n};\n' % name)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('image')
+    ap.add_argument('output')
+    ap.add_argument('--name', help='C symbol name (default: output file name)')
+    ap.add_argument('--rows-per-strip', type=int, default=8, help='rows between seek index entries (1-255)')
+    args = ap.parse_args()
+
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit('pack_image.py needs Pillow: pip install pillow')
+
+    img = Image.open(args.image).convert('RGB')
+    w, h = img.size
+    if w > 2047 or h > 2047:
+        sys.exit('image too large for an LVGL image header (max 2047x2047)')
+    rows_per_strip = max(1, min(255, args.rows_per_strip))
+    pixels = [to_rgb565(*p) for p in img.getdata()]
+
+    blob = pack(pixels, w, h, rows_per_strip)
+    start = time.perf_counter()
+    if decode(blob) != pixels:
+        sys.exit('round trip failed')
+    decode_ms = (time.perf_counter() - start) * 1000
+
+    name = args.name or os.path.splitext(os.path.basename(args.output))[0]
+    write_c(args.output, name, blob, w, h)
+
+    raw = w * h * 2
+    print('%s: %dx%d, raw RGB565 %d B -> packed %d B (%.1f%%), host decode %.1f ms'
+          % (name, w, h, raw, len(blob), 100.0 * len(blob) / raw, decode_ms))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,371 @@
+// Host-side render regression test for the UI. Runs the real LVGL (from
+// PlatformIO's libdeps, with "template files/lv_conf.h") headless into a
+// memory framebuffer, puts MainInterface and the other screens through fixed
+// scenarios (no reading yet, normal values, NaN, out-of-range and infinite
+// values, text too long for its readout, a trend chart with gaps) and for
+// each one:
+// - compares the whole frame against scripts/render_refs/<scenario>.png,
+//   allowing a per-channel difference and a small share of differing pixels
+// - records the bytes the display driver would have flushed for the update
+//   and the best-of-N time for a full redraw, and checks them against
+//   scripts/render_refs/baseline.txt
+// Exits with status 1 on a mismatch or regression and writes the actual frame
+// and a diff image to render_out/. --update rewrites the references and the
+// baseline from the current build instead.
+//
+// Build and run from the project root, after a PlatformIO build has fetched
+// LVGL into .pio/libdeps (needs libpng):
+//   scripts/render_test.sh [--update] [--time-tolerance 25] [--pixel-tolerance 16] [--max-diff 0.5]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Arduino.h>
+#include <png.h>
+#include <sys/stat.h>
+#include <lvgl.h>
+#include "GlyphCache.h"
+#include "MainInterface.h"
+#include "SensorManager.h"
+#include "TrendChart.h"
+
+// Same resolution and draw buffer as TemplateCode
+static constexpr lv_coord_t Width = 320;
+static constexpr lv_coord_t Height = 240;
+static lv_color_t drawBuf[Width * Height / 10];
+static uint16_t frame[Width * Height];
+
+static constexpr int TimingRuns = 20;
+static const char *RefDir = "scripts/render_refs";
+static const char *OutDir = "render_out";
+
+// lv_conf.h takes the tick from millis() (see scripts/host/Arduino.h); a
+// host clock that stands still keeps animations and timers out of the frames
+extern "C" unsigned long hostMillis(void) {
+  return millis();
+}
+
+// TrendChart::poll() is linked in through MainInterface but never called:
+// no sensor history is attached here, the chart scenario feeds samples directly
+bool SensorManager::sampleAt(uint32_t, Sample &) const {
+  return false;
+}
+
+struct FlushCount {
+  uint32_t flushes;
+  uint64_t bytes;
+};
+static FlushCount flushed;
+
+static void flushFrame(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *px) {
+  lv_coord_t w = area->x2 - area->x1 + 1;
+  for (lv_coord_t y = area->y1; y <= area->y2; y++) {
+    memcpy(&frame[y * Width + area->x1], px + (y - area->y1) * w, w * sizeof(lv_color_t));
+  }
+  flushed.flushes++;
+  flushed.bytes += (uint64_t)w * (area->y2 - area->y1 + 1) * sizeof(lv_color_t);
+  lv_disp_flush_ready(drv);
+}
+
+static uint64_t nowUs() {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------
+// Scenarios. Each one changes the UI from the state the previous one left, so
+// the bytes flushed are those of that update, as on the device.
+
+static MainInterface ui;
+static GlyphCache bigGlyphs;
+static GlyphReadout longValue;
+static GlyphReadout fallbackValue;
+static TrendChart chart;
+static lv_obj_t *mainScreen = nullptr;
+
+static void boot() {
+  ui.init();
+  mainScreen = lv_scr_act();
+}
+
+static void normalValues() {
+  ui.setTemperature(21.5f);
+  ui.setHumidity(48.2f);
+}
+
+static void missingValues() {
+  ui.setTemperature(NAN);
+  ui.setHumidity(NAN);
+}
+
+static void outOfRange() {
+  ui.setTemperature(-1234.5f);
+  ui.setHumidity(250.0f);
+}
+
+static void infinite() {
+  ui.setTemperature(INFINITY);
+  ui.setHumidity(-INFINITY);
+}
+
+// Readouts are clipped to their width, and text the glyph cache doesn't cover
+// falls back to label rendering
+static void longText() {
+  lv_obj_t *scr = lv_obj_create(NULL);
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x000000), LV_PART_MAIN);
+  bigGlyphs.build(&lv_font_montserrat_28, lv_color_hex(0xFFFFFF), lv_color_hex(0x000000));
+  lv_obj_align(longValue.create(scr, bigGlyphs, 200), LV_ALIGN_TOP_MID, 0, 40);
+  longValue.setText("-888888888.8°C");
+  lv_obj_align(fallbackValue.create(scr, bigGlyphs, 200), LV_ALIGN_TOP_MID, 0, 100);
+  fallbackValue.setText("Sensor error!");
+  lv_scr_load(scr);
+}
+
+static void trendChart() {
+  lv_obj_t *scr = lv_obj_create(NULL);
+  lv_obj_set_style_bg_color(scr, lv_color_hex(0x000000), LV_PART_MAIN);
+  lv_obj_clear_flag(scr, LV_OBJ_FLAG_SCROLLABLE);
+  lv_obj_align(chart.create(scr), LV_ALIGN_TOP_MID, 0, 40);
+  chart.setSeries(0, lv_color_hex(0xFF8C00), 0.0f, 50.0f);
+  chart.setSeries(1, lv_color_hex(0x1E90FF), 0.0f, 100.0f);
+  for (int i = 0; i < 900; i++) {
+    // Out of range at the ends, a gap in the middle
+    float t = 25.0f + 30.0f * sinf(i / 60.0f);
+    float h = 50.0f + 20.0f * cosf(i / 45.0f);
+    bool gap = i >= 400 && i < 440;
+    float v[TrendChart::MaxSeries] = {gap ? NAN : t, gap ? NAN : h};
+    chart.addSample(v);
+  }
+  lv_scr_load(scr);
+}
+
+static void backToMain() {
+  lv_scr_load(mainScreen);
+  ui.setTemperature(22.0f);
+  ui.setHumidity(47.9f);
+}
+
+struct Scenario {
+  const char *name;
+  void (*apply)();
+};
+
+static const Scenario scenarios[] = {
+    {"boot", boot},
+    {"normal", normalValues},
+    {"nan", missingValues},
+    {"out_of_range", outOfRange},
+    {"infinite", infinite},
+    {"long_text", longText},
+    {"trend_chart", trendChart},
+    {"back_to_main", backToMain},
+};
+
+// ---------------------------------------------------------------------------
+// Reference images and baseline
+
+static void toRgb(std::vector<uint8_t> &rgb) {
+  rgb.resize((size_t)Width * Height * 3);
+  for (size_t i = 0; i < (size_t)Width * Height; i++) {
+    uint16_t c = frame[i];
+    rgb[i * 3 + 0] = ((c >> 11) & 0x1F) * 255 / 31;
+    rgb[i * 3 + 1] = ((c >> 5) & 0x3F) * 255 / 63;
+    rgb[i * 3 + 2] = (c & 0x1F) * 255 / 31;
+  }
+}
+
+static bool writePng(const std::string &path, const std::vector<uint8_t> &rgb) {
+  png_image img;
+  memset(&img, 0, sizeof(img));
+  img.version = PNG_IMAGE_VERSION;
+  img.width = Width;
+  img.height = Height;
+  img.format = PNG_FORMAT_RGB;
+  return png_image_write_to_file(&img, path.c_str(), 0, rgb.data(), 0, nullptr) != 0;
+}
+
+static bool readPng(const std::string &path, std::vector<uint8_t> &rgb) {
+  png_image img;
+  memset(&img, 0, sizeof(img));
+  img.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&img, path.c_str())) return false;
+  img.format = PNG_FORMAT_RGB;
+  if (img.width != (png_uint_32)Width || img.height != (png_uint_32)Height) {
+    png_image_free(&img);
+    return false;
+  }
+  rgb.resize(PNG_IMAGE_SIZE(img));
+  return png_image_finish_read(&img, nullptr, rgb.data(), 0, nullptr) != 0;
+}
+
+struct Baseline {
+  std::string name;
+  uint64_t bytes;
+  uint32_t flushes;
+  uint64_t renderUs;
+};
+
+static std::vector<Baseline> loadBaseline() {
+  std::vector<Baseline> out;
+  FILE *f = fopen((std::string(RefDir) + "/baseline.txt").c_str(), "r");
+  if (!f) return out;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char name[64];
+    unsigned long long bytes, us;
+    unsigned flushes;
+    if (line[0] == '#' || sscanf(line, "%63s %llu %u %llu", name, &bytes, &flushes, &us) != 4) continue;
+    out.push_back({name, bytes, flushes, us});
+  }
+  fclose(f);
+  return out;
+}
+
+static void saveBaseline(const std::vector<Baseline> &rows) {
+  FILE *f = fopen((std::string(RefDir) + "/baseline.txt").c_str(), "w");
+  if (!f) return;
+  fprintf(f, "# scenario bytes_flushed flushes full_redraw_us (written by render_test --update)\n");
+  for (const Baseline &b : rows) {
+    fprintf(f, "%s %llu %u %llu\n", b.name.c_str(), (unsigned long long)b.bytes, b.flushes,
+            (unsigned long long)b.renderUs);
+  }
+  fclose(f);
+}
+
+// Pixels whose channels differ by more than `tolerance`; also writes a diff
+// image (differences in red over the dimmed frame)
+static size_t comparePixels(const std::vector<uint8_t> &ref, const std::vector<uint8_t> &rgb, int tolerance,
+                            std::vector<uint8_t> &diff) {
+  size_t count = 0;
+  diff.resize(rgb.size());
+  for (size_t i = 0; i < rgb.size(); i += 3) {
+    bool differs = false;
+    for (int c = 0; c < 3; c++) differs |= abs((int)ref[i + c] - (int)rgb[i + c]) > tolerance;
+    count += differs;
+    diff[i + 0] = differs ? 255 : rgb[i + 0] / 4;
+    diff[i + 1] = differs ? 0 : rgb[i + 1] / 4;
+    diff[i + 2] = differs ? 0 : rgb[i + 2] / 4;
+  }
+  return count;
+}
+
+// ---------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+  bool update = false;
+  double timeTolerance = 25;  // % slower than the baseline before failing
+  int pixelTolerance = 16;    // per 8-bit channel
+  double maxDiff = 0.5;       // % of pixels allowed over the tolerance
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--update")) {
+      update = true;
+    } else if (!strcmp(argv[i], "--time-tolerance") && i + 1 < argc) {
+      timeTolerance = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--pixel-tolerance") && i + 1 < argc) {
+      pixelTolerance = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--max-diff") && i + 1 < argc) {
+      maxDiff = atof(argv[++i]);
+    } else {
+      fprintf(stderr, "usage: %s [--update] [--time-tolerance %%] [--pixel-tolerance n] [--max-diff %%]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // Without references every scenario would fail; say what is missing instead
+  std::vector<Baseline> baseline = loadBaseline();
+  if (!update && baseline.empty()) {
+    fprintf(stderr, "no references in %s/; run with --update against the LVGL the firmware builds with, check the "
+                    "frames in %s/ and commit them\n", RefDir, RefDir);
+    return 2;
+  }
+
+  lv_init();
+  static lv_disp_draw_buf_t drawBufDsc;
+  lv_disp_draw_buf_init(&drawBufDsc, drawBuf, nullptr, Width * Height / 10);
+  static lv_disp_drv_t drv;
+  lv_disp_drv_init(&drv);
+  drv.hor_res = Width;
+  drv.ver_res = Height;
+  drv.flush_cb = flushFrame;
+  drv.draw_buf = &drawBufDsc;
+  lv_disp_drv_register(&drv);
+
+  mkdir(OutDir, 0755);
+  if (update) mkdir(RefDir, 0755);
+  std::vector<Baseline> measured;
+  int failures = 0;
+
+  printf("%-14s %8s %8s %10s %10s %9s  %s\n", "scenario", "flushes", "bytes", "redraw us", "base us", "diff px",
+         "result");
+  for (const Scenario &s : scenarios) {
+    s.apply();
+    flushed = {};
+    lv_refr_now(NULL);
+    FlushCount step = flushed;
+
+    // Full redraws of the same state for a stable render time
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < TimingRuns; i++) {
+      lv_obj_invalidate(lv_scr_act());
+      uint64_t t0 = nowUs();
+      lv_refr_now(NULL);
+      best = std::min(best, nowUs() - t0);
+    }
+    measured.push_back({s.name, step.bytes, step.flushes, best});
+
+    std::vector<uint8_t> rgb;
+    toRgb(rgb);
+    std::string refPath = std::string(RefDir) + "/" + s.name + ".png";
+    if (update) {
+      bool ok = writePng(refPath, rgb);
+      printf("%-14s %8u %8llu %10llu %10s %9s  %s\n", s.name, step.flushes, (unsigned long long)step.bytes,
+             (unsigned long long)best, "-", "-", ok ? "reference written" : "FAIL: can't write reference");
+      failures += !ok;
+      continue;
+    }
+
+    std::string result;
+    std::vector<uint8_t> ref, diff;
+    size_t differing = 0;
+    if (!readPng(refPath, ref)) {
+      result = "FAIL: no reference (run with --update)";
+    } else {
+      differing = comparePixels(ref, rgb, pixelTolerance, diff);
+      if (differing * 100.0 > maxDiff * Width * Height) {
+        result = "FAIL: image";
+        writePng(std::string(OutDir) + "/" + s.name + "_diff.png", diff);
+      }
+    }
+
+    const Baseline *base = nullptr;
+    for (const Baseline &b : baseline) {
+      if (b.name == s.name) base = &b;
+    }
+    if (!base) {
+      result += result.empty() ? "FAIL: no baseline (run with --update)" : ", no baseline";
+    } else {
+      // The flushed areas are deterministic, so any growth is a regression
+      if (step.bytes > base->bytes) result += result.empty() ? "FAIL: bytes" : ", bytes";
+      if (best > base->renderUs * (100 + timeTolerance) / 100) result += result.empty() ? "FAIL: time" : ", time";
+    }
+    if (!result.empty()) {
+      failures++;
+      writePng(std::string(OutDir) + "/" + s.name + ".png", rgb);
+    }
+    printf("%-14s %8u %8llu %10llu %10llu %9zu  %s\n", s.name, step.flushes, (unsigned long long)step.bytes,
+           (unsigned long long)best, base ? (unsigned long long)base->renderUs : 0ULL, differing,
+           result.empty() ? "ok" : result.c_str());
+  }
+
+  if (update) {
+    saveBaseline(measured);
+  } else if (failures) {
+    printf("\n%d scenario(s) failed; actual frames and diffs are in %s/\n", failures, OutDir);
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,15 @@
+#!/bin/bash
+# Builds and runs the host render test (scripts/render_test.cpp) against the
+# LVGL that PlatformIO fetched (see host_lvgl.sh). Arguments are passed on to
+# the test. Needs gcc, g++ and libpng.
+set -eo pipefail
+
+cd "$(dirname "$0")/.."
+source scripts/host_lvgl.sh
+
+g++ -std=gnu++17 -DARDUINO "${LVGL_FLAGS[@]}" -Isrc \
+  scripts/render_test.cpp src/MainInterface.cpp src/GlyphCache.cpp src/TrendChart.cpp \
+  src/MemoryMonitor.cpp src/EventBus.cpp src/StaticAlloc.cpp \
+  "${LVGL_OBJS[@]}" -lpng -lm -o "$LVGL_OUT/render_test"
+
+"$LVGL_OUT/render_test" "$@"
@@ -0,0 +1,135 @@
+// Host-side simulation of loop(): an LVGL refresh every frame period plus the
+// PeriodicScheduler tasks, on a virtual clock. Prints how many frames started
+// late with the scheduler running every due task back to back (the old
+// behaviour), with the time budget, with the budget plus per-task slack, and
+// with slack set but switched off by setSlackEnabled(false) (the tasks stay
+// on their interval grid), along with how often the loop had to wake up, so
+// budget, cost and slack settings can be tried without a board.
+//
+// The tasks are added 7 ms apart so they don't start in phase. This moved the
+// baselines from when the stagger was added: at a 20 ms frame, unbudgeted
+// late frames went from 110 to 148 and budgeted from 42 to 33. Timing each
+// task from when it starts rather than from the top of update() then moved
+// unbudgeted to 154: tasks run back to back each land a little later.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/scheduler_sim.cpp src/PeriodicScheduler.cpp -o sched_sim
+//   ./sched_sim [seconds] [frame_ms] [render_ms] [budget_ms] [tolerance_ms]
+//
+// The 25 ms DHT read can't fit between two frames at all, so it shows up as
+// one late frame per read in both runs.
+
+#include <cstdio>
+#include <cstdlib>
+#include "PeriodicScheduler.h"
+
+static uint64_t simUs = 0;
+unsigned long millis() { return (unsigned long)(simUs / 1000); }
+unsigned long micros() { return (unsigned long)simUs; }
+
+static void work(uint32_t us) { simUs += us; }
+
+struct Result {
+  uint32_t wakeups = 0;
+  uint32_t avoided = 0;
+  uint32_t frames = 0;
+  uint32_t misses = 0;
+  uint64_t maxLateUs = 0;
+  uint64_t totalLateUs = 0;
+  uint32_t taskRuns = 0;
+};
+
+enum SlackMode { SLACK_NONE, SLACK_ON, SLACK_OFF };
+
+static Result simulate(bool budgeted, SlackMode slack, uint32_t seconds, uint32_t frameMs, uint32_t renderMs, uint32_t budgetMs,
+                       uint32_t toleranceMs) {
+  simUs = 0;
+  Result r;
+  PeriodicScheduler sched;
+  // Same mix as main.cpp, plus the kind of background work a full build adds
+  struct Spec {
+    const char *name;
+    uint32_t interval;
+    uint32_t costUs;
+    PeriodicScheduler::Priority prio;
+    uint32_t slackMs;
+  } specs[] = {
+      {"ui", 100, 800, PeriodicScheduler::PRIORITY_HIGH, 50},
+      {"sensors", 2000, 25000, PeriodicScheduler::PRIORITY_NORMAL, 500},
+      {"sd-log", 250, 6000, PeriodicScheduler::PRIORITY_NORMAL, 100},
+      {"telemetry", 500, 8000, PeriodicScheduler::PRIORITY_LOW, 250},
+      {"chart", 1000, 7000, PeriodicScheduler::PRIORITY_NORMAL, 200},
+      {"report", 10000, 5000, PeriodicScheduler::PRIORITY_LOW, 5000},
+  };
+  for (const Spec &s : specs) {
+    uint32_t cost = s.costUs;
+    uint32_t *runs = &r.taskRuns;
+    int id = sched.addTask([cost, runs]() { work(cost); (*runs)++; }, s.interval, s.name, s.prio, cost);
+    if (slack != SLACK_NONE) sched.setSlack(id, s.slackMs);
+    // Start the tasks 7 ms apart, out of phase as they are after a while on a
+    // real loop. Without this they would all start on the same millisecond,
+    // so every run would already see them in phase.
+    simUs += 7000;
+  }
+  sched.setSlackEnabled(slack != SLACK_OFF);
+  sched.setBudget(budgeted ? budgetMs * 1000 : 0);
+
+  uint64_t end = (uint64_t)seconds * 1000000;
+  uint64_t nextFrame = 0;
+  while (simUs < end) {
+    // templateCode.update(): LVGL refresh when due
+    if (simUs >= nextFrame) {
+      uint64_t late = simUs - nextFrame;
+      r.frames++;
+      r.totalLateUs += late;
+      if (late > r.maxLateUs) r.maxLateUs = late;
+      if (late > (uint64_t)toleranceMs * 1000) r.misses++;
+      nextFrame = simUs + (uint64_t)frameMs * 1000;
+      work(renderMs * 1000);
+    }
+    uint32_t lvglDueUs = nextFrame > simUs ? (uint32_t)(nextFrame - simUs) : 0;
+
+    uint64_t before = simUs;
+    if (budgeted) {
+      sched.update(millis(), lvglDueUs);
+    } else {
+      sched.update(millis());
+    }
+    if (simUs != before) continue;
+
+    // Nothing ran: sleep until the next frame or task, like runLoop.waitFor()
+    uint64_t wake = nextFrame;
+    uint32_t taskDue = sched.msUntilNextDue(millis());
+    if (taskDue != UINT32_MAX) {
+      uint64_t t = (millis() + (uint64_t)taskDue) * 1000;
+      if (t < wake) wake = t;
+    }
+    if (wake > simUs) r.wakeups++;
+    simUs = wake > simUs ? wake : simUs + 100;
+  }
+  r.avoided = sched.wakeupsAvoided();
+  return r;
+}
+
+static void print(const char *label, const Result &r, uint32_t seconds) {
+  printf("%-10s frames=%u late=%u (%.1f%%) late avg=%.2fms max=%.2fms task runs=%u wakeups/s=%.1f avoided=%u\n",
+         label, r.frames, r.misses, r.frames ? 100.0 * r.misses / r.frames : 0.0,
+         r.frames ? r.totalLateUs / 1000.0 / r.frames : 0.0, r.maxLateUs / 1000.0, r.taskRuns,
+         (double)r.wakeups / seconds, r.avoided);
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = argc > 1 ? atoi(argv[1]) : 60;
+  uint32_t frameMs = argc > 2 ? atoi(argv[2]) : 20;
+  uint32_t renderMs = argc > 3 ? atoi(argv[3]) : 8;
+  uint32_t budgetMs = argc > 4 ? atoi(argv[4]) : 5;
+  uint32_t toleranceMs = argc > 5 ? atoi(argv[5]) : 2;
+
+  printf("%us, frame every %ums (render %ums), budget %ums, late = more than %ums after due\n", seconds, frameMs,
+         renderMs, budgetMs, toleranceMs);
+  print("unbudgeted", simulate(false, SLACK_NONE, seconds, frameMs, renderMs, budgetMs, toleranceMs), seconds);
+  print("budgeted", simulate(true, SLACK_NONE, seconds, frameMs, renderMs, budgetMs, toleranceMs), seconds);
+  print("+slack", simulate(true, SLACK_ON, seconds, frameMs, renderMs, budgetMs, toleranceMs), seconds);
+  print("slack off", simulate(true, SLACK_OFF, seconds, frameMs, renderMs, budgetMs, toleranceMs), seconds);
+  return 0;
+}
@@ -0,0 +1,122 @@
+// Host-side test of the hardware scroll bookkeeping (src/ScrollRegion.h)
+// that TemplateCode uses for the ST7789's VSCRDEF/VSCSAD scrolling. A fake
+// panel keeps one content id per frame memory row and shows the rows the
+// way the controller does from the start row alone. A rolling log is
+// scrolled by random amounts, and after each scroll only the rows
+// exposed() reports are redrawn, as invalidateExposed() would. It checks
+// that the glass then shows the right line on every row, that rows outside
+// the region never move, and that the touch mapping is the inverse of the
+// drawing one. Exits with status 1 on a failure.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/scroll_sim.cpp -o scroll_sim
+//   ./scroll_sim [scrolls]
+
+#include <cstdio>
+#include <cstdlib>
+#include "ScrollRegion.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+static constexpr uint16_t PanelRows = 320;
+static constexpr uint16_t Top = 20;
+static constexpr uint16_t Rows = 280;
+static constexpr int32_t Fixed = -1; // content of rows outside the region
+
+// Frame memory contents, one id per row
+static int32_t memory[PanelRows];
+
+// What the controller shows on glass row y: the scroll area starts at the
+// VSCSAD row and wraps within the area, the fixed areas map straight through
+static int32_t shown(const ScrollRegion &s, uint16_t y) {
+  if (y < s.top() || y >= s.top() + s.rows()) return memory[y];
+  uint16_t m = s.top() + (s.startRow() - s.top() + (y - s.top())) % s.rows();
+  return memory[m];
+}
+
+static void testSet() {
+  ScrollRegion s;
+  check(!s.set(0, 0, PanelRows), "set: refuses an empty region");
+  check(!s.set(100, 221, PanelRows), "set: refuses a region past the last row");
+  check(!s.set(0, 320, 240), "set: refuses 320 rows on a 240-row display");
+  check(s.set(Top, Rows, PanelRows) && s.active() && s.startRow() == Top, "set: accepts rows 20-299, start at the top");
+  s.clear();
+  check(!s.active() && s.screenToMemory(150) == 150, "clear: identity mapping again");
+}
+
+static void testRollingLog(uint32_t scrolls) {
+  ScrollRegion s;
+  s.set(Top, Rows, PanelRows);
+  // Glass row y of the region shows log line pos + (y - Top)
+  int32_t pos = 0;
+  for (uint16_t y = 0; y < PanelRows; y++) memory[y] = (y >= Top && y < Top + Rows) ? y - Top : Fixed;
+
+  srand(1);
+  uint32_t wrong = 0, fixedMoved = 0, redrawn = 0, wrapped = 0;
+  for (uint32_t i = 0; i < scrolls; i++) {
+    // Mostly small steps either way, now and then more than the region
+    int16_t lines = rand() % 20 == 0 ? (int16_t)(rand() % 700 - 350) : (int16_t)(rand() % 25 - 12);
+    s.scrollBy(lines);
+    pos += lines;
+
+    ScrollRegion::Span spans[2];
+    uint8_t n = s.exposed(spans);
+    if (n == 2) wrapped++;
+    for (uint8_t k = 0; k < n; k++) {
+      for (uint16_t m = spans[k].first; m < spans[k].first + spans[k].count; m++) {
+        memory[m] = pos + (s.memoryToScreen(m) - Top);
+        redrawn++;
+      }
+    }
+
+    for (uint16_t y = 0; y < PanelRows; y++) {
+      bool inRegion = y >= Top && y < Top + Rows;
+      if (inRegion && shown(s, y) != pos + (y - Top)) wrong++;
+      if (!inRegion && shown(s, y) != Fixed) fixedMoved++;
+    }
+  }
+  printf("%u scrolls, %u rows redrawn (%.1f per scroll), %u exposed runs wrapped\n", scrolls, redrawn,
+         scrolls ? (double)redrawn / scrolls : 0.0, wrapped);
+  check(wrong == 0, "log: every row shows its line after redrawing exposed()");
+  check(fixedMoved == 0, "log: rows outside the region never move");
+  check(wrapped > 0, "log: exposed runs that wrap were exercised");
+
+  bool inverse = true;
+  for (int32_t y = 0; y < PanelRows; y++) {
+    if (s.screenToMemory(s.memoryToScreen(y)) != y || s.memoryToScreen(s.screenToMemory(y)) != y) inverse = false;
+  }
+  check(inverse, "touch: screenToMemory() inverts memoryToScreen()");
+}
+
+static void testExposed() {
+  ScrollRegion s;
+  s.set(Top, Rows, PanelRows);
+  ScrollRegion::Span spans[2];
+  check(s.exposed(spans) == 0, "exposed: nothing before the first scroll");
+  s.scrollBy(10);
+  check(s.exposed(spans) == 1 && spans[0].first == Top && spans[0].count == 10,
+        "exposed: up 10 redraws the 10 rows that left the top");
+  s.scrollBy(-4);
+  check(s.exposed(spans) == 1 && spans[0].first == Top + 6 && spans[0].count == 4, "exposed: down 4 is the 4 rows now on top");
+  s.scrollBy(1000);
+  uint8_t n = s.exposed(spans);
+  uint32_t total = 0;
+  for (uint8_t k = 0; k < n; k++) total += spans[k].count;
+  check(total == Rows, "exposed: scrolling past the region redraws all of it");
+}
+
+int main(int argc, char **argv) {
+  uint32_t scrolls = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000;
+
+  testSet();
+  testExposed();
+  testRollingLog(scrolls);
+
+  printf("\n%s\n", failures ? "FAILED" : "all passed");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,474 @@
+// Host-side test of the shared serial port: src/Telemetry.cpp,
+// src/ScreenCapture.cpp and src/LogSink.cpp write to one fake UART, driven the
+// way loop() drives them, while a fake screen changes every refresh and log
+// lines and long report lines are queued. The UART has the ESP32's 128-byte
+// TX FIFO and drains at a set number of bytes per ms of a virtual clock. Log
+// writes block on a full FIFO as HardwareSerial::write() does, draining it
+// while they wait. Every byte that leaves it is checked:
+// - the stream must split cleanly into telemetry frames (0x00, COBS, 0x00),
+//   capture packets (A5 5A ...), each with a good CRC, and whole log lines;
+//   a byte belonging to none means one stream was spliced into another
+// - every telemetry frame that wasn't dropped on the device must arrive
+// - every log line must arrive whole and in order
+// - the screen rebuilt from the capture packets must match the fake screen
+// Exits with status 1 on a failure.
+//
+// --out writes the bytes to a file for scripts/telemetry_decode.py --input
+// and scripts/capture_to_png.py --input. --pty runs in real time on a pseudo
+// terminal instead: capture starts when a host tool sends 'C', as on the
+// device (e.g. capture_to_png.py --port /dev/pts/N).
+//
+// Build and run from the project root:
+//   g++ -std=gnu++17 -DARDUINO -Iscripts/host -Isrc scripts/serial_sim.cpp src/Telemetry.cpp src/ScreenCapture.cpp
+//       src/LogSink.cpp -o serial_sim
+//   ./serial_sim 20 11.5 --out session.bin    # seconds, bytes per ms (115200 baud)
+//   ./serial_sim 60 11.5 --pty
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <Arduino.h>
+#include "Crc.h"
+#include "LogSink.h"
+#include "ReportPrint.h"
+#include "ScreenCapture.h"
+#include "Telemetry.h"
+
+static constexpr lv_coord_t Width = 320;
+static constexpr lv_coord_t Height = 240;
+static constexpr lv_coord_t BandRows = 24;   // TemplateCode's draw buffer is Width x Height / 10
+static constexpr uint32_t RefreshMs = 30;    // LV_DISP_DEF_REFR_PERIOD
+
+// UART with a hardware TX FIFO that empties at a fixed byte rate
+class HostUart : public Stream {
+public:
+  static constexpr size_t FifoSize = 128;
+
+  std::vector<uint8_t> wire; // everything that has left the FIFO
+  std::deque<uint8_t> rx;    // host commands
+  int fd = -1;               // copy of the output: file or pty
+
+  explicit HostUart(double bytesPerMs) : rate(bytesPerMs) {}
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *buf, size_t len) override {
+    size_t n = std::min(len, FifoSize - fifo.size());
+    fifo.insert(fifo.end(), buf, buf + n);
+    return n;
+  }
+  using Print::write;
+  int availableForWrite() override { return (int)(FifoSize - fifo.size()); }
+  int available() override { return (int)rx.size(); }
+  int read() override {
+    if (rx.empty()) return -1;
+    int c = rx.front();
+    rx.pop_front();
+    return c;
+  }
+
+  void tick(uint32_t us) {
+    credit += rate * us / 1000.0;
+    size_t n = std::min(fifo.size(), (size_t)credit);
+    credit -= n;
+    if (fifo.empty()) credit = 0; // an idle line doesn't save up
+    std::vector<uint8_t> out(fifo.begin(), fifo.begin() + n);
+    fifo.erase(fifo.begin(), fifo.begin() + n);
+    wire.insert(wire.end(), out.begin(), out.end());
+    // A pty nobody is reading fills up; those bytes are only lost to the reader
+    if (fd >= 0 && n > 0 && ::write(fd, out.data(), n) < 0 && errno != EAGAIN) fd = -1;
+  }
+  bool idle() const { return fifo.empty(); }
+
+private:
+  std::deque<uint8_t> fifo;
+  double rate;
+  double credit = 0;
+};
+
+// LogSink's view of the UART: writes wait for room in the FIFO
+class BlockingPort : public Print {
+public:
+  explicit BlockingPort(HostUart &u) : uart(u) {}
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t *buf, size_t len) override {
+    size_t left = len;
+    while (left > 0) {
+      size_t n = uart.write(buf, left);
+      buf += n;
+      left -= n;
+      if (left > 0) uart.tick(100);
+    }
+    return len;
+  }
+
+private:
+  HostUart &uart;
+};
+
+// ---------------------------------------------------------------------------
+// Fake screen: a banded background, a box that moves four times a second and
+// a status strip that changes twice a second. Changed areas are flushed in draw-buffer bands and
+// teed into the capture, as TemplateCode::flushDisplay() does.
+
+static uint16_t screen[Height][Width];
+static lv_disp_drv_t dispDrv = {Width, Height};
+static lv_disp_t disp = {&dispDrv, 0, {}};
+static lv_coord_t boxX = 10, boxY = 40, boxDx = 2, boxDy = 1;
+static constexpr lv_coord_t Box = 24;
+
+static uint16_t background(lv_coord_t x, lv_coord_t y) {
+  return (uint16_t)(((y / 8) << 11) | ((x / 64) << 5));
+}
+
+static void paint(const lv_area_t &a, uint32_t now) {
+  for (lv_coord_t y = a.y1; y <= a.y2; y++) {
+    for (lv_coord_t x = a.x1; x <= a.x2; x++) {
+      uint16_t c = background(x, y);
+      if (y < 24) c = ((x / 8 + now / 500) % 2) ? 0xFFFF : 0x0000;
+      if (x >= boxX && x < boxX + Box && y >= boxY && y < boxY + Box) c = (uint16_t)(0xF800 + now / RefreshMs);
+      screen[y][x] = c;
+    }
+  }
+}
+
+static void invalidate(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2) {
+  lv_area_t a;
+  lv_area_set(&a, x1, y1, x2, y2);
+  lv_obj_invalidate_area(nullptr, &a);
+}
+
+static uint32_t flushedBytes = 0;
+
+// Redraws every invalidated area; returns the bytes "sent to the panel"
+static uint32_t refresh(uint32_t now) {
+  static std::vector<lv_color_t> buf(Width * BandRows);
+  uint32_t bytes = 0;
+  for (uint16_t i = 0; i < disp.inv_p; i++) {
+    lv_area_t a = disp.inv_areas[i];
+    a.x1 = std::max<lv_coord_t>(a.x1, 0);
+    a.y1 = std::max<lv_coord_t>(a.y1, 0);
+    a.x2 = std::min<lv_coord_t>(a.x2, Width - 1);
+    a.y2 = std::min<lv_coord_t>(a.y2, Height - 1);
+    paint(a, now);
+    for (lv_coord_t y = a.y1; y <= a.y2; y += BandRows) {
+      lv_area_t band = {a.x1, y, a.x2, std::min<lv_coord_t>(y + BandRows - 1, a.y2)};
+      lv_coord_t w = band.x2 - band.x1 + 1;
+      for (lv_coord_t r = band.y1; r <= band.y2; r++) {
+        for (lv_coord_t x = 0; x < w; x++) buf[(r - band.y1) * w + x].full = screen[r][band.x1 + x];
+      }
+      ScreenCapture::getInstance().tee(&band, buf.data());
+      bytes += w * (band.y2 - band.y1 + 1) * 2;
+    }
+  }
+  disp.inv_p = 0;
+  flushedBytes += bytes;
+  return bytes;
+}
+
+static void animate(uint32_t now) {
+  if (now % 240 >= RefreshMs) return;
+  invalidate(boxX, boxY, boxX + Box - 1, boxY + Box - 1);
+  boxX += boxDx;
+  boxY += boxDy;
+  if (boxX < 0 || boxX + Box > Width) boxDx = -boxDx, boxX += 2 * boxDx;
+  if (boxY < 24 || boxY + Box > Height) boxDy = -boxDy, boxY += 2 * boxDy;
+  invalidate(boxX, boxY, boxX + Box - 1, boxY + Box - 1);
+  if (now % 500 < RefreshMs) invalidate(0, 0, Width - 1, 23);
+}
+
+// ---------------------------------------------------------------------------
+// Checking the stream
+
+struct StreamCheck {
+  uint32_t frames[Telemetry::SchemaCount] = {};
+  uint32_t badFrames = 0;
+  uint32_t packets = 0;
+  uint32_t badPackets = 0;
+  uint32_t seqGaps = 0;
+  uint32_t textLines = 0;
+  uint32_t badText = 0;
+  uint32_t stray = 0;
+  size_t firstStray = SIZE_MAX;
+  uint64_t telemetryBytes = 0;
+  uint64_t captureBytes = 0;
+  uint64_t textBytes = 0;
+  std::vector<uint16_t> canvas = std::vector<uint16_t>(Width * Height, 0);
+};
+
+static bool cobsDecode(const uint8_t *in, size_t len, std::vector<uint8_t> &out) {
+  out.clear();
+  size_t i = 0;
+  while (i < len) {
+    uint8_t code = in[i++];
+    if (code == 0 || i + code - 1 > len) return false;
+    out.insert(out.end(), in + i, in + i + code - 1);
+    i += code - 1;
+    if (code < 0xFF && i < len) out.push_back(0);
+  }
+  return true;
+}
+
+static void decodeRow(StreamCheck &c, const uint8_t *p, size_t len) {
+  uint16_t x = p[0] | p[1] << 8, y = p[2] | p[3] << 8, w = p[4] | p[5] << 8;
+  auto set = [&](uint16_t n, size_t at) {
+    if (y < Height && x + n < Width) c.canvas[y * Width + x + n] = p[at] | p[at + 1] << 8;
+  };
+  size_t i = 6;
+  uint16_t n = 0;
+  while (i < len && n < w) {
+    uint8_t code = p[i++];
+    uint16_t count = (code & 0x7F) + 1;
+    if (code & 0x80) {
+      for (uint16_t k = 0; k < count; k++) set(n++, i);
+      i += 2;
+    } else {
+      for (uint16_t k = 0; k < count; k++, i += 2) set(n++, i);
+    }
+  }
+}
+
+// Every log line the sim queues starts with this
+static const char LogPrefix[] = "[log] line ";
+
+static bool textAt(const std::vector<uint8_t> &s, size_t i) {
+  size_t n = sizeof(LogPrefix) - 1;
+  return i + n <= s.size() && memcmp(&s[i], LogPrefix, n) == 0;
+}
+
+static StreamCheck checkStream(const std::vector<uint8_t> &s) {
+  StreamCheck c;
+  std::vector<uint8_t> raw;
+  int expectSeq = -1;
+  uint32_t expectLine = 0;
+  size_t i = 0;
+  while (i < s.size()) {
+    if (textAt(s, i)) {
+      // One line: the prefix, its number, then printable text up to '\n'
+      size_t k = i;
+      while (k < s.size() && s[k] != '\n') k++;
+      if (k == s.size()) break;
+      bool printable = true;
+      for (size_t p = i; p < k; p++) printable &= s[p] >= 0x20 && s[p] < 0x7F;
+      unsigned long n = strtoul((const char *)&s[i] + sizeof(LogPrefix) - 1, nullptr, 10);
+      if (printable && n == expectLine) c.textLines++;
+      else c.badText++;
+      expectLine = n + 1;
+      c.textBytes += k + 1 - i;
+      i = k + 1;
+    } else if (s[i] == 0xA5 && i + 1 < s.size() && s[i + 1] == 0x5A) {
+      if (i + 6 > s.size()) break;
+      size_t len = s[i + 4] | s[i + 5] << 8;
+      if (i + 8 + len > s.size()) break; // cut off at the end of the run
+      uint16_t crc = crc16(&s[i + 2], 4 + len);
+      if (crc != (s[i + 6 + len] | s[i + 7 + len] << 8)) {
+        c.badPackets++;
+        i++;
+        continue;
+      }
+      uint8_t type = s[i + 2], seq = s[i + 3];
+      if (expectSeq >= 0 && seq != expectSeq) c.seqGaps++;
+      expectSeq = (seq + 1) & 0xFF;
+      if (type == 'R') decodeRow(c, &s[i + 6], len);
+      c.packets++;
+      c.captureBytes += 8 + len;
+      i += 8 + len;
+    } else if (s[i] == 0) {
+      // Delimiter; a frame follows unless another delimiter or a packet does
+      size_t j = i + 1;
+      if (j >= s.size() || s[j] == 0 || (s[j] == 0xA5 && j + 1 < s.size() && s[j + 1] == 0x5A) || textAt(s, j)) {
+        c.telemetryBytes++;
+        i = j;
+        continue;
+      }
+      size_t k = j;
+      while (k < s.size() && s[k] != 0) k++;
+      if (k == s.size()) break;
+      if (!cobsDecode(&s[j], k - j, raw) || raw.size() < 8 ||
+          crc16(raw.data(), raw.size() - 2) != (raw[raw.size() - 2] | raw[raw.size() - 1] << 8) ||
+          raw[0] >= Telemetry::SchemaCount) {
+        c.badFrames++;
+      } else {
+        c.frames[raw[0]]++;
+      }
+      c.telemetryBytes += k - i;
+      i = k;
+    } else {
+      if (c.firstStray == SIZE_MAX) c.firstStray = i;
+      c.stray++;
+      i++;
+    }
+  }
+  return c;
+}
+
+// ---------------------------------------------------------------------------
+
+static int openPty(char *name, size_t len) {
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) || unlockpt(master) || ptsname_r(master, name, len)) return -1;
+  // Raw mode, so the line discipline passes every byte through unchanged
+  int slave = open(name, O_RDWR | O_NOCTTY);
+  termios tio;
+  tcgetattr(slave, &tio);
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  // Kept open so writes don't fail before a host tool has opened the port
+  (void)slave;
+  fcntl(master, F_SETFL, O_NONBLOCK);
+  return master;
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = argc > 1 ? atoi(argv[1]) : 20;
+  double rate = argc > 2 ? atof(argv[2]) : 11.5;
+  bool pty = false;
+  const char *outPath = nullptr;
+  for (int i = 3; i < argc; i++) {
+    if (!strcmp(argv[i], "--pty")) pty = true;
+    if (!strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+  }
+
+  HostUart uart(rate);
+  if (pty) {
+    char name[64];
+    uart.fd = openPty(name, sizeof(name));
+    if (uart.fd < 0) {
+      perror("pty");
+      return 1;
+    }
+    printf("device on %s, running for %lus\n", name, (unsigned long)seconds);
+    fflush(stdout);
+  } else if (outPath) {
+    uart.fd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  }
+
+  hostDisp = &disp;
+  ScreenCapture &capture = ScreenCapture::getInstance();
+  Telemetry &telemetry = Telemetry::getInstance();
+  capture.begin(uart);
+  telemetry.begin(uart);
+  BlockingPort logPort(uart);
+  LogSink &log = LogSink::getInstance();
+  log.begin(logPort, LogSink::LEVEL_INFO);
+  uint32_t logLines = 0;
+  char pad[200];
+  memset(pad, '=', sizeof(pad) - 1);
+  pad[sizeof(pad) - 1] = 0;
+  paint({0, 0, Width - 1, Height - 1}, 0);
+  if (!pty) uart.rx.push_back('C');
+
+  // Run, then stop changing the screen and sending telemetry and let
+  // everything queued drain, with one more frame marker for the final screen
+  uint32_t runMs = seconds * 1000;
+  uint32_t lastRefresh = 0;
+  uint32_t sensorSeq = 0;
+  for (uint32_t ms = 1;; ms++) {
+    hostClockUs = (uint64_t)ms * 1000;
+    bool running = ms <= runMs;
+    if (pty) {
+      uint8_t in[64];
+      ssize_t n = ::read(uart.fd, in, sizeof(in));
+      for (ssize_t k = 0; k < n; k++) uart.rx.push_back(in[k]);
+      usleep(1000);
+    }
+
+    if (ms - lastRefresh >= RefreshMs) {
+      lastRefresh = ms;
+      if (running) animate(ms);
+      uint32_t bytes = refresh(ms);
+      if (running && bytes) telemetry.send(Telemetry::SCHEMA_FRAME, Telemetry::PRIORITY_LOW,
+                                           Telemetry::FrameBody{(uint16_t)(8 + bytes / 20000), bytes});
+    }
+    if (running && ms % 2000 == 0) {
+      Telemetry::SensorBody body = {(int16_t)(215 + sensorSeq % 7), (int16_t)(480 - sensorSeq % 5)};
+      sensorSeq++;
+      telemetry.send(Telemetry::SCHEMA_SENSOR, Telemetry::PRIORITY_HIGH, body);
+    }
+    if (running && ms % 5000 == 0) {
+      for (uint8_t t = 0; t < 8; t++) {
+        Telemetry::TaskBody body = {t, ms / 100, 0, 0, 120u + t, 900u + t, 2};
+        telemetry.send(Telemetry::SCHEMA_TASK, Telemetry::PRIORITY_NORMAL, body);
+      }
+    }
+    if (running && ms % 10000 == 0) {
+      Telemetry::MemoryBody body = {150000, 100000, 140000, 40, 5, 900, 0, 0};
+      telemetry.send(Telemetry::SCHEMA_MEMORY, Telemetry::PRIORITY_NORMAL, body);
+    }
+
+    // Log lines of varying length, and now and then a report line longer
+    // than LogSink::MaxLine that goes out in pieces
+    if (running && ms % 250 == 0) {
+      log.log(LogSink::LEVEL_INFO, "%s%lu %.*s", LogPrefix, (unsigned long)logLines, (int)(logLines * 37 % 90), pad);
+      logLines++;
+    }
+    if (running && ms % 3000 == 0) {
+      reportf(log.printer(), "%s%lu report %s\n", LogPrefix, (unsigned long)logLines, pad);
+      logLines++;
+    }
+
+    // Same order as loop(); the log task runs alongside, modelled as a pass
+    // of its writer every ms
+    capture.service(ms);
+    telemetry.service();
+    log.flush(1);
+    uart.tick(1000);
+
+    bool drained = !capture.txPending() && !telemetry.txPending() && !log.pending() &&
+                   uart.idle() && disp.inv_p == 0;
+    if (!running && drained && ms > runMs + 1000) break;
+  }
+
+  StreamCheck c = checkStream(uart.wire);
+  const Telemetry::Stats &ts = telemetry.stats();
+  const ScreenCapture::Stats &cs = capture.stats();
+  uint32_t sent = ts.sent[0] + ts.sent[1] + ts.sent[2];
+  uint32_t received = 0;
+  for (uint32_t n : c.frames) received += n;
+  uint32_t mismatched = 0;
+  for (int y = 0; y < Height; y++) {
+    for (int x = 0; x < Width; x++) mismatched += c.canvas[y * Width + x] != screen[y][x];
+  }
+
+  double secs = hostClockUs / 1e6;
+  printf("%.1fs at %.1f bytes/ms: %zu bytes on the wire (%.0f%% of the line), telemetry %llu B, capture %llu B\n",
+         secs, rate, uart.wire.size(), uart.wire.size() * 100.0 / (rate * secs * 1000),
+         (unsigned long long)c.telemetryBytes, (unsigned long long)c.captureBytes);
+  printf("telemetry: queued %lu, dropped %lu/%lu/%lu, received %lu (sensor %lu task %lu frame %lu memory %lu), bad %lu\n",
+         (unsigned long)sent, (unsigned long)ts.dropped[0], (unsigned long)ts.dropped[1], (unsigned long)ts.dropped[2],
+         (unsigned long)received, (unsigned long)c.frames[Telemetry::SCHEMA_SENSOR],
+         (unsigned long)c.frames[Telemetry::SCHEMA_TASK], (unsigned long)c.frames[Telemetry::SCHEMA_FRAME],
+         (unsigned long)c.frames[Telemetry::SCHEMA_MEMORY], (unsigned long)c.badFrames);
+  printf("capture: %lu packets, %lu frames, %lu keyframes, %lu overflows, bad %lu, seq gaps %lu, screen pixels wrong %lu\n",
+         (unsigned long)c.packets, (unsigned long)cs.frames, (unsigned long)cs.keyframes, (unsigned long)cs.overflows,
+         (unsigned long)c.badPackets, (unsigned long)c.seqGaps, (unsigned long)mismatched);
+  if (c.stray) printf("stray bytes: %lu, first at offset %zu\n", (unsigned long)c.stray, c.firstStray);
+
+  const LogSink::Stats &ls = log.stats();
+  printf("log: queued %lu lines, %lu pieces, %lu B, overflows %lu, received %lu whole, bad %lu\n",
+         (unsigned long)logLines, (unsigned long)ls.lines, (unsigned long)c.textBytes, (unsigned long)ls.overflows,
+         (unsigned long)c.textLines, (unsigned long)c.badText);
+
+  int failures = 0;
+  auto check = [&](bool ok, const char *what) {
+    printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+  };
+  check(c.stray == 0 && c.badFrames == 0 && c.badPackets == 0, "stream splits into whole frames and packets");
+  check(received == sent, "every queued telemetry frame arrived");
+  check(c.seqGaps == 0, "no capture packets missing");
+  check(c.textLines == logLines && c.badText == 0 && ls.overflows == 0, "every log line arrived whole and in order");
+  if (capture.active()) {
+    check(mismatched == 0, "screen rebuilt from the capture matches");
+  } else {
+    printf("capture %s, screen not compared\n", cs.keyframes ? "was stopped by the host" : "was never started");
+  }
+  return failures ? 1 : 0;
+}
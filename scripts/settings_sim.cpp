@@ -0,0 +1,136 @@
+// Host-side test of the settings store (src/SettingsStore.h) on
+// MemorySettingsBackend. It checks the stored blob (magic, version, size,
+// CRC) and that a damaged, truncated or other-version blob falls back to the
+// defaults, and that a slider drag of many set() calls ends in a single write
+// once the settings have been quiet for quietMs. Exits with status 1 on a
+// failure.
+//
+// Build and run from the project root:
+//   g++ -std=c++17 -Isrc scripts/settings_sim.cpp -o settings_sim
+//   ./settings_sim
+
+#include <cstdio>
+#include <cstring>
+#include "SettingsStore.h"
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  printf("%-56s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// Same layout as the template's settings
+struct Settings {
+  int32_t travelDistance;
+  uint32_t maxSpeed;
+  uint16_t acceleration;
+};
+
+static const Settings Defaults{0, 200000, 500};
+static constexpr uint32_t QuietMs = 2000;
+
+using Store = SettingsStore<Settings, 1>;
+using StoreV2 = SettingsStore<Settings, 2>;
+
+// Blob layout: magic, version, size, data, CRC32 over everything before it
+static constexpr size_t VersionAt = 4;
+static constexpr size_t DataAt = 8;
+
+static uint32_t storedWord(const MemorySettingsBackend &mem, size_t at) {
+  uint32_t v;
+  memcpy(&v, mem.blob + at, sizeof(v));
+  return v;
+}
+
+static void testBlob() {
+  MemorySettingsBackend mem;
+  Store s(mem, Defaults, QuietMs);
+  check(!s.begin() && s.get().maxSpeed == 200000 && s.stats().loadErrors == 1, "blob: empty backend gives the defaults");
+
+  s.set(&Settings::maxSpeed, 12345u);
+  check(s.commit() && mem.writes == 1, "blob: commit() writes once");
+  uint16_t version, size;
+  memcpy(&version, mem.blob + VersionAt, 2);
+  memcpy(&size, mem.blob + VersionAt + 2, 2);
+  check(storedWord(mem, 0) == 0x53544731 && version == 1 && size == sizeof(Settings), "blob: magic, version and size stored");
+  check(storedWord(mem, mem.stored - 4) == crc32(mem.blob, mem.stored - 4), "blob: CRC32 covers the header and data");
+  check(s.commit() && mem.writes == 1, "blob: commit() with nothing dirty writes nothing");
+
+  Store back(mem, Defaults, QuietMs);
+  check(back.begin() && back.get().maxSpeed == 12345 && back.get().acceleration == 500, "blob: read back in one load");
+}
+
+// Stores a good blob, lets `damage` change it and checks the load is rejected
+template <typename Damage>
+static void rejects(const char *what, Damage damage) {
+  MemorySettingsBackend mem;
+  Store s(mem, Defaults, QuietMs);
+  s.begin();
+  s.set(&Settings::acceleration, (uint16_t)900);
+  s.commit();
+  damage(mem);
+  Store back(mem, Defaults, QuietMs);
+  check(!back.begin() && back.get().acceleration == 500 && back.stats().loadErrors == 1 && !back.dirty(), what);
+}
+
+static void testRejected() {
+  rejects("load: bad magic gives the defaults", [](MemorySettingsBackend &m) { m.blob[0] ^= 1; });
+  rejects("load: flipped data bit fails the CRC", [](MemorySettingsBackend &m) { m.blob[DataAt + 4] ^= 0x10; });
+  rejects("load: truncated blob gives the defaults", [](MemorySettingsBackend &m) { m.stored -= 1; });
+  rejects("load: other size gives the defaults", [](MemorySettingsBackend &m) {
+    m.blob[VersionAt + 2] += 2;
+    uint32_t crc = crc32(m.blob, m.stored - 4);
+    memcpy(m.blob + m.stored - 4, &crc, 4);
+  });
+
+  // A blob from an older layout is ignored even with a good CRC
+  MemorySettingsBackend mem;
+  Store v1(mem, Defaults, QuietMs);
+  v1.begin();
+  v1.set(&Settings::acceleration, (uint16_t)900);
+  v1.commit();
+  StoreV2 v2(mem, Defaults, QuietMs);
+  check(!v2.begin() && v2.get().acceleration == 500, "load: version 1 blob ignored by version 2");
+}
+
+static void testCoalesced() {
+  MemorySettingsBackend mem;
+  Store s(mem, Defaults, QuietMs);
+  s.begin();
+  Store::hostClock = 1000;
+
+  // A slider drag: a new value every 20 ms for 2 s
+  for (uint32_t v = 1; v <= 100; v++) {
+    s.set(&Settings::maxSpeed, v * 1000);
+    Store::hostClock += 20;
+    s.update();
+  }
+  check(mem.writes == 0 && s.dirty() && s.stats().sets == 100, "coalesce: nothing written while the slider moves");
+
+  s.set(&Settings::maxSpeed, 100000u);
+  check(s.stats().unchanged == 1, "coalesce: setting the stored value is not a change");
+
+  Store::hostClock += QuietMs - 21;
+  s.update();
+  check(mem.writes == 0, "coalesce: still waiting just before the quiet period");
+  Store::hostClock += 1;
+  s.update();
+  s.update();
+  check(mem.writes == 1 && !s.dirty() && s.stats().commits == 1, "coalesce: one write once the slider is left alone");
+
+  Store back(mem, Defaults, QuietMs);
+  check(back.begin() && back.get().maxSpeed == 100000, "coalesce: the last value was written");
+
+  s.set(&Settings::acceleration, (uint16_t)700);
+  check((s.dirtyFields() & 1) == 0 && s.dirtyFields() != 0, "coalesce: only the changed field is marked dirty");
+}
+
+int main() {
+  testBlob();
+  testRejected();
+  testCoalesced();
+
+  printf("\n%s\n", failures ? "FAILED" : "all passed");
+  return failures ? 1 : 0;
+}
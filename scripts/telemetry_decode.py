@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""Decode the binary telemetry stream of src/Telemetry into CSV files.
+
+Usage:
+    python scripts/telemetry_decode.py --port /dev/ttyUSB0 [--baud 115200] [--out telemetry]
+    python scripts/telemetry_decode.py --input session.bin [--out telemetry]
+
+Writes one CSV per message type (telemetry/sensor.csv, task.csv, frame.csv,
+memory.csv), flushing every row so the files can be followed while the
+device runs.
+Deferred log records (LOG_DEFERRED builds) are expanded with the format
+strings from --strings (log_strings.json in the build directory, written by
+scripts/intern_logs.py), printed to stdout and appended to telemetry/log.txt;
+the summary compares their size with the same lines sent as text.
+Text printed on the same port (logs, reports) is passed through to stderr
+with --text, and screen capture packets (scripts/capture_to_png.py) are
+skipped. Lost messages (gaps in the per-type sequence numbers) and
+frames with a bad CRC are counted and printed on exit. --raw saves the
+received bytes so a session can be replayed later with --input.
+
+Needs pyserial for --port (pip install pyserial).
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import struct
+import sys
+
+# Must match the Schema enum and the packed bodies in src/Telemetry.h
+SCHEMAS = {
+    1: ('sensor', '<hh', ['temp_c', 'humidity']),
+    2: ('task', '<BIIIIII', ['task', 'runs', 'overruns', 'deferrals', 'exec_mean_us', 'exec_max_us',
+                             'jitter_max_ms']),
+    3: ('frame', '<HI', ['render_ms', 'bytes_flushed']),
+    4: ('log', None, None),  # variable length, see Decoder._log()
+    5: ('memory', '<IIIBBHiB', ['free_heap', 'largest_block', 'min_free_heap', 'lvgl_used_pct', 'lvgl_frag_pct',
+                                'min_stack_free', 'trend_bytes_per_min', 'alarms']),
+}
+NO_VALUE = -32768
+CAPTURE_SYNC = b'\xA5\x5A'  # src/ScreenCapture packets on the same port
+
+# printf conversions; the length modifier doesn't matter for the wire format
+CONVERSION = re.compile(r'%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(?:hh|h|ll|l|j|z|t|L)?([diouxXcpeEfFgGaAs%])')
+
+
+def crc16(data, crc=0xFFFF):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Inverse of Telemetry::cobsEncode(); None if the block lengths don't fit."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def read_varint(data, i):
+    v = shift = 0
+    while True:
+        b = data[i]
+        i += 1
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return v, i
+
+
+def read_int(data, i):
+    v, i = read_varint(data, i)
+    return (v >> 1) ^ -(v & 1), i
+
+
+def expand(fmt, data):
+    """Format one DeferredLog record's arguments like printf would."""
+    i = 0
+    out = []
+    pos = 0
+    for m in CONVERSION.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, conv = m.groups()
+        if conv == '%':
+            out.append('%')
+            continue
+        if width == '*':
+            width, i = read_int(data, i)
+        if prec == '*':
+            prec, i = read_int(data, i)
+        spec = '%' + flags + (str(width) if width is not None else '') + \
+            ('.' + str(prec) if prec is not None else '')
+        if conv in 'eEfFgG':
+            v = struct.unpack_from('<f', data, i)[0]
+            i += 4
+            out.append((spec + conv) % v)
+        elif conv in 'aA':
+            v = struct.unpack_from('<f', data, i)[0]
+            i += 4
+            out.append(float(v).hex())
+        elif conv == 's':
+            n = data[i]
+            v = data[i + 1:i + 1 + n].decode('utf-8', errors='replace')
+            i += 1 + n
+            out.append((spec + 's') % v)
+        elif conv == 'p':
+            v, i = read_int(data, i)
+            out.append('0x%x' % v)
+        else:
+            v, i = read_int(data, i)
+            if conv in 'ouxX' and v < 0:
+                v &= 0xFFFFFFFF
+            out.append((spec + ('d' if conv == 'u' else conv)) % v)
+    out.append(fmt[pos:])
+    return ''.join(out)
+
+
+def tenths(v):
+    return '' if v == NO_VALUE else '%.1f' % (v / 10.0)
+
+
+class Decoder:
+    def __init__(self, out_dir, text=None, strings=None):
+        self.buf = bytearray()
+        self.out_dir = out_dir
+        self.text = text
+        self.strings = strings or {}
+        self.log_file = None
+        self.log_bytes = 0       # SCHEMA_LOG frames as sent, delimiters included
+        self.log_text_bytes = 0  # the same lines as text
+        self.unknown_ids = 0
+        self.files = {}
+        self.writers = {}
+        self.last_seq = {}
+        self.counts = {name: 0 for name, _, _ in SCHEMAS.values()}
+        self.lost = {name: 0 for name, _, _ in SCHEMAS.values()}
+        self.bad_frames = 0
+        self.capture_packets = 0
+        os.makedirs(out_dir, exist_ok=True)
+
+    def feed(self, data):
+        self.buf += data
+        while True:
+            if self.buf.startswith(CAPTURE_SYNC):
+                # ScreenCapture packets only start between frames; skip whole ones
+                if len(self.buf) < 6:
+                    return
+                (length,) = struct.unpack_from('<H', self.buf, 4)
+                total = 6 + length + 2
+                if len(self.buf) < total:
+                    return
+                if crc16(self.buf[2:6 + length]) == struct.unpack_from('<H', self.buf, 6 + length)[0]:
+                    del self.buf[:total]
+                    self.capture_packets += 1
+                    continue
+            # Log lines end in a newline and may run straight into a capture
+            # packet, so they are taken off a line at a time
+            line = self._text_line()
+            if line is not None:
+                del self.buf[:len(line)]
+                self._not_a_frame(line)
+                continue
+            end = self.buf.find(b'\x00')
+            if end < 0:
+                return
+            chunk = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if chunk:
+                self._chunk(chunk)
+
+    def _chunk(self, chunk):
+        raw = cobs_decode(chunk)
+        if raw is None or len(raw) < 8 or crc16(raw[:-2]) != struct.unpack_from('<H', raw, len(raw) - 2)[0]:
+            self._not_a_frame(chunk)
+            return
+        schema, seq, ms = struct.unpack_from('<BBI', raw)
+        body = raw[6:-2]
+        if schema not in SCHEMAS:
+            self.bad_frames += 1
+            return
+        name, fmt, fields = SCHEMAS[schema]
+        if fmt is not None and len(body) != struct.calcsize(fmt):
+            self.bad_frames += 1
+            return
+
+        prev = self.last_seq.get(schema)
+        gap = (seq - prev - 1) & 0xFF if prev is not None else 0
+        if gap >= 0x80:
+            # An older frame arriving late: a log warning sent at high priority
+            # overtook it, and it was counted as lost when the warning arrived
+            self.lost[name] = max(self.lost[name] - 1, 0)
+        else:
+            self.lost[name] += gap
+            self.last_seq[schema] = seq
+        self.counts[name] += 1
+
+        if fmt is None:
+            self.log_bytes += len(chunk) + 2
+            self._log(ms, body)
+            return
+        values = list(struct.unpack(fmt, body))
+        if name == 'sensor':
+            values = [tenths(v) for v in values]
+        self._writer(name, fields).writerow([ms] + values)
+        self.files[name].flush()
+
+    def _log(self, ms, body):
+        # A frame holds one or more records: u8 length, u32 id, arguments
+        i = 0
+        while i + 5 <= len(body):
+            n = body[i]
+            if n < 5 or i + n > len(body):
+                self.bad_frames += 1
+                return
+            rec_id = '%08x' % struct.unpack_from('<I', body, i + 1)[0]
+            entry = self.strings.get(rec_id)
+            if entry is None:
+                self.unknown_ids += 1
+                line = '<unknown log id %s: %s>' % (rec_id, body[i + 5:i + n].hex())
+            else:
+                try:
+                    line = expand(entry['fmt'], body[i + 5:i + n])
+                except (IndexError, struct.error, TypeError, ValueError):
+                    line = '<bad arguments for "%s">' % entry['fmt']
+                self.log_text_bytes += len(line.encode('utf-8')) + 1
+            i += n
+            if self.log_file is None:
+                self.log_file = open(os.path.join(self.out_dir, 'log.txt'), 'a')
+            self.log_file.write('%d %s\n' % (ms, line))
+            self.log_file.flush()
+            print(line)
+
+    def _text_line(self):
+        # A whole line of text at the front of the buffer, or None. Frame
+        # bytes start after a delimiter and are almost never all printable.
+        if self.buf.startswith(b'\x00'):
+            return None
+        nl = self.buf.find(b'\n')
+        if nl < 0:
+            return None
+        line = bytes(self.buf[:nl + 1])
+        if any(b < 0x20 and b not in (9, 10, 13) for b in line):
+            return None
+        try:
+            line.decode('utf-8')
+        except UnicodeDecodeError:
+            return None
+        return line
+
+    def _not_a_frame(self, chunk):
+        # Text between frames fails the CRC; anything else is a damaged frame
+        try:
+            s = chunk.decode('utf-8')
+        except UnicodeDecodeError:
+            self.bad_frames += 1
+            return
+        if self.text:
+            self.text.write(s)
+            self.text.flush()
+
+    def _writer(self, name, fields):
+        if name not in self.writers:
+            f = open(os.path.join(self.out_dir, name + '.csv'), 'w', newline='')
+            w = csv.writer(f)
+            w.writerow(['ms'] + fields)
+            self.files[name] = f
+            self.writers[name] = w
+        return self.writers[name]
+
+    def close(self):
+        for f in self.files.values():
+            f.close()
+        if self.log_file:
+            self.log_file.close()
+
+    def summary(self):
+        parts = ['%s=%d (lost %d)' % (n, self.counts[n], self.lost[n]) for n in self.counts]
+        s = ' '.join(parts) + ' bad=%d' % self.bad_frames
+        if self.capture_packets:
+            s += ' capture_packets=%d' % self.capture_packets
+        if self.log_bytes:
+            s += '\nlog: %d bytes sent for %d bytes of text (%.1fx)' % (
+                self.log_bytes, self.log_text_bytes, self.log_text_bytes / self.log_bytes)
+            if self.unknown_ids:
+                s += ', %d records with unknown ids (stale --strings?)' % self.unknown_ids
+        return s
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument('--port', help='serial port of the device')
+    src.add_argument('--input', help='replay a file saved with --raw')
+    ap.add_argument('--baud', type=int, default=115200)
+    ap.add_argument('--out', default='telemetry', help='directory for the CSV files')
+    ap.add_argument('--raw', help='also save the received bytes to this file')
+    ap.add_argument('--text', action='store_true', help='pass text output through to stderr')
+    ap.add_argument('--strings', help='log_strings.json from the firmware build, for deferred logs')
+    args = ap.parse_args()
+
+    strings = None
+    if args.strings:
+        with open(args.strings) as f:
+            strings = json.load(f)
+    dec = Decoder(args.out, sys.stderr if args.text else None, strings)
+    raw = open(args.raw, 'wb') if args.raw else None
+    try:
+        if args.input:
+            with open(args.input, 'rb') as f:
+                dec.feed(f.read())
+        else:
+            import serial
+            with serial.Serial(args.port, args.baud, timeout=0.1) as ser:
+                while True:
+                    data = ser.read(4096)
+                    if not data:
+                        continue
+                    if raw:
+                        raw.write(data)
+                    dec.feed(data)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        dec.close()
+        if raw:
+            raw.close()
+        print(dec.summary(), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
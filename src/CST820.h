@@ -3,10 +3,14 @@
 #ifndef CST820_H
 #define CST820_H
 
-#include <Wire.h>
+#include <Arduino.h>
+#include "I2CBus.h"
+#include "Coroutine.h"
 
 // ====== CST820 Capacitive Touchscreen Driver ======
-// Handles initialization and I2C-based touch reading for CST820
+// Handles initialization and I2C-based touch reading for CST820.
+// Bus access goes through the shared I2CBus so touch reads are never queued
+// behind other I2C devices.
 
 class CST820
 {
@@ -15,48 +19,43 @@ public:
   CST820(uint8_t sda, uint8_t scl, uint8_t rst, uint8_t irq)
       : _sda(sda), _scl(scl), _rst(rst), _irq(irq) {}
 
-  // Initialize the touch controller
-  void begin()
+  // Initialize the touch controller. The reset sequence runs as a coroutine,
+  // so this returns straight away; getTouch() reports no touch until ready().
+  // Returns false if no coroutine slot was free.
+  bool begin()
   {
-    // Reset sequence for CST820
-    pinMode(_rst, OUTPUT);
-    digitalWrite(_rst, LOW);  // Hold reset low
-    delay(10);                // Wait a moment
-    digitalWrite(_rst, HIGH); // Release reset
-    delay(100);               // Wait for controller to boot
-
-    // Start I2C on the provided SDA/SCL pins
-    Wire.begin(_sda, _scl);
+    // Interrupt line is polled as a cheap "touch pending" hint
+    pinMode(_irq, INPUT);
+    return CoroutineRunner::getInstance().start(_init);
   }
 
+  // True once the controller is out of reset and answered on the bus
+  bool ready() const { return _ready; }
+
+  // Chip ID read at the end of init (0xB7 for CST820, 0xFF if it didn't answer)
+  uint8_t chipID() const { return _chipId; }
+
   // Optional: Read chip ID from CST820 for verification
   uint8_t readChipID()
   {
-    Wire.beginTransmission(0x15); // CST820 I2C address
-    Wire.write(0xA7);             // Register 0xA7 is the Chip ID register
-    Wire.endTransmission(false);
-    if (Wire.requestFrom(0x15, 1) != 1)
+    // Register 0xA7 is the Chip ID register
+    uint8_t id;
+    if (!I2CBus::getInstance().readRegs(ADDRESS, 0xA7, &id, 1))
       return 0xFF;
-    return Wire.read(); // Should return 0xB7 for CST820
+    return id; // Should return 0xB7 for CST820
   }
 
   // Read current touch point (if any)
   bool getTouch(uint16_t *x, uint16_t *y, uint8_t *gesture = nullptr)
   {
-    Wire.beginTransmission(0x15); // I2C address for CST820
-    Wire.write(0x00);             // Start reading from register 0 (touch data)
-
-    // If failed to request 7 bytes, exit
-    if (Wire.endTransmission(false) != 0 || Wire.requestFrom(0x15, 7) != 7)
+    // Read all 7 bytes of touch event data, starting from register 0
+    // If the read failed, exit
+    uint8_t buf[7];
+    if (!_ready || !I2CBus::getInstance().readRegs(ADDRESS, 0x00, buf, 7))
     {
       return false;
     }
 
-    // Read all 7 bytes of touch event data
-    uint8_t buf[7];
-    for (int i = 0; i < 7; i++)
-      buf[i] = Wire.read();
-
     // Number of touches (low nibble of buf[2])
     uint8_t touches = buf[2] & 0x0F;
     if (touches == 0)
@@ -74,8 +73,45 @@ public:
   }
 
 private:
+  static constexpr uint8_t ADDRESS = 0x15; // CST820 I2C address
+
+  // Reset pulse, boot wait and chip ID probe, without blocking loop()
+  class InitSequence : public Coroutine
+  {
+  public:
+    explicit InitSequence(CST820 &touch) : _touch(touch) {}
+
+  protected:
+    void step(uint32_t now) override
+    {
+      CO_BEGIN();
+      pinMode(_touch._rst, OUTPUT);
+      digitalWrite(_touch._rst, LOW);  // Hold reset low
+      CO_SLEEP_MS(10);                 // Wait a moment
+      digitalWrite(_touch._rst, HIGH); // Release reset
+      CO_SLEEP_MS(100);                // Wait for controller to boot
+
+      // Start the shared I2C bus on the provided SDA/SCL pins
+      I2CBus::getInstance().begin(_touch._sda, _touch._scl);
+
+      // Register 0xA7 is the Chip ID register
+      CO_I2C_READ(ADDRESS, 0xA7, &_touch._chipId, 1);
+      if (!lastOk())
+        _touch._chipId = 0xFF;
+      _touch._ready = true;
+      CO_END();
+    }
+
+  private:
+    CST820 &_touch;
+  };
+
   // Pin assignments for this instance
   uint8_t _sda, _scl, _rst, _irq;
+
+  InitSequence _init{*this};
+  uint8_t _chipId = 0xFF;
+  bool _ready = false;
 };
 
 #endif
\ No newline at end of file
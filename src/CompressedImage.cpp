@@ -0,0 +1,302 @@
+#include "CompressedImage.h"
+#include "MemoryMonitor.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+constexpr size_t HEADER_SIZE = 16;
+
+struct Layout {
+  uint16_t width;
+  uint16_t height;
+  uint8_t rowsPerStrip;
+  const uint8_t *strips; // u32 offsets into data, one per strip
+  const uint8_t *data;
+  uint32_t dataSize;
+};
+
+inline uint16_t rd16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+inline uint32_t rd32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+bool parse(const void *src, Layout &out) {
+  const lv_img_dsc_t *img = static_cast<const lv_img_dsc_t *>(src);
+  if (img->header.cf != LV_IMG_CF_RAW || img->data_size < HEADER_SIZE) return false;
+  const uint8_t *p = img->data;
+  if (memcmp(p, "CYI1", 4) != 0) return false;
+  out.width = rd16(p + 4);
+  out.height = rd16(p + 6);
+  out.rowsPerStrip = p[9] ? p[9] : 1;
+  out.dataSize = rd32(p + 12);
+  size_t strips = (out.height + out.rowsPerStrip - 1) / out.rowsPerStrip;
+  out.strips = p + HEADER_SIZE;
+  out.data = p + HEADER_SIZE + strips * 4;
+  return HEADER_SIZE + strips * 4 + out.dataSize <= img->data_size;
+}
+
+// Decode one row starting at `in`; returns the position of the next row
+const uint8_t *decodeRow(const uint8_t *in, uint16_t width, uint16_t *out) {
+  uint16_t x = 0;
+  while (x < width) {
+    uint8_t c = *in++;
+    uint16_t n = (c & 0x7F) + 1;
+    if (n > width - x) n = width - x;
+    if (c & 0x80) {
+      uint16_t px = rd16(in);
+      in += 2;
+      for (uint16_t i = 0; i < n; i++) out[x++] = px;
+    } else {
+      memcpy(out + x, in, n * 2);
+      in += n * 2;
+      x += n;
+    }
+  }
+  return in;
+}
+
+// Skip one row without writing any pixels
+const uint8_t *skipRow(const uint8_t *in, uint16_t width) {
+  uint16_t x = 0;
+  while (x < width) {
+    uint8_t c = *in++;
+    uint16_t n = (c & 0x7F) + 1;
+    in += (c & 0x80) ? 2 : n * 2;
+    x += n;
+  }
+  return in;
+}
+
+// Per-open state for streamed images
+struct StreamState {
+  Layout layout;
+  const uint8_t *next; // start of row `nextRow`
+  uint16_t nextRow;
+  int32_t bufferedRow; // row currently held in rowBuf, or -1
+  uint16_t rowBuf[1];  // actually `width` entries
+};
+
+#if STATIC_ALLOC
+constexpr size_t StreamBytes = sizeof(StreamState) + IMAGE_STREAM_MAX_WIDTH * 2;
+alignas(StreamState) uint8_t streamStorage[IMAGE_MAX_STREAMS][StreamBytes];
+bool streamUsed[IMAGE_MAX_STREAMS];
+#endif
+
+StreamState *allocStream(uint16_t width) {
+#if STATIC_ALLOC
+  if (width > IMAGE_STREAM_MAX_WIDTH) return nullptr;
+  for (size_t i = 0; i < IMAGE_MAX_STREAMS; i++) {
+    if (streamUsed[i]) continue;
+    streamUsed[i] = true;
+    return reinterpret_cast<StreamState *>(streamStorage[i]);
+  }
+  return nullptr;
+#else
+  size_t bytes = sizeof(StreamState) + (size_t)width * 2;
+  auto *s = static_cast<StreamState *>(malloc(bytes));
+  if (s) MemoryMonitor::getInstance().attribute(MemoryMonitor::TAG_IMAGES, bytes);
+  return s;
+#endif
+}
+
+void freeStream(StreamState *s) {
+#if STATIC_ALLOC
+  for (size_t i = 0; i < IMAGE_MAX_STREAMS; i++) {
+    if (s == reinterpret_cast<StreamState *>(streamStorage[i])) streamUsed[i] = false;
+  }
+#else
+  if (!s) return;
+  size_t bytes = sizeof(StreamState) + (size_t)s->layout.width * 2;
+  MemoryMonitor::getInstance().attribute(MemoryMonitor::TAG_IMAGES, -(int32_t)bytes);
+  free(s);
+#endif
+}
+
+} // namespace
+
+CompressedImage::CacheEntry CompressedImage::cache[MaxCached] = {};
+#if STATIC_ALLOC
+alignas(4) uint8_t CompressedImage::slotStorage[MaxCached][IMAGE_CACHE_SLOT_BYTES];
+#endif
+size_t CompressedImage::cacheBudget = 0;
+size_t CompressedImage::cacheBytesUsed = 0;
+uint32_t CompressedImage::useClock = 0;
+CompressedImage::Stats CompressedImage::st;
+
+void CompressedImage::begin(size_t cacheBytes) {
+  MemoryMonitor::Scope tag(MemoryMonitor::TAG_IMAGES);
+  cacheBudget = cacheBytes;
+#if STATIC_ALLOC
+  if (cacheBudget > sizeof(slotStorage)) cacheBudget = sizeof(slotStorage);
+#endif
+  lv_img_decoder_t *dec = lv_img_decoder_create();
+  lv_img_decoder_set_info_cb(dec, info);
+  lv_img_decoder_set_open_cb(dec, open);
+  lv_img_decoder_set_read_line_cb(dec, readLine);
+  lv_img_decoder_set_close_cb(dec, close);
+}
+
+bool CompressedImage::isCompressed(const void *src) {
+  Layout l;
+  return lv_img_src_get_type(src) == LV_IMG_SRC_VARIABLE && parse(src, l);
+}
+
+lv_res_t CompressedImage::info(lv_img_decoder_t *dec, const void *src, lv_img_header_t *header) {
+  Layout l;
+  if (lv_img_src_get_type(src) != LV_IMG_SRC_VARIABLE || !parse(src, l)) return LV_RES_INV;
+  header->cf = LV_IMG_CF_TRUE_COLOR;
+  header->always_zero = 0;
+  header->w = l.width;
+  header->h = l.height;
+  return LV_RES_OK;
+}
+
+lv_res_t CompressedImage::open(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
+  Layout l;
+  if (dsc->src_type != LV_IMG_SRC_VARIABLE || !parse(dsc->src, l)) return LV_RES_INV;
+  st.opens++;
+
+  // Cached images are drawn directly from RAM
+  CacheEntry *e = cacheFind(dsc->src);
+  if (e) {
+    st.cacheHits++;
+  } else {
+    size_t bytes = (size_t)l.width * l.height * 2;
+    e = cacheInsert(dsc->src, bytes);
+    if (e) {
+      st.cacheMisses++;
+      uint32_t start = micros();
+      const uint8_t *in = l.data;
+      uint16_t *out = reinterpret_cast<uint16_t *>(e->pixels);
+      for (uint16_t y = 0; y < l.height; y++) in = decodeRow(in, l.width, out + (size_t)y * l.width);
+      st.decodeUs += micros() - start;
+      st.pixelsDecoded += (uint64_t)l.width * l.height;
+    }
+  }
+  if (e) {
+    e->refs++;
+    e->lastUse = ++useClock;
+    dsc->img_data = e->pixels;
+    dsc->user_data = e;
+    return LV_RES_OK;
+  }
+
+  // Too big for the cache (or everything cached is in use): stream it
+  StreamState *s = allocStream(l.width);
+  if (!s) return LV_RES_INV;
+  s->layout = l;
+  s->next = l.data;
+  s->nextRow = 0;
+  s->bufferedRow = -1;
+  st.streamedOpens++;
+  dsc->img_data = nullptr;
+  dsc->user_data = s;
+  return LV_RES_OK;
+}
+
+lv_res_t CompressedImage::readLine(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc, lv_coord_t x, lv_coord_t y,
+                                   lv_coord_t len, uint8_t *buf) {
+  auto *s = static_cast<StreamState *>(dsc->user_data);
+  const Layout &l = s->layout;
+  if (y < 0 || y >= l.height || x < 0 || x + len > l.width) return LV_RES_INV;
+
+  uint32_t start = micros();
+  if (s->bufferedRow != y) {
+    // Jump to the strip holding y unless we are already walking towards it
+    if (y < s->nextRow || y / l.rowsPerStrip != s->nextRow / l.rowsPerStrip) {
+      uint16_t strip = y / l.rowsPerStrip;
+      s->next = l.data + rd32(l.strips + strip * 4);
+      s->nextRow = strip * l.rowsPerStrip;
+    }
+    while (s->nextRow < y) {
+      s->next = skipRow(s->next, l.width);
+      s->nextRow++;
+    }
+    // Whole rows go straight into LVGL's buffer
+    if (x == 0 && len == l.width) {
+      s->next = decodeRow(s->next, l.width, reinterpret_cast<uint16_t *>(buf));
+      s->nextRow++;
+      st.decodeUs += micros() - start;
+      st.pixelsDecoded += len;
+      st.linesStreamed++;
+      return LV_RES_OK;
+    }
+    s->next = decodeRow(s->next, l.width, s->rowBuf);
+    s->nextRow++;
+    s->bufferedRow = y;
+    st.pixelsDecoded += l.width;
+  }
+  memcpy(buf, s->rowBuf + x, (size_t)len * 2);
+  st.decodeUs += micros() - start;
+  st.linesStreamed++;
+  return LV_RES_OK;
+}
+
+void CompressedImage::close(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc) {
+  if (dsc->img_data) {
+    // Cached: just drop our reference, the cache keeps the pixels
+    auto *e = static_cast<CacheEntry *>(dsc->user_data);
+    if (e && e->refs > 0) e->refs--;
+  } else {
+    freeStream(static_cast<StreamState *>(dsc->user_data));
+  }
+  dsc->user_data = nullptr;
+}
+
+CompressedImage::CacheEntry *CompressedImage::cacheFind(const void *src) {
+  for (auto &e : cache) {
+    if (e.pixels && e.src == src) return &e;
+  }
+  return nullptr;
+}
+
+CompressedImage::CacheEntry *CompressedImage::cacheInsert(const void *src, size_t bytes) {
+  if (bytes > cacheBudget) return nullptr;
+#if STATIC_ALLOC
+  if (bytes > IMAGE_CACHE_SLOT_BYTES) return nullptr;
+#endif
+
+  // Evict least recently used entries that nobody has open until it fits
+  while (true) {
+    CacheEntry *freeSlot = nullptr;
+    CacheEntry *victim = nullptr;
+    for (auto &e : cache) {
+      if (!e.pixels) {
+        if (!freeSlot) freeSlot = &e;
+      } else if (e.refs == 0 && (!victim || e.lastUse < victim->lastUse)) {
+        victim = &e;
+      }
+    }
+    if (freeSlot && cacheBytesUsed + bytes <= cacheBudget) {
+#if STATIC_ALLOC
+      freeSlot->pixels = slotStorage[freeSlot - cache];
+#else
+      freeSlot->pixels = static_cast<uint8_t *>(malloc(bytes));
+      if (freeSlot->pixels) MemoryMonitor::getInstance().attribute(MemoryMonitor::TAG_IMAGES, bytes);
+#endif
+      if (!freeSlot->pixels) return nullptr;
+      freeSlot->src = src;
+      freeSlot->bytes = bytes;
+      freeSlot->refs = 0;
+      cacheBytesUsed += bytes;
+      return freeSlot;
+    }
+    if (!victim) return nullptr;
+#if !STATIC_ALLOC
+    free(victim->pixels);
+    MemoryMonitor::getInstance().attribute(MemoryMonitor::TAG_IMAGES, -(int32_t)victim->bytes);
+#endif
+    cacheBytesUsed -= victim->bytes;
+    *victim = CacheEntry{};
+    st.evictions++;
+  }
+}
+
+void CompressedImage::report(Print &out) {
+  uint32_t pxPerMs = st.decodeUs ? (uint32_t)(st.pixelsDecoded * 1000 / st.decodeUs) : 0;
+  reportf(out, "[img] opens=%lu hits=%lu misses=%lu evictions=%lu streamed=%lu cache=%u/%u B decode=%lu px/ms\n",
+               (unsigned long)st.opens, (unsigned long)st.cacheHits, (unsigned long)st.cacheMisses,
+               (unsigned long)st.evictions, (unsigned long)st.streamedOpens, (unsigned)cacheBytesUsed,
+               (unsigned)cacheBudget, (unsigned long)pxPerMs);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "StaticAlloc.h"
+
+// STATIC_ALLOC builds: the cache is MaxCached fixed slots of this size
+// (images that don't fit a slot are streamed), and up to IMAGE_MAX_STREAMS
+// images up to IMAGE_STREAM_MAX_WIDTH wide can be streamed at once
+// (LV_IMG_CACHE_DEF_SIZE keeps that many open).
+#ifndef IMAGE_CACHE_SLOT_BYTES
+#define IMAGE_CACHE_SLOT_BYTES 2048
+#endif
+#ifndef IMAGE_MAX_STREAMS
+#define IMAGE_MAX_STREAMS 4
+#endif
+#ifndef IMAGE_STREAM_MAX_WIDTH
+#define IMAGE_STREAM_MAX_WIDTH 320
+#endif
+
+class Print;
+
+// LVGL image decoder for RLE-compressed RGB565 assets made by
+// scripts/pack_image.py. Assets are declared as lv_img_dsc_t with
+// cf = LV_IMG_CF_RAW and can be used anywhere LVGL takes an image source.
+//
+// Small images are decoded once into a bounded LRU cache and drawn straight
+// from RAM. Images too large for the cache are streamed: LVGL asks for one
+// line at a time and it is decompressed directly into the draw buffer.
+//
+// Stream layout (little endian):
+//   "CYI1", u16 width, u16 height, u8 flags, u8 rowsPerStrip, u16 reserved,
+//   u32 dataSize, u32 stripOffset[ceil(height / rowsPerStrip)], data
+// Each row is coded on its own as packets: a control byte c, then either
+// (c & 0x80) a run of (c & 0x7F) + 1 copies of one pixel, or c + 1 literal pixels.
+class CompressedImage {
+public:
+  struct Stats {
+    uint32_t opens = 0;
+    uint32_t cacheHits = 0;
+    uint32_t cacheMisses = 0;
+    uint32_t evictions = 0;
+    uint32_t streamedOpens = 0;
+    uint32_t linesStreamed = 0;
+    uint64_t decodeUs = 0;     // time spent decompressing
+    uint64_t pixelsDecoded = 0;
+  };
+
+  // Register the decoder with LVGL; cacheBytes bounds the decoded-image cache
+  // (at most MaxCached * IMAGE_CACHE_SLOT_BYTES in STATIC_ALLOC builds)
+  static void begin(size_t cacheBytes = 32 * 1024);
+
+  // Whether `src` is one of our compressed assets
+  static bool isCompressed(const void *src);
+
+  static const Stats &stats() { return st; }
+  static size_t cacheUsed() { return cacheBytesUsed; }
+  static void report(Print &out);
+
+private:
+  static lv_res_t info(lv_img_decoder_t *dec, const void *src, lv_img_header_t *header);
+  static lv_res_t open(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc);
+  static lv_res_t readLine(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc, lv_coord_t x, lv_coord_t y,
+                           lv_coord_t len, uint8_t *buf);
+  static void close(lv_img_decoder_t *dec, lv_img_decoder_dsc_t *dsc);
+
+  static constexpr size_t MaxCached = 8;
+  struct CacheEntry {
+    const void *src;
+    uint8_t *pixels;
+    size_t bytes;
+    uint32_t lastUse;
+    uint16_t refs;
+  };
+
+  static CacheEntry *cacheFind(const void *src);
+  static CacheEntry *cacheInsert(const void *src, size_t bytes);
+
+  static CacheEntry cache[MaxCached];
+#if STATIC_ALLOC
+  static uint8_t slotStorage[MaxCached][IMAGE_CACHE_SLOT_BYTES];
+#endif
+  static size_t cacheBudget;
+  static size_t cacheBytesUsed;
+  static uint32_t useClock;
+  static Stats st;
+};
@@ -0,0 +1,143 @@
+#include "Coroutine.h"
+#include "RunLoop.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+void Coroutine::waitTime(uint32_t now, uint32_t ms) {
+  timed = true;
+  resumeAt = now + ms;
+}
+
+void Coroutine::waitPoll() {
+  poll = true;
+}
+
+void Coroutine::waitEdge(uint8_t pin, int mode, uint32_t now, uint32_t timeoutMs) {
+  signalled = false;
+  edgePin = pin;
+  timed = timeoutMs > 0;
+  resumeAt = now + timeoutMs;
+  attachInterruptArg(digitalPinToInterrupt(pin), edgeISR, this, mode);
+}
+
+bool Coroutine::submitRead(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+  signalled = false;
+  I2CBus &bus = I2CBus::getInstance();
+  if (!bus.isReady()) {
+    ioRefused = true;
+    return true;
+  }
+  I2CBus::Request req = {addr, reg, buf, nullptr, len, I2CBus::PRIORITY_SENSOR, ioDone, this};
+  return bus.submit(req);
+}
+
+// A refused read resumes on the next service() as if it had failed
+void Coroutine::waitIo() {
+  if (!ioRefused) return;
+  ioRefused = false;
+  ok = false;
+  signalled = true;
+}
+
+void Coroutine::finishWait() {
+  if (edgePin >= 0) {
+    detachInterrupt(digitalPinToInterrupt(edgePin));
+    edgePin = -1;
+    ok = signalled;
+  }
+  poll = false;
+  timed = false;
+  signalled = false;
+}
+
+bool Coroutine::ready(uint32_t now) const {
+  return poll || signalled || (timed && (int32_t)(now - resumeAt) >= 0);
+}
+
+void IRAM_ATTR Coroutine::edgeISR(void *arg) {
+  static_cast<Coroutine *>(arg)->signalled = true;
+  RunLoop::wakeFromISR();
+}
+
+void Coroutine::ioDone(const I2CBus::Request &, bool success, void *ctx) {
+  Coroutine *co = static_cast<Coroutine *>(ctx);
+  co->ok = success;
+  co->signalled = true;
+}
+
+CoroutineRunner &CoroutineRunner::getInstance() {
+  static CoroutineRunner instance;
+  return instance;
+}
+
+bool CoroutineRunner::start(Coroutine &co) {
+  if (co.active) return false;
+  for (int i = 0; i < (int)MaxCoroutines; i++) {
+    if (slots[i]) continue;
+    slots[i] = &co;
+    co.active = true;
+    co.finished = false;
+    co.resumePoint = 0;
+    co.ok = true;
+    co.poll = co.timed = co.signalled = co.ioRefused = false;
+    if (++count > peak) peak = count;
+    resume(i, millis());
+    return true;
+  }
+  rejected++;
+  return false;
+}
+
+void CoroutineRunner::cancel(Coroutine &co) {
+  for (int i = 0; i < (int)MaxCoroutines; i++) {
+    if (slots[i] != &co) continue;
+    co.finishWait();
+    co.active = false;
+    slots[i] = nullptr;
+    count--;
+    return;
+  }
+}
+
+void CoroutineRunner::service(uint32_t now) {
+  if (count == 0) return;
+  if (now == 0) now = millis();
+  for (int i = 0; i < (int)MaxCoroutines; i++) {
+    if (slots[i] && slots[i]->ready(now)) resume(i, now);
+  }
+}
+
+void CoroutineRunner::resume(int slot, uint32_t now) {
+  Coroutine *co = slots[slot];
+  resumes++;
+  co->step(now);
+  if (!co->finished) return;
+  co->active = false;
+  slots[slot] = nullptr;
+  count--;
+  completed++;
+}
+
+uint32_t CoroutineRunner::msUntilNextResume(uint32_t now) const {
+  if (count == 0) return UINT32_MAX;
+  if (now == 0) now = millis();
+  uint32_t next = UINT32_MAX;
+  for (Coroutine *co : slots) {
+    if (!co) continue;
+    if (co->signalled) return 0;
+    uint32_t wait = UINT32_MAX;
+    if (co->poll) {
+      wait = 1;
+    } else if (co->timed) {
+      int32_t left = (int32_t)(co->resumeAt - now);
+      wait = left > 0 ? (uint32_t)left : 0;
+    }
+    if (wait < next) next = wait;
+  }
+  return next;
+}
+
+void CoroutineRunner::report(Print &out) const {
+  reportf(out, "[coro] active=%u peak=%u resumes=%u completed=%u rejected=%u\n", (unsigned)count, (unsigned)peak,
+               (unsigned)resumes, (unsigned)completed, (unsigned)rejected);
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "I2CBus.h"
+
+class Print;
+
+// Stackless coroutines for multi-step device sequences (reset pulses, sensor
+// wake-ups, chains of I2C transactions) written as straight-line code without
+// blocking loop().
+//
+// A coroutine is a class deriving from Coroutine whose step() body sits
+// between CO_BEGIN() and CO_END(). The CO_* awaits suspend the body and
+// CoroutineRunner resumes it from loop() once the wait is over. Because the
+// body returns on every suspend, values that must survive an await have to be
+// members, not locals, and the awaits can't be used inside a nested switch.
+// The object itself is the frame: owners keep it as a member or global, and
+// the runner holds a fixed table of pointers, so nothing is heap-allocated.
+class Coroutine {
+public:
+  virtual ~Coroutine() = default;
+
+  bool running() const { return active; }
+  // Result of the last pin or I2C await (false on timeout or bus error)
+  bool lastOk() const { return ok; }
+
+protected:
+  // Body; `now` is millis() at the time of the resume
+  virtual void step(uint32_t now) = 0;
+
+  // Helpers for the CO_* macros
+  void waitTime(uint32_t now, uint32_t ms);
+  void waitPoll();
+  void waitEdge(uint8_t pin, int mode, uint32_t now, uint32_t timeoutMs);
+  void finishWait();
+  // Queue the read; false if the I2C queue is full. If the bus never came up
+  // the read is dropped and waitIo() fails the await (lastOk() false) at once.
+  bool submitRead(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len);
+  void waitIo();
+
+  uint16_t resumePoint = 0;
+  bool finished = false;
+
+private:
+  friend class CoroutineRunner;
+
+  bool ready(uint32_t now) const;
+  static void edgeISR(void *arg);
+  static void ioDone(const I2CBus::Request &req, bool ok, void *ctx);
+
+  bool active = false;
+  bool ok = true;
+  bool poll = false;      // resume on every service() (CO_WAIT_UNTIL)
+  bool timed = false;     // resume once resumeAt has passed
+  volatile bool signalled = false; // set by a pin ISR or I2C completion
+  bool ioRefused = false; // submitRead() found the bus down
+  int8_t edgePin = -1;
+  uint32_t resumeAt = 0;
+};
+
+// Suspend after running setup; the runner resumes the body once that wait is
+// over. __COUNTER__ gives every await its own resume point, so several awaits
+// may share a source line.
+#define CO_SUSPEND(setup) CO_SUSPEND_AT(__COUNTER__ + 1, setup)
+#define CO_SUSPEND_AT(point, setup) \
+  do {                              \
+    setup;                          \
+    resumePoint = (point);          \
+    return;                         \
+  case (point):                     \
+    finishWait();                   \
+  } while (0)
+
+#define CO_WAIT_UNTIL_AT(point, cond) \
+  do {                                \
+    resumePoint = (point);            \
+  case (point):                       \
+    if (!(cond)) {                    \
+      waitPoll();                     \
+      return;                         \
+    }                                 \
+    finishWait();                     \
+  } while (0)
+
+#define CO_BEGIN()       \
+  switch (resumePoint) { \
+  case 0:
+#define CO_END()   \
+  }                \
+  resumePoint = 0; \
+  finished = true; \
+  return
+
+// Let other work run, then continue on the next service()
+#define CO_YIELD() CO_SUSPEND(waitPoll())
+// Continue once cond holds, re-checking it on every service()
+#define CO_WAIT_UNTIL(cond) CO_WAIT_UNTIL_AT(__COUNTER__ + 1, cond)
+#define CO_SLEEP_MS(ms) CO_SUSPEND(waitTime(now, (ms)))
+// Wait for an edge (RISING, FALLING or CHANGE) on a GPIO; lastOk() is false
+// if timeoutMs (0 = no timeout) ran out first
+#define CO_PIN_EDGE(pin, mode, timeoutMs) CO_SUSPEND(waitEdge((pin), (mode), now, (timeoutMs)))
+// Queued register read through I2CBus (retried while the queue is full);
+// lastOk() reports the result, and is false straight away if the bus is down
+#define CO_I2C_READ(addr, reg, buf, len)                        \
+  do {                                                          \
+    CO_WAIT_UNTIL(submitRead((addr), (reg), (buf), (len)));     \
+    CO_SUSPEND(waitIo()); /* until the completion callback */ \
+  } while (0)
+
+// Resumes coroutines from loop(). A coroutine is resumed only when its wait is
+// over, so idle ones cost a flag check, and msUntilNextResume() tells the run
+// loop how long it may sleep.
+class CoroutineRunner {
+public:
+  static constexpr size_t MaxCoroutines = 8;
+
+  static CoroutineRunner &getInstance();
+
+  CoroutineRunner(const CoroutineRunner &) = delete;
+  CoroutineRunner &operator=(const CoroutineRunner &) = delete;
+
+  // Run the coroutine from the top; the first step happens immediately.
+  // Returns false if it is already running or every slot is taken.
+  bool start(Coroutine &co);
+  void cancel(Coroutine &co);
+
+  // Resume every coroutine whose wait is over
+  void service(uint32_t now = 0);
+
+  // 0 if a coroutine is ready now, 1 while one polls a condition,
+  // UINT32_MAX if all are waiting for a signal (pin ISRs wake the run loop)
+  uint32_t msUntilNextResume(uint32_t now = 0) const;
+
+  size_t active() const { return count; }
+  void report(Print &out) const;
+
+private:
+  CoroutineRunner() = default;
+
+  void resume(int slot, uint32_t now);
+
+  Coroutine *slots[MaxCoroutines] = {};
+  size_t count = 0;
+  size_t peak = 0;
+  uint32_t resumes = 0;
+  uint32_t completed = 0;
+  uint32_t rejected = 0; // start() calls that found no free slot
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Small table-free CRC routines shared by the storage and stream formats.
+
+// CRC-32 (IEEE 802.3, reflected, as used by zlib/PNG)
+inline uint32_t crc32(const void *data, size_t len, uint32_t crc = 0) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  crc = ~crc;
+  while (len--) {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  }
+  return ~crc;
+}
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), for short framed packets
+inline uint16_t crc16(const void *data, size_t len, uint16_t crc = 0xFFFF) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  while (len--) {
+    crc ^= (uint16_t)(*p++) << 8;
+    for (int k = 0; k < 8; k++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
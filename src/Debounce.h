@@ -0,0 +1,91 @@
+#pragma once
+
+// Debounce state machine for an interrupt-driven input. Nothing here touches
+// the ESP32, so bounce patterns can be replayed on the host
+// (see scripts/debounce_sim.cpp).
+//
+// The first edge starts a settle timer; later edges are only counted. When
+// the timer expires the input is sampled:
+//  - away from the stable level after being stable for at least holdUs: the
+//    change is accepted straight away, even if the contact is still bouncing,
+//    so the reaction time is the settle time rather than the length of the
+//    bounce
+//  - away from the stable level within holdUs of the last change: sample
+//    again once the hold is over and the input has been quiet for a settle
+//    time. This lockout keeps the rest of a bounce after an early accept
+//    from counting as more presses, however slowly the contact chatters.
+//  - at the stable level with an edge less than a settle time ago: still
+//    bouncing, sample again once it has been quiet
+//  - back at the stable level and quiet: a glitch (e.g. noise coupled in
+//    from the motor wiring) if the level had been holding, else the end of
+//    a bounce; either way ignored
+
+#include <stdint.h>
+
+class Debounce {
+public:
+  enum Result : uint8_t {
+    NONE,    // no change (pending bounce has settled at the stable level)
+    CHANGED, // level() is the new stable level
+    GLITCH,  // pulse shorter than the settle time, ignored
+    REARM,   // still bouncing, call expire() again after rearmUs()
+  };
+
+  explicit Debounce(bool level = false, uint32_t settleUs = 1000, uint32_t holdUs = 20000)
+      : stable(level), settleUs(settleUs), holdUs(holdUs) {}
+
+  // From the pin interrupt; true if the settle timer has to be started
+  bool edge(uint64_t nowUs) {
+    lastEdgeUs = nowUs;
+    edgeCount++;
+    if (pending) return false;
+    pending = true;
+    firstEdgeUs = nowUs;
+    return true;
+  }
+
+  // From the settle timer, with the input sampled now
+  Result expire(bool level, uint64_t nowUs) {
+    if (!pending) return NONE;
+    bool quiet = nowUs - lastEdgeUs >= settleUs;
+    bool holding = firstEdgeUs >= holdUntilUs;
+    if (level != stable) {
+      if (holding || (quiet && nowUs >= holdUntilUs)) {
+        stable = level;
+        pending = false;
+        holdUntilUs = nowUs + holdUs;
+        return CHANGED;
+      }
+      return REARM;
+    }
+    if (!quiet) return REARM;
+    pending = false;
+    return holding ? GLITCH : NONE;
+  }
+
+  // Delay before the next expire() after REARM
+  uint32_t rearmUs(uint64_t nowUs) const {
+    uint64_t quiet = nowUs - lastEdgeUs;
+    uint64_t wait = quiet < settleUs ? settleUs - quiet : 0;
+    if (holdUntilUs > nowUs && holdUntilUs - nowUs > wait) wait = holdUntilUs - nowUs;
+    return wait ? (uint32_t)wait : 1;
+  }
+
+  bool level() const { return stable; }
+  bool busy() const { return pending; }
+  uint32_t settle() const { return settleUs; }
+  uint32_t hold() const { return holdUs; }
+  // Time of the edge that started the current (or last) change
+  uint64_t firstEdge() const { return firstEdgeUs; }
+  uint32_t edges() const { return edgeCount; }
+
+private:
+  bool stable;
+  bool pending = false;
+  uint32_t settleUs;
+  uint32_t holdUs;
+  uint64_t holdUntilUs = 0; // edges before this follow a change too closely to be accepted early
+  uint64_t firstEdgeUs = 0;
+  uint64_t lastEdgeUs = 0;
+  uint32_t edgeCount = 0;
+};
@@ -0,0 +1,41 @@
+#include "DeferredLog.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+DeferredLog &DeferredLog::getInstance() {
+  static DeferredLog instance;
+  return instance;
+}
+
+void DeferredLog::append(LogSink::Level lvl, const uint8_t *rec, size_t len) {
+  // Problems go out now, and ahead of routine telemetry, together with the
+  // records batched before them so the log stays in order
+  bool urgent = lvl >= LogSink::LEVEL_WARN;
+  Telemetry::Priority prio = urgent ? Telemetry::PRIORITY_HIGH : Telemetry::PRIORITY_NORMAL;
+
+  if (batchLen + len > sizeof(batch)) send(prio);
+  if (batchLen == 0) batchStart = millis();
+  memcpy(batch + batchLen, rec, len);
+  batchLen += len;
+  st.records++;
+  if (urgent) send(prio);
+}
+
+void DeferredLog::service(uint32_t now) {
+  if (batchLen == 0) return;
+  if (now == 0) now = millis();
+  if (now - batchStart >= FlushMs) flush();
+}
+
+void DeferredLog::flush() { send(Telemetry::PRIORITY_NORMAL); }
+
+void DeferredLog::send(Telemetry::Priority prio) {
+  if (batchLen == 0) return;
+  if (Telemetry::getInstance().send(Telemetry::SCHEMA_LOG, prio, batch, batchLen)) st.frames++;
+  batchLen = 0;
+}
+
+void DeferredLog::report(Print &out) const {
+  reportf(out, "[dlog] records=%lu frames=%lu oversized=%lu\n", (unsigned long)st.records, (unsigned long)st.frames,
+               (unsigned long)st.oversized);
+}
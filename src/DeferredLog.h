@@ -0,0 +1,135 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "LogSink.h"
+#include "Telemetry.h"
+
+class Print;
+
+// Binary log records for LOG_DEFERRED builds (see Log.h). The format string
+// never leaves the device: each call site is identified by a 32-bit FNV-1a
+// hash of its format string, computed at compile time, and
+// scripts/intern_logs.py builds the matching id -> format table from the
+// sources at build time. Only the id and the raw argument values are sent, so
+// number formatting (floats in particular) happens on the host, in
+// scripts/telemetry_decode.py.
+//
+// Records are batched into SCHEMA_LOG telemetry frames:
+//   u8 length, u32 id, arguments
+// where every integer is a zigzag varint, floats and doubles are float32 and
+// strings are a length byte plus up to MaxString bytes. Warnings and errors
+// are sent straight away at high priority; other records wait in the batch
+// for up to FlushMs.
+class DeferredLog {
+public:
+  static constexpr size_t MaxString = 16;
+  static constexpr uint32_t FlushMs = 100;
+
+  static constexpr uint32_t hash(const char *s) {
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+  }
+
+  static DeferredLog &getInstance();
+
+  DeferredLog(const DeferredLog &) = delete;
+  DeferredLog &operator=(const DeferredLog &) = delete;
+
+  template <typename... Args>
+  void write(LogSink::Level lvl, uint32_t id, const Args &...args) {
+    uint8_t rec[Telemetry::MaxBody];
+    size_t n = 1;
+    put32(rec, n, id);
+    bool fits = true;
+    int expand[] = {0, (fits = fits && put(rec, n, args), 0)...};
+    (void)expand;
+    if (!fits) {
+      st.oversized++;
+      return;
+    }
+    rec[0] = n;
+    append(lvl, rec, n);
+  }
+
+  // Call from loop(): sends the batch once it is FlushMs old
+  void service(uint32_t now = 0);
+  void flush();
+
+  void report(Print &out) const;
+
+private:
+  struct Stats {
+    uint32_t records = 0;
+    uint32_t frames = 0;
+    uint32_t oversized = 0; // records too large for a frame
+  };
+
+  DeferredLog() = default;
+
+  void append(LogSink::Level lvl, const uint8_t *rec, size_t len);
+  void send(Telemetry::Priority prio);
+
+  static void put32(uint8_t *rec, size_t &n, uint32_t v) {
+    memcpy(rec + n, &v, 4);
+    n += 4;
+  }
+
+  static bool putVarint(uint8_t *rec, size_t &n, uint64_t v) {
+    do {
+      if (n >= Telemetry::MaxBody) return false;
+      uint8_t b = v & 0x7F;
+      v >>= 7;
+      rec[n++] = v ? b | 0x80 : b;
+    } while (v);
+    return true;
+  }
+
+  template <typename T>
+  static bool put(uint8_t *rec, size_t &n, const T &v) {
+    if constexpr (std::is_floating_point<T>::value) {
+      if (n + 4 > Telemetry::MaxBody) return false;
+      float f = (float)v;
+      memcpy(rec + n, &f, 4);
+      n += 4;
+      return true;
+    } else if constexpr (std::is_integral<T>::value || std::is_enum<T>::value) {
+      int64_t i = (int64_t)v;
+      return putVarint(rec, n, ((uint64_t)i << 1) ^ (uint64_t)(i >> 63));
+    } else if constexpr (std::is_convertible<T, const char *>::value) {
+      const char *s = v;
+      if (!s) s = "(null)";
+      size_t len = strnlen(s, MaxString);
+      if (n + 1 + len > Telemetry::MaxBody) return false;
+      rec[n++] = len;
+      memcpy(rec + n, s, len);
+      n += len;
+      return true;
+    } else {
+      static_assert(std::is_pointer<T>::value, "unsupported log argument type");
+      uint64_t p = (uint64_t)(uintptr_t)v;
+      return putVarint(rec, n, p << 1);
+    }
+  }
+
+  uint8_t batch[Telemetry::MaxBody];
+  size_t batchLen = 0;
+  uint32_t batchStart = 0;
+  Stats st;
+};
+
+// Never called; lets the compiler check the arguments against the format
+static inline void deferredLogFormatCheck(const char *, ...) __attribute__((format(printf, 1, 2)));
+static inline void deferredLogFormatCheck(const char *, ...) {}
+
+#define DEFERRED_LOG(level, fmt, ...)                                          \
+  do {                                                                         \
+    if (false) deferredLogFormatCheck(fmt, ##__VA_ARGS__);                     \
+    if (LogSink::getInstance().enabled(level)) {                               \
+      constexpr uint32_t deferredLogId = DeferredLog::hash(fmt);               \
+      DeferredLog::getInstance().write(level, deferredLogId, ##__VA_ARGS__);   \
+    }                                                                          \
+  } while (0)
@@ -0,0 +1,12 @@
+#include "EventBus.h"
+#include "ReportPrint.h"
+
+void EventBus::report(Print &out) {
+  for (const Stats *s = statsHead; s; s = s->next) {
+    uint32_t events = s->published + s->posted;
+    reportf(out, "[event] %s published=%lu posted=%lu dropped=%lu handlers=%lu avg=%luus max=%luus\n", s->name,
+                 (unsigned long)s->published, (unsigned long)s->posted, (unsigned long)s->dropped,
+                 (unsigned long)s->deliveries, (unsigned long)(events ? s->totalUs / events : 0),
+                 (unsigned long)s->maxUs);
+  }
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+unsigned long micros();
+#endif
+
+class Print;
+
+// Typed publish/subscribe between modules without them knowing each other.
+// An event is a small trivially copyable struct with a `Name` for reports
+// (see Events.h). Every event type gets its own static subscriber table, so
+// subscribing, publishing and queueing never allocate.
+//
+// publish() calls the handlers straight away; post() copies the event into a
+// fixed queue that dispatchQueued() delivers later from loop(), for
+// publishers that shouldn't run other modules' code in their context (LVGL
+// input reads, scheduler bookkeeping). The time spent in handlers is measured
+// per event type. Publish and post from the loop task only.
+class EventBus {
+public:
+  static constexpr size_t MaxSubscribers = 4; // per event type
+  static constexpr size_t QueueDepth = 16;
+  static constexpr size_t MaxPayload = 16;    // largest event that can be posted
+
+  template <typename E>
+  using Handler = void (*)(const E &event, void *ctx);
+
+  struct Stats {
+    const char *name;
+    uint32_t published = 0;  // delivered inline
+    uint32_t posted = 0;     // delivered through the queue
+    uint32_t dropped = 0;    // posts lost because the queue was full
+    uint32_t deliveries = 0; // handler calls
+    uint32_t totalUs = 0;    // time in handlers
+    uint32_t maxUs = 0;      // slowest single event, over all its handlers
+    Stats *next = nullptr;
+    bool linked = false;
+
+    explicit Stats(const char *n) : name(n) {}
+  };
+
+  // Returns false if the table for this event type is full
+  template <typename E>
+  static bool subscribe(Handler<E> handler, void *ctx = nullptr) {
+    auto &t = table<E>();
+    for (auto &s : t.subs) {
+      if (s.handler) continue;
+      s.handler = handler;
+      s.ctx = ctx;
+      return true;
+    }
+    return false;
+  }
+
+  template <typename E>
+  static void unsubscribe(Handler<E> handler, void *ctx = nullptr) {
+    for (auto &s : table<E>().subs) {
+      if (s.handler == handler && s.ctx == ctx) s.handler = nullptr;
+    }
+  }
+
+  template <typename E>
+  static void publish(const E &event) {
+    table<E>().st.published++;
+    deliver<E>(&event);
+  }
+
+  // Queue the event for dispatchQueued(); false (and counted) if the queue is full
+  template <typename E>
+  static bool post(const E &event) {
+    static_assert(std::is_trivially_copyable<E>::value, "posted events are copied as bytes");
+    static_assert(sizeof(E) <= MaxPayload, "event too large for the queue");
+    static_assert(alignof(E) <= 8, "queue slots are 8-byte aligned");
+    auto &t = table<E>();
+    if (queued == QueueDepth) {
+      t.st.dropped++;
+      return false;
+    }
+    Queued &q = queue[(queueHead + queued) % QueueDepth];
+    q.deliver = &deliver<E>;
+    memcpy(q.payload, &event, sizeof(E));
+    queued++;
+    t.st.posted++;
+    return true;
+  }
+
+  // Deliver the events queued so far; events posted by the handlers wait for
+  // the next call
+  static void dispatchQueued() {
+    for (size_t n = queued; n > 0; n--) {
+      Queued q = queue[queueHead];
+      queueHead = (queueHead + 1) % QueueDepth;
+      queued--;
+      q.deliver(q.payload);
+    }
+  }
+
+  static bool pending() { return queued > 0; }
+
+  template <typename E>
+  static const Stats &stats() {
+    return table<E>().st;
+  }
+
+  // One line per event type that has been used
+  static void report(Print &out);
+
+private:
+  template <typename E>
+  struct Subscriber {
+    Handler<E> handler;
+    void *ctx;
+  };
+
+  template <typename E>
+  struct Table {
+    Subscriber<E> subs[MaxSubscribers] = {};
+    Stats st{E::Name};
+  };
+
+  struct Queued {
+    void (*deliver)(const void *payload);
+    alignas(8) uint8_t payload[MaxPayload];
+  };
+
+  template <typename E>
+  static Table<E> &table() {
+    static Table<E> t;
+    if (!t.st.linked) {
+      t.st.linked = true;
+      t.st.next = statsHead;
+      statsHead = &t.st;
+    }
+    return t;
+  }
+
+  template <typename E>
+  static void deliver(const void *payload) {
+    const E &event = *static_cast<const E *>(payload);
+    auto &t = table<E>();
+    uint32_t start = micros();
+    for (auto &s : t.subs) {
+      if (!s.handler) continue;
+      s.handler(event, s.ctx);
+      t.st.deliveries++;
+    }
+    uint32_t spent = micros() - start;
+    t.st.totalUs += spent;
+    if (spent > t.st.maxUs) t.st.maxUs = spent;
+  }
+
+  static inline Stats *statsHead = nullptr;
+  static inline Queued queue[QueueDepth] = {};
+  static inline size_t queueHead = 0;
+  static inline size_t queued = 0;
+};
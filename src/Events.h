@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+// Events published on the EventBus. Keep them small (they are copied into
+// the post() queue) and give each a Name for EventBus::report().
+
+// A DHT read finished; NaN for a value the sensor didn't return
+struct SensorReading {
+  static constexpr const char *Name = "sensor";
+  float tempC;
+  float humidity;
+};
+
+// Finger down or up on the touchscreen, in screen coordinates
+struct TouchEvent {
+  static constexpr const char *Name = "touch";
+  uint16_t x;
+  uint16_t y;
+  bool pressed;
+};
+
+// LVGL finished a refresh: render time and bytes pushed to the panel
+struct FrameRendered {
+  static constexpr const char *Name = "frame";
+  uint32_t renderMs;
+  uint32_t bytesFlushed;
+};
+
+// A scheduler task ran for longer than its interval
+struct TaskOverrun {
+  static constexpr const char *Name = "overrun";
+  const char *task; // task name, may be nullptr
+  uint32_t execUs;
+  uint32_t intervalMs;
+};
+
+// SD card state changes
+struct StorageEvent {
+  static constexpr const char *Name = "storage";
+  enum Kind : uint8_t {
+    MOUNTED,
+    MISSING,
+    WRITE_FAILED, // queued append data was dropped
+  };
+  Kind kind;
+  uint32_t bytes; // bytes dropped for WRITE_FAILED
+};
+
+// A MemoryMonitor threshold was crossed (active) or has recovered
+struct MemoryAlarm {
+  static constexpr const char *Name = "memory";
+  uint8_t alarm;    // MemoryMonitor::Alarm
+  bool active;
+  uint32_t value;   // bytes, percent or seconds, like the limit
+  uint32_t limit;
+  const char *task; // for ALARM_STACK_LOW
+};
@@ -0,0 +1,362 @@
+#include "FileManager.h"
+#include "ReportPrint.h"
+
+bool FileManager::queueAppend(const char *path, const uint8_t *data, size_t len)
+{
+  if (queueUsed > 0 && strcmp(path, queuePath) != 0)
+    return false;
+  if (len > QUEUE_SIZE - queueUsed)
+  {
+    droppedBytes += len;
+    return false;
+  }
+  if (queueUsed == 0 && strcmp(path, queuePath) != 0)
+  {
+    if (!canOpen())
+    {
+      // Locked STATIC_ALLOC build: the file from openAppend() is the only one
+      droppedBytes += len;
+      return false;
+    }
+    // Only left open between drains in STATIC_ALLOC builds
+    if (queueFile)
+      queueFile.close();
+    strncpy(queuePath, path, sizeof(queuePath) - 1);
+    queuePath[sizeof(queuePath) - 1] = '\0';
+  }
+
+  for (size_t i = 0; i < len; i++)
+  {
+    queue[queueHead] = data[i];
+    queueHead = (queueHead + 1) % QUEUE_SIZE;
+  }
+  queueUsed += len;
+  return true;
+}
+
+bool FileManager::openAppend(const char *path)
+{
+  if (queueUsed > 0 || !canOpen())
+    return false;
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  if (queueFile)
+    queueFile.close();
+  strncpy(queuePath, path, sizeof(queuePath) - 1);
+  queuePath[sizeof(queuePath) - 1] = '\0';
+  queueFile = SD.open(queuePath, FILE_APPEND);
+  return (bool)queueFile;
+}
+
+void FileManager::service()
+{
+  if (queueUsed == 0)
+    return;
+
+  auto &arbiter = SpiArbiter::getInstance();
+  if (!arbiter.sdMayRun(chunkEstimateUs))
+    return;
+
+  // One contiguous chunk out of the ring
+  size_t n = queueUsed < CHUNK_SIZE ? queueUsed : CHUNK_SIZE;
+  if (n > QUEUE_SIZE - queueTail)
+    n = QUEUE_SIZE - queueTail;
+
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  uint32_t start = micros();
+
+  if (!queueFile && canOpen())
+    queueFile = SD.open(queuePath, FILE_APPEND);
+  size_t written = queueFile ? queueFile.write(queue + queueTail, n) : 0;
+  if (written == 0)
+  {
+    // Card missing or full: drop what's queued rather than retrying forever
+    EventBus::post(StorageEvent{StorageEvent::WRITE_FAILED, (uint32_t)queueUsed});
+    droppedBytes += queueUsed;
+    queueUsed = 0;
+    queueTail = queueHead;
+  }
+  else
+  {
+    queueTail = (queueTail + written) % QUEUE_SIZE;
+    queueUsed -= written;
+    invalidateBuffers(queuePath);
+  }
+  if (queueUsed == 0 && queueFile)
+  {
+#if STATIC_ALLOC
+    queueFile.flush(); // couldn't be reopened after setup
+#else
+    queueFile.close();
+#endif
+  }
+
+  // Track how long a chunk really takes so the arbiter gets an honest estimate
+  uint32_t took = micros() - start;
+  chunkEstimateUs = (chunkEstimateUs * 3 + took) / 4;
+  if (took > chunkEstimateUs)
+    chunkEstimateUs = took;
+}
+
+void FileManager::registerLvglDriver(char letter)
+{
+  MemoryMonitor::Scope tag(MemoryMonitor::TAG_STORAGE);
+  lv_fs_drv_init(&lvDriver);
+  lvDriver.letter = letter;
+  lvDriver.cache_size = 0; // we do our own read-ahead
+  lvDriver.open_cb = lvOpen;
+  lvDriver.close_cb = lvClose;
+  lvDriver.read_cb = lvRead;
+  lvDriver.write_cb = lvWrite;
+  lvDriver.seek_cb = lvSeek;
+  lvDriver.tell_cb = lvTell;
+  lvDriver.user_data = this;
+  lv_fs_drv_register(&lvDriver);
+}
+
+void FileManager::closeCachedHandles()
+{
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  for (auto &h : handles)
+  {
+    if (!h.inUse && h.file)
+      h.file.close();
+    if (!h.inUse)
+      h.path[0] = '\0';
+  }
+}
+
+void *FileManager::lvOpen(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode)
+{
+  auto *self = static_cast<FileManager *>(drv->user_data);
+  bool writable = mode & LV_FS_MODE_WR;
+  self->fsStats.opens++;
+
+  // Reuse an idle handle that already has this file open for reading
+  LvHandle *slot = nullptr;
+  if (!writable)
+  {
+    for (auto &h : self->handles)
+    {
+      if (!h.inUse && h.file && !h.writable && strcmp(h.path, path) == 0)
+      {
+        slot = &h;
+        self->fsStats.handleReuses++;
+        break;
+      }
+    }
+  }
+
+  if (!slot)
+  {
+    // Otherwise take a free slot, or evict the least recently used idle one
+    for (auto &h : self->handles)
+    {
+      if (h.inUse)
+        continue;
+      if (!h.file)
+      {
+        slot = &h;
+        break;
+      }
+      if (!slot || h.lastUse < slot->lastUse)
+        slot = &h;
+    }
+    if (!slot || strlen(path) >= sizeof(slot->path) || !canOpen())
+      return nullptr;
+
+    SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+    if (slot->file)
+      slot->file.close();
+    slot->file = SD.open(path, writable ? (mode & LV_FS_MODE_RD ? "r+" : FILE_WRITE) : FILE_READ);
+    if (!slot->file)
+    {
+      slot->path[0] = '\0';
+      return nullptr;
+    }
+    strcpy(slot->path, path);
+    slot->writable = writable;
+    slot->bufLen = 0;
+  }
+
+  slot->inUse = true;
+  slot->lastUse = ++self->handleClock;
+  slot->pos = 0;
+  slot->lastReadEnd = 0;
+  slot->window = 1;
+  return slot;
+}
+
+lv_fs_res_t FileManager::lvClose(lv_fs_drv_t *, void *file_p)
+{
+  auto *h = static_cast<LvHandle *>(file_p);
+  h->inUse = false;
+  if (h->writable)
+  {
+    // Never keep written files open: flush them to the card now
+    SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+    h->file.close();
+    h->path[0] = '\0';
+  }
+  return LV_FS_RES_OK;
+}
+
+// Drop the read-ahead data of every handle on `path` after it was written
+void FileManager::invalidateBuffers(const char *path)
+{
+  for (auto &h : handles)
+  {
+    if (h.file && strcmp(h.path, path) == 0)
+    {
+      h.bufLen = 0;
+      h.reseek = true;
+    }
+  }
+}
+
+// Refill the read-ahead buffer at the sector containing h.pos
+bool FileManager::fillBuffer(LvHandle &h)
+{
+  uint32_t start = h.pos & ~(SECTOR_SIZE - 1);
+  uint32_t len = (uint32_t)h.window * SECTOR_SIZE;
+
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  uint32_t t0 = micros();
+  if ((h.reseek || h.file.position() != start) && !h.file.seek(start))
+    return false;
+  h.reseek = false;
+  size_t got = h.file.read(h.buf, len);
+  fsStats.sdUs += micros() - t0;
+  fsStats.sdReads++;
+  fsStats.sdBytes += got;
+
+  h.bufStart = start;
+  h.bufLen = got;
+  return got > 0;
+}
+
+lv_fs_res_t FileManager::lvRead(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br)
+{
+  auto *self = static_cast<FileManager *>(drv->user_data);
+  auto *h = static_cast<LvHandle *>(file_p);
+  uint8_t *out = static_cast<uint8_t *>(buf);
+  *br = 0;
+
+  // Sequential reads double the read-ahead window, a jump resets it
+  const uint8_t maxWindow = READ_AHEAD_SIZE / SECTOR_SIZE;
+  if (h->pos == h->lastReadEnd)
+  {
+    h->window = h->window * 2 < maxWindow ? h->window * 2 : maxWindow;
+  }
+  else
+  {
+    h->window = 1;
+  }
+
+  bool missed = false;
+  while (btr > 0)
+  {
+    bool inBuffer = h->bufLen > 0 && h->pos >= h->bufStart && h->pos < h->bufStart + h->bufLen;
+    if (!inBuffer)
+    {
+      missed = true;
+      // Large aligned reads skip the buffer and go straight to the caller
+      if (btr >= READ_AHEAD_SIZE && (h->pos & (SECTOR_SIZE - 1)) == 0)
+      {
+        SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+        uint32_t t0 = micros();
+        uint32_t direct = btr & ~(SECTOR_SIZE - 1);
+        if ((h->reseek || h->file.position() != h->pos) && !h->file.seek(h->pos))
+          return LV_FS_RES_HW_ERR;
+        h->reseek = false;
+        size_t got = h->file.read(out, direct);
+        self->fsStats.sdUs += micros() - t0;
+        self->fsStats.sdReads++;
+        self->fsStats.sdBytes += got;
+        out += got;
+        h->pos += got;
+        btr -= got;
+        *br += got;
+        if (got < direct)
+          break; // end of file
+        continue;
+      }
+      // Cover the whole request in one card read even right after a jump
+      uint32_t sectors = ((h->pos & (SECTOR_SIZE - 1)) + btr + SECTOR_SIZE - 1) / SECTOR_SIZE;
+      if (sectors > h->window)
+        h->window = sectors < maxWindow ? sectors : maxWindow;
+      if (!self->fillBuffer(*h))
+        break; // end of file
+    }
+    // Past the last byte of a file that ends inside the buffered sector
+    if (h->pos >= h->bufStart + h->bufLen)
+      break;
+    uint32_t offset = h->pos - h->bufStart;
+    uint32_t n = h->bufLen - offset;
+    if (n > btr)
+      n = btr;
+    memcpy(out, h->buf + offset, n);
+    out += n;
+    h->pos += n;
+    btr -= n;
+    *br += n;
+  }
+
+  if (missed)
+    self->fsStats.bufferMisses++;
+  else
+    self->fsStats.bufferHits++;
+  h->lastReadEnd = h->pos;
+  return LV_FS_RES_OK;
+}
+
+lv_fs_res_t FileManager::lvWrite(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw)
+{
+  auto *h = static_cast<LvHandle *>(file_p);
+  if (!h->writable)
+    return LV_FS_RES_DENIED;
+
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  if (h->file.position() != h->pos && !h->file.seek(h->pos))
+    return LV_FS_RES_HW_ERR;
+  *bw = h->file.write(static_cast<const uint8_t *>(buf), btw);
+  h->pos += *bw;
+  static_cast<FileManager *>(drv->user_data)->invalidateBuffers(h->path);
+  return *bw == btw ? LV_FS_RES_OK : LV_FS_RES_FULL;
+}
+
+lv_fs_res_t FileManager::lvSeek(lv_fs_drv_t *, void *file_p, uint32_t pos, lv_fs_whence_t whence)
+{
+  // Seeking only moves our position; the SD file is repositioned lazily on
+  // the next buffer miss, so seeks inside the read-ahead buffer cost nothing
+  auto *h = static_cast<LvHandle *>(file_p);
+  switch (whence)
+  {
+  case LV_FS_SEEK_SET:
+    h->pos = pos;
+    break;
+  case LV_FS_SEEK_CUR:
+    h->pos += pos;
+    break;
+  case LV_FS_SEEK_END:
+    h->pos = h->file.size() + pos;
+    break;
+  default:
+    return LV_FS_RES_INV_PARAM;
+  }
+  return LV_FS_RES_OK;
+}
+
+lv_fs_res_t FileManager::lvTell(lv_fs_drv_t *, void *file_p, uint32_t *pos_p)
+{
+  *pos_p = static_cast<LvHandle *>(file_p)->pos;
+  return LV_FS_RES_OK;
+}
+
+void FileManager::reportFs(Print &out) const
+{
+  uint32_t kbps = fsStats.sdUs ? (uint32_t)((uint64_t)fsStats.sdBytes * 1000 / fsStats.sdUs) : 0;
+  reportf(out, "[fs] opens=%lu reused=%lu hits=%lu misses=%lu sd reads=%lu (%lu B, %lu KB/s)\n",
+               (unsigned long)fsStats.opens, (unsigned long)fsStats.handleReuses, (unsigned long)fsStats.bufferHits,
+               (unsigned long)fsStats.bufferMisses, (unsigned long)fsStats.sdReads, (unsigned long)fsStats.sdBytes,
+               (unsigned long)kbps);
+}
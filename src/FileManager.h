@@ -4,21 +4,118 @@
 
 #include <Arduino.h>
 #include <SD.h>
+#include <lvgl.h>
+#include "SpiArbiter.h"
+#include "EventBus.h"
+#include "Events.h"
+#include "MemoryMonitor.h"
+#include "StaticAlloc.h"
 
 class FileManager
 {
 private:
   static const uint8_t SD_CS_PIN = 5;
 
+  // Background append queue. Data is written one sector-sized chunk per bus
+  // slot so a large write never holds the SPI bus across a display flush.
+  static constexpr size_t QUEUE_SIZE = 4096;
+  static constexpr size_t CHUNK_SIZE = 512;
+  uint8_t queue[QUEUE_SIZE];
+  size_t queueHead = 0;
+  size_t queueTail = 0;
+  size_t queueUsed = 0;
+  char queuePath[32] = "";
+  File queueFile;
+  uint32_t chunkEstimateUs = 2000;
+  uint32_t droppedBytes = 0;
+
+  // LVGL filesystem driver. Handles stay open after LVGL closes them so the
+  // next open of the same file skips the FAT directory walk, and each handle
+  // has a sector-aligned read-ahead buffer that grows while reads are sequential.
+  static constexpr uint8_t MAX_HANDLES = 4;
+  static constexpr uint32_t SECTOR_SIZE = 512;
+  static constexpr uint32_t READ_AHEAD_SIZE = 4 * SECTOR_SIZE;
+  struct LvHandle
+  {
+    File file;
+    char path[48] = "";
+    bool writable = false;
+    bool inUse = false;
+    uint32_t lastUse = 0;
+    uint32_t pos = 0;
+    uint32_t bufStart = 0;
+    uint32_t bufLen = 0;
+    uint32_t lastReadEnd = 0;
+    uint8_t window = 1; // read-ahead size in sectors
+    bool reseek = false; // file was written: stdio's own buffer may be stale too
+    uint8_t buf[READ_AHEAD_SIZE];
+  };
+  LvHandle handles[MAX_HANDLES];
+  uint32_t handleClock = 0;
+  lv_fs_drv_t lvDriver;
+
+  static void *lvOpen(lv_fs_drv_t *drv, const char *path, lv_fs_mode_t mode);
+  static lv_fs_res_t lvClose(lv_fs_drv_t *drv, void *file_p);
+  static lv_fs_res_t lvRead(lv_fs_drv_t *drv, void *file_p, void *buf, uint32_t btr, uint32_t *br);
+  static lv_fs_res_t lvWrite(lv_fs_drv_t *drv, void *file_p, const void *buf, uint32_t btw, uint32_t *bw);
+  static lv_fs_res_t lvSeek(lv_fs_drv_t *drv, void *file_p, uint32_t pos, lv_fs_whence_t whence);
+  static lv_fs_res_t lvTell(lv_fs_drv_t *drv, void *file_p, uint32_t *pos_p);
+  bool fillBuffer(LvHandle &h);
+  void invalidateBuffers(const char *path);
+
+  // Arduino's FS layer allocates every File it opens (and SD.exists() opens
+  // one), so STATIC_ALLOC builds can't open files once setup() has locked
+  // the heap. Opens after that fail as if the card were missing.
+  static bool canOpen() { return !HeapGuard::locked(); }
+
 public:
+  struct FsStats
+  {
+    uint32_t opens = 0;
+    uint32_t handleReuses = 0; // opens served from an already-open SD handle
+    uint32_t bufferHits = 0;   // reads served entirely from read-ahead
+    uint32_t bufferMisses = 0;
+    uint32_t sdReads = 0;
+    uint32_t sdBytes = 0;
+    uint32_t sdUs = 0;
+  };
+  FsStats fsStats;
+
   bool begin()
   {
-    return SD.begin(SD_CS_PIN);
+    MemoryMonitor::Scope tag(MemoryMonitor::TAG_STORAGE);
+    SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+    bool mounted = SD.begin(SD_CS_PIN);
+    EventBus::publish(StorageEvent{mounted ? StorageEvent::MOUNTED : StorageEvent::MISSING, 0});
+    return mounted;
   }
 
   bool openFile(const char *filename)
   {
+    if (!canOpen())
+      return false;
+    SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
     return SD.exists(filename);
   }
+
+  // Queue data to append to `path`. Returns false if the queue is full or is
+  // still draining data for a different file.
+  bool queueAppend(const char *path, const uint8_t *data, size_t len);
+  // Open `path` for queueAppend() now rather than on the first drain.
+  // STATIC_ALLOC builds must call this before HeapGuard::lock(): after it
+  // only this file can be appended to.
+  bool openAppend(const char *path);
+  bool appendPending() const { return queueUsed > 0; }
+  uint32_t appendDroppedBytes() const { return droppedBytes; }
+
+  // Call from loop(): writes at most one chunk, and only when the SPI arbiter
+  // says it fits before the next display flush and touch slot
+  void service();
+
+  // Make the SD card available to LVGL as "<letter>:/path" (after lv_init())
+  void registerLvglDriver(char letter = 'S');
+  // Close every cached handle (e.g. before removing the card)
+  void closeCachedHandles();
+  void reportFs(Print &out) const;
 };
 #endif
@@ -0,0 +1,198 @@
+#include "GlyphCache.h"
+#include <stdlib.h>
+#include <string.h>
+
+GlyphCache::~GlyphCache() {
+  clear();
+}
+
+void GlyphCache::clear() {
+#if !STATIC_ALLOC
+  free(pixels);
+#endif
+  pixels = nullptr;
+  pixelBytes = 0;
+  count = 0;
+}
+
+// Alpha (0-255) of pixel `i` in a packed glyph bitmap with the given bpp
+static uint8_t glyphAlpha(const uint8_t *bmp, uint32_t i, uint8_t bpp) {
+  switch (bpp) {
+  case 1:
+    return (bmp[i >> 3] >> (7 - (i & 7))) & 0x01 ? 255 : 0;
+  case 2:
+    return ((bmp[i >> 2] >> (6 - 2 * (i & 3))) & 0x03) * 85;
+  case 4:
+    return ((bmp[i >> 1] >> (i & 1 ? 0 : 4)) & 0x0F) * 17;
+  case 8:
+    return bmp[i];
+  default:
+    return 0;
+  }
+}
+
+bool GlyphCache::build(const lv_font_t *font, lv_color_t fg, lv_color_t bg, const char *charset) {
+  clear();
+  if (!font) return false;
+  srcFont = font;
+  fgColor = fg;
+  bgColor = bg;
+  height = lv_font_get_line_height(font);
+
+  // First pass: collect glyph metrics to size a single pixel block. A cell
+  // spans the advance and the bounding box, which can start left of the pen
+  // (negative ofs_x) or end past the advance (italic or wide glyphs)
+  lv_font_glyph_dsc_t dsc[MaxGlyphs];
+  uint32_t letters[MaxGlyphs];
+  lv_coord_t left[MaxGlyphs], width[MaxGlyphs];
+  size_t total = 0;
+  uint32_t i = 0;
+  while (charset[i] != '\0' && count < MaxGlyphs) {
+    uint32_t letter = _lv_txt_encoded_next(charset, &i);
+    lv_font_glyph_dsc_t &g = dsc[count];
+    if (!lv_font_get_glyph_dsc(font, &g, letter, 0)) continue;
+    letters[count] = letter;
+    left[count] = LV_MIN(0, g.ofs_x);
+    width[count] = LV_MAX((lv_coord_t)g.adv_w, (lv_coord_t)(g.ofs_x + g.box_w)) - left[count];
+    total += (size_t)width[count] * height * sizeof(lv_color_t);
+    count++;
+  }
+
+#if STATIC_ALLOC
+  pixels = total <= sizeof(storage) ? storage : nullptr;
+#else
+  pixels = (uint8_t *)malloc(total);
+#endif
+  if (!pixels) {
+    count = 0;
+    return false;
+  }
+  pixelBytes = total;
+
+  // Second pass: blend each glyph into its cell
+  uint8_t *cursor = pixels;
+  lv_coord_t baseLine = font->base_line;
+  for (size_t n = 0; n < count; n++) {
+    const lv_font_glyph_dsc_t &g = dsc[n];
+    lv_coord_t w = width[n];
+    bool overhangs = left[n] < 0 || w > (lv_coord_t)g.adv_w;
+    lv_color_t *cell = (lv_color_t *)cursor;
+    size_t cellPx = (size_t)w * height;
+    // Background pixels of an overhanging cell are left transparent
+    lv_color_t fill = overhangs ? LV_COLOR_CHROMA_KEY : bg;
+    for (size_t p = 0; p < cellPx; p++) cell[p] = fill;
+
+    const uint8_t *bmp = lv_font_get_glyph_bitmap(font, letters[n]);
+    // Same placement LVGL uses when drawing a label line
+    lv_coord_t top = height - baseLine - g.box_h - g.ofs_y;
+    if (bmp) {
+      for (lv_coord_t y = 0; y < g.box_h; y++) {
+        lv_coord_t cy = top + y;
+        if (cy < 0 || cy >= height) continue;
+        for (lv_coord_t x = 0; x < g.box_w; x++) {
+          lv_coord_t cx = g.ofs_x - left[n] + x;
+          uint8_t a = glyphAlpha(bmp, (uint32_t)y * g.box_w + x, g.bpp);
+          if (a) cell[cy * w + cx] = lv_color_mix(fg, bg, a);
+        }
+      }
+    }
+
+    Entry &e = entries[n];
+    e.letter = letters[n];
+    lv_img_dsc_t &img = e.glyph.img;
+    img.header.cf = overhangs ? LV_IMG_CF_TRUE_COLOR_CHROMA_KEYED : LV_IMG_CF_TRUE_COLOR;
+    img.header.always_zero = 0;
+    img.header.w = w;
+    img.header.h = height;
+    img.data_size = cellPx * sizeof(lv_color_t);
+    img.data = cursor;
+    e.glyph.lead = -left[n];
+    e.glyph.advance = g.adv_w;
+    e.glyph.overhangs = overhangs;
+    cursor += img.data_size;
+  }
+  return true;
+}
+
+const GlyphCache::Glyph *GlyphCache::glyph(uint32_t letter) const {
+  for (size_t i = 0; i < count; i++) {
+    if (entries[i].letter == letter) return &entries[i].glyph;
+  }
+  return nullptr;
+}
+
+bool GlyphCache::covers(const char *text) const {
+  uint32_t i = 0;
+  while (text[i] != '\0') {
+    if (!glyph(_lv_txt_encoded_next(text, &i))) return false;
+  }
+  return true;
+}
+
+lv_coord_t GlyphCache::textWidth(const char *text) const {
+  lv_coord_t w = 0;
+  uint32_t i = 0;
+  while (text[i] != '\0') {
+    const Glyph *g = glyph(_lv_txt_encoded_next(text, &i));
+    if (g) w += g->advance;
+  }
+  return w;
+}
+
+lv_obj_t *GlyphReadout::create(lv_obj_t *parent, const GlyphCache &c, lv_coord_t width) {
+  cache = &c;
+  object = lv_obj_create(parent);
+  lv_obj_remove_style_all(object);
+  lv_obj_set_size(object, width, c.lineHeight());
+  // Background matches what the glyphs were blended onto
+  lv_obj_set_style_bg_color(object, c.background(), LV_PART_MAIN);
+  lv_obj_set_style_bg_opa(object, LV_OPA_COVER, LV_PART_MAIN);
+  lv_obj_clear_flag(object, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_event_cb(object, drawEvent, LV_EVENT_DRAW_MAIN, this);
+  return object;
+}
+
+void GlyphReadout::setText(const char *t) {
+  if (strncmp(text, t, MaxText) == 0) return;
+  strncpy(text, t, MaxText - 1);
+  text[MaxText - 1] = '\0';
+  if (object) lv_obj_invalidate(object);
+}
+
+void GlyphReadout::drawEvent(lv_event_t *e) {
+  auto *self = static_cast<GlyphReadout *>(lv_event_get_user_data(e));
+  lv_draw_ctx_t *ctx = lv_event_get_draw_ctx(e);
+  lv_area_t coords;
+  lv_obj_get_coords(self->object, &coords);
+
+  if (!self->cache->covers(self->text)) {
+    // Not in the cache: draw it the normal (slower) way
+    lv_draw_label_dsc_t label;
+    lv_draw_label_dsc_init(&label);
+    label.font = self->cache->font();
+    label.color = self->cache->foreground();
+    lv_draw_label(ctx, &label, &coords, self->text, nullptr);
+    return;
+  }
+
+  // Opaque cells first, then the chroma-keyed ones on top, so an overhang
+  // isn't painted over by its neighbour's background
+  lv_draw_img_dsc_t img;
+  lv_draw_img_dsc_init(&img);
+  for (int pass = 0; pass < 2; pass++) {
+    lv_coord_t pen = coords.x1;
+    uint32_t i = 0;
+    while (self->text[i] != '\0' && pen <= coords.x2) {
+      const GlyphCache::Glyph *g = self->cache->glyph(_lv_txt_encoded_next(self->text, &i));
+      if (g->overhangs == (pass == 1)) {
+        lv_area_t cell;
+        cell.x1 = pen - g->lead;
+        cell.y1 = coords.y1;
+        cell.x2 = cell.x1 + g->img.header.w - 1;
+        cell.y2 = cell.y1 + g->img.header.h - 1;
+        lv_draw_img(ctx, &img, &cell, &g->img);
+      }
+      pen += g->advance;
+    }
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "StaticAlloc.h"
+
+// Pixel storage per cache in STATIC_ALLOC builds; the default charset in
+// Montserrat 28 needs about 16.5 KB. build() fails (and readouts fall back to
+// labels) if the glyphs don't fit.
+#ifndef GLYPH_CACHE_BYTES
+#define GLYPH_CACHE_BYTES (18 * 1024)
+#endif
+
+// Pre-rendered glyphs for large numeric readouts.
+// Each glyph of a small character set is rasterised once, with the foreground
+// already blended onto a known background, into an RGB565 cell as tall as the
+// font's line and wide enough for both the glyph's advance and its bounding
+// box. Drawing a value is then a straight image blit per character instead of
+// anti-aliased glyph rendering. A glyph whose box reaches past its advance
+// into a neighbour gets a chroma-keyed cell and is drawn after the others, so
+// neither cell's background covers the other's ink.
+class GlyphCache {
+public:
+  // Digits, sign, decimal point, space and the unit strings "°C" and "%"
+  static constexpr const char *DefaultCharset = "0123456789-+. \xC2\xB0" "C%";
+  static constexpr size_t MaxGlyphs = 20;
+
+  GlyphCache() = default;
+  ~GlyphCache();
+  GlyphCache(const GlyphCache &) = delete;
+  GlyphCache &operator=(const GlyphCache &) = delete;
+
+  bool build(const lv_font_t *font, lv_color_t fg, lv_color_t bg, const char *charset = DefaultCharset);
+  void clear();
+
+  struct Glyph {
+    lv_img_dsc_t img;
+    lv_coord_t lead;    // cell pixels left of the pen position
+    lv_coord_t advance; // pen movement to the next character
+    bool overhangs;     // box reaches past the advance; cell is chroma-keyed
+  };
+
+  // Cell for a code point, or nullptr if it isn't cached
+  const Glyph *glyph(uint32_t letter) const;
+
+  // True if every character of the UTF-8 text is cached
+  bool covers(const char *text) const;
+  lv_coord_t textWidth(const char *text) const;
+  lv_coord_t lineHeight() const { return height; }
+  const lv_font_t *font() const { return srcFont; }
+  lv_color_t foreground() const { return fgColor; }
+  lv_color_t background() const { return bgColor; }
+  size_t bytesUsed() const { return pixelBytes; }
+
+private:
+  struct Entry {
+    uint32_t letter;
+    Glyph glyph;
+  };
+
+  Entry entries[MaxGlyphs] = {};
+  size_t count = 0;
+  uint8_t *pixels = nullptr;
+  size_t pixelBytes = 0;
+#if STATIC_ALLOC
+  alignas(4) uint8_t storage[GLYPH_CACHE_BYTES];
+#endif
+  lv_coord_t height = 0;
+  const lv_font_t *srcFont = nullptr;
+  lv_color_t fgColor = {};
+  lv_color_t bgColor = {};
+};
+
+// Single-line text widget that draws from a GlyphCache. Falls back to normal
+// label rendering for any text the cache doesn't cover.
+class GlyphReadout {
+public:
+  static constexpr size_t MaxText = 16;
+
+  GlyphReadout() = default;
+
+  lv_obj_t *create(lv_obj_t *parent, const GlyphCache &cache, lv_coord_t width);
+  void setText(const char *text);
+  lv_obj_t *obj() const { return object; }
+
+private:
+  static void drawEvent(lv_event_t *e);
+
+  const GlyphCache *cache = nullptr;
+  lv_obj_t *object = nullptr;
+  char text[MaxText] = "";
+};
@@ -0,0 +1,209 @@
+#include "I2CBus.h"
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include "ReportPrint.h"
+#include <Wire.h>
+
+bool WireBackend::begin(int sda, int scl, uint32_t hz) {
+  return Wire.begin(sda, scl, hz);
+}
+
+uint8_t WireBackend::writeRead(uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen) {
+  Wire.beginTransmission(addr);
+  Wire.write(tx, txLen);
+  uint8_t err = Wire.endTransmission(rxLen == 0);
+  if (err != 0 || rxLen == 0) return err;
+  if (rxLen > I2CBus::MaxReadChunk) return 4; // more than Wire can buffer
+  if (Wire.requestFrom(addr, (uint8_t)rxLen) != rxLen) return 4;
+  for (size_t i = 0; i < rxLen; i++) rx[i] = Wire.read();
+  return 0;
+}
+
+uint32_t WireBackend::micros() {
+  return ::micros();
+}
+#endif
+
+I2CBus &I2CBus::getInstance() {
+  static I2CBus instance;
+  return instance;
+}
+
+bool I2CBus::begin(int sda, int scl, uint32_t hz) {
+  if (ready) return true;
+#ifdef ARDUINO
+  static WireBackend wire;
+  if (!backend) backend = &wire;
+#endif
+  if (!backend) return false;
+  ready = backend->begin(sda, scl, hz);
+  return ready;
+}
+
+bool I2CBus::readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len) {
+  return transfer(addr, reg, nullptr, buf, len) == 0;
+}
+
+bool I2CBus::writeRegs(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t len) {
+  return transfer(addr, reg, data, nullptr, len) == 0;
+}
+
+bool I2CBus::submit(const Request &req) {
+  if (!ready) return false; // service() would never run it
+  if (!req.rx && req.len > MaxBatchBytes) return false; // can't be sent, see transfer()
+  for (auto &s : slots) {
+    if (s.used) continue;
+    s.req = req;
+    s.seq = seq++;
+    s.queuedAt = backend->micros();
+    s.used = true;
+    queued++;
+    return true;
+  }
+  return false;
+}
+
+void I2CBus::service(uint32_t budgetUs) {
+  if (!ready || queued == 0) return;
+  uint32_t start = backend->micros();
+  do {
+    int i = nextSlot();
+    if (i < 0) break;
+    runBatch(i);
+  } while (queued > 0 && backend->micros() - start < budgetUs);
+}
+
+// Highest priority first, oldest first within a priority
+int I2CBus::nextSlot() const {
+  int best = -1;
+  for (int i = 0; i < (int)MaxQueued; i++) {
+    if (!slots[i].used) continue;
+    if (best < 0 || slots[i].req.priority < slots[best].req.priority ||
+        (slots[i].req.priority == slots[best].req.priority && (int32_t)(slots[i].seq - slots[best].seq) < 0)) {
+      best = i;
+    }
+  }
+  return best;
+}
+
+void I2CBus::runBatch(int first) {
+  Request head = slots[first].req;
+  uint32_t now = backend->micros();
+
+  if (head.rx == nullptr) {
+    // Writes are never merged
+    DeviceStats &st = statsFor(head.addr);
+    uint32_t waited = now - slots[first].queuedAt;
+    if (waited > st.maxQueueUs) st.maxQueueUs = waited;
+    slots[first].used = false;
+    queued--;
+    bool ok = transfer(head.addr, head.reg, head.tx, nullptr, head.len) == 0;
+    if (head.done) head.done(head, ok, head.ctx);
+    return;
+  }
+
+  // Collect every queued read on this device whose register window fits in
+  // one contiguous read of at most MaxBatchBytes
+  int members[MaxQueued];
+  size_t n = 0;
+  uint8_t lo = head.reg;
+  uint16_t hi = head.reg + head.len;
+  members[n++] = first;
+  for (int i = 0; i < (int)MaxQueued; i++) {
+    const Slot &s = slots[i];
+    if (!s.used || i == first || s.req.addr != head.addr || s.req.rx == nullptr) continue;
+    uint8_t newLo = s.req.reg < lo ? s.req.reg : lo;
+    uint16_t end = s.req.reg + s.req.len;
+    uint16_t newHi = end > hi ? end : hi;
+    // Only merge overlapping or touching windows so no unrelated registers are read
+    bool touches = s.req.reg <= hi && end >= lo;
+    if (!touches || (size_t)(newHi - newLo) > MaxBatchBytes) continue;
+    lo = newLo;
+    hi = newHi;
+    members[n++] = i;
+  }
+
+  DeviceStats &st = statsFor(head.addr);
+  for (size_t m = 0; m < n; m++) {
+    uint32_t waited = now - slots[members[m]].queuedAt;
+    if (waited > st.maxQueueUs) st.maxQueueUs = waited;
+  }
+  st.batched += n - 1;
+
+  // A read that nothing was merged with (the only kind that can be longer
+  // than MaxBatchBytes) goes straight into its own buffer
+  uint8_t buf[MaxBatchBytes];
+  uint8_t *dest = n == 1 ? head.rx : buf;
+  bool ok = transfer(head.addr, lo, nullptr, dest, (uint8_t)(hi - lo)) == 0;
+
+  for (size_t m = 0; m < n; m++) {
+    Slot &s = slots[members[m]];
+    Request req = s.req;
+    s.used = false;
+    queued--;
+    if (ok && dest == buf) memcpy(req.rx, buf + (req.reg - lo), req.len);
+    if (req.done) req.done(req, ok, req.ctx);
+  }
+}
+
+uint8_t I2CBus::transfer(uint8_t addr, uint8_t reg, const uint8_t *tx, uint8_t *rx, uint8_t len) {
+  if (!ready) return 0xFF;
+  DeviceStats &st = statsFor(addr);
+  uint32_t start = backend->micros();
+
+  uint8_t err;
+  if (rx) {
+    err = 0;
+    for (size_t off = 0; off < len && err == 0; off += MaxReadChunk) {
+      uint8_t at = (uint8_t)(reg + off);
+      size_t n = len - off < MaxReadChunk ? len - off : MaxReadChunk;
+      err = backend->writeRead(addr, &at, 1, rx + off, n);
+    }
+  } else {
+    uint8_t out[MaxBatchBytes + 1];
+    if (len > MaxBatchBytes) return 0xFE;
+    out[0] = reg;
+    if (len) memcpy(out + 1, tx, len);
+    err = backend->writeRead(addr, out, len + 1, nullptr, 0);
+  }
+
+  uint32_t took = backend->micros() - start;
+  st.transactions++;
+  st.totalUs += took;
+  if (took > st.maxUs) st.maxUs = took;
+  if (err != 0) st.errors++;
+  return err;
+}
+
+I2CBus::DeviceStats &I2CBus::statsFor(uint8_t addr) {
+  for (size_t i = 0; i < deviceCount; i++) {
+    if (devices[i].addr == addr) return devices[i];
+  }
+  if (deviceCount < MaxDevices) {
+    devices[deviceCount] = DeviceStats{};
+    devices[deviceCount].addr = addr;
+    return devices[deviceCount++];
+  }
+  return overflow;
+}
+
+const I2CBus::DeviceStats *I2CBus::stats(uint8_t addr) const {
+  for (size_t i = 0; i < deviceCount; i++) {
+    if (devices[i].addr == addr) return &devices[i];
+  }
+  return nullptr;
+}
+
+#ifdef ARDUINO
+void I2CBus::report(Print &out) const {
+  for (size_t i = 0; i < deviceCount; i++) {
+    const DeviceStats &d = devices[i];
+    reportf(out, "[i2c] 0x%02X xfers=%lu errors=%lu batched=%lu avg=%luus max=%luus queue max=%luus\n",
+                 d.addr, (unsigned long)d.transactions, (unsigned long)d.errors, (unsigned long)d.batched,
+                 (unsigned long)(d.transactions ? d.totalUs / d.transactions : 0), (unsigned long)d.maxUs,
+                 (unsigned long)d.maxQueueUs);
+  }
+}
+#endif
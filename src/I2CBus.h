@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+// Transport used by I2CBus. The firmware uses WireBackend; a host build can
+// plug in a fake to exercise the queueing and batching without hardware.
+class I2CBackend {
+public:
+  virtual ~I2CBackend() = default;
+  virtual bool begin(int sda, int scl, uint32_t hz) = 0;
+  // Write tx then (repeated start) read rx. Returns 0 on success, else an error code.
+  virtual uint8_t writeRead(uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen) = 0;
+  virtual uint32_t micros() = 0;
+};
+
+#ifdef ARDUINO
+class WireBackend : public I2CBackend {
+public:
+  bool begin(int sda, int scl, uint32_t hz) override;
+  uint8_t writeRead(uint8_t addr, const uint8_t *tx, size_t txLen, uint8_t *rx, size_t rxLen) override;
+  uint32_t micros() override;
+};
+#endif
+
+// Owns the shared I2C bus (Wire). Latency-critical reads such as touch run
+// immediately through readRegs(); everything else is queued with a priority
+// and drained from loop() by service(), so environmental sensors never sit in
+// front of a touch read. Queued reads of adjacent registers on the same device
+// are merged into one transaction.
+class I2CBus {
+public:
+  enum Priority : uint8_t {
+    PRIORITY_TOUCH = 0, // highest
+    PRIORITY_SENSOR = 1,
+    PRIORITY_BACKGROUND = 2,
+  };
+
+  struct Request;
+  using Callback = void (*)(const Request &req, bool ok, void *ctx);
+
+  struct Request {
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t *rx;      // read buffer (nullptr for a write)
+    const uint8_t *tx; // write payload after the register byte (nullptr for a read)
+    uint8_t len;
+    Priority priority;
+    Callback done;
+    void *ctx;
+  };
+
+  struct DeviceStats {
+    uint8_t addr;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t batched;   // queued requests that rode along in another transaction
+    uint32_t totalUs;
+    uint32_t maxUs;
+    uint32_t maxQueueUs; // longest a queued request waited before running
+  };
+
+  static constexpr size_t MaxQueued = 16;
+  static constexpr size_t MaxDevices = 8;
+  static constexpr size_t MaxBatchBytes = 32;
+  // Wire's receive buffer (I2C_BUFFER_LENGTH on the ESP32) holds 128 bytes
+  static constexpr size_t MaxReadChunk = 128;
+
+  static I2CBus &getInstance();
+
+  I2CBus(const I2CBus &) = delete;
+  I2CBus &operator=(const I2CBus &) = delete;
+
+  // Swap the transport (before begin()); defaults to Wire on the device
+  void setBackend(I2CBackend *b) { backend = b; }
+  bool begin(int sda, int scl, uint32_t hz = 400000);
+  // False until begin() has succeeded
+  bool isReady() const { return ready; }
+
+  // Immediate register access, bypassing the queue
+  bool readRegs(uint8_t addr, uint8_t reg, uint8_t *buf, uint8_t len);
+  bool writeRegs(uint8_t addr, uint8_t reg, const uint8_t *data, uint8_t len);
+
+  // Queue a transaction; returns false if the bus isn't ready, the queue is
+  // full or a write is longer than MaxBatchBytes. Reads of up to 255 bytes are fine; only reads
+  // that fit in MaxBatchBytes together are merged. Reads longer than
+  // MaxReadChunk go out as consecutive register reads of at most that size,
+  // which relies on the register auto-increment that merging assumes too.
+  bool submit(const Request &req);
+  bool pending() const { return queued > 0; }
+
+  // Run queued transactions, highest priority first, until the queue is empty
+  // or budgetUs has been spent
+  void service(uint32_t budgetUs = 2000);
+
+  const DeviceStats *stats(uint8_t addr) const;
+  void report(Print &out) const;
+
+private:
+  I2CBus() = default;
+
+  struct Slot {
+    Request req;
+    uint32_t seq;
+    uint32_t queuedAt;
+    bool used;
+  };
+
+  int nextSlot() const;
+  void runBatch(int first);
+  uint8_t transfer(uint8_t addr, uint8_t reg, const uint8_t *tx, uint8_t *rx, uint8_t len);
+  DeviceStats &statsFor(uint8_t addr);
+
+  I2CBackend *backend = nullptr;
+  bool ready = false;
+  Slot slots[MaxQueued] = {};
+  size_t queued = 0;
+  uint32_t seq = 0;
+  DeviceStats devices[MaxDevices] = {};
+  size_t deviceCount = 0;
+  DeviceStats overflow = {};
+};
@@ -0,0 +1,124 @@
+#include "LedEffects.h"
+#include <Arduino.h>
+#include <driver/ledc.h>
+
+// Arduino-ESP32 2.x numbers the LEDC channels 0-7 high speed and 8-15 low
+// speed (timer = channel / 2 % 4), and analogWrite() hands them out from 15
+// downward, so low-speed channels 6-7 and timer 3 are the first it takes.
+// Low-speed channels 0-2 on timer 0 are Arduino channels 8-10, which
+// analogWrite() only reaches after five other pins. ledcSetup() users should
+// stay on channels 0-7 or 11-15.
+static constexpr ledc_mode_t LED_MODE = LEDC_LOW_SPEED_MODE;
+static constexpr ledc_timer_t LED_TIMER = LEDC_TIMER_0;
+static constexpr ledc_channel_t LED_CHANNELS[3] = {LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2};
+static constexpr uint32_t LED_FREQ_HZ = 5000;
+
+LedEffects &LedEffects::getInstance() {
+  static LedEffects instance;
+  return instance;
+}
+
+void LedEffects::begin(uint8_t redPin, uint8_t greenPin, uint8_t bluePin) {
+  if (ready) return;
+
+  ledc_timer_config_t timerCfg = {};
+  timerCfg.speed_mode = LED_MODE;
+  timerCfg.duty_resolution = (ledc_timer_bit_t)led::DutyBits;
+  timerCfg.timer_num = LED_TIMER;
+  timerCfg.freq_hz = LED_FREQ_HZ;
+  timerCfg.clk_cfg = LEDC_AUTO_CLK;
+  ledc_timer_config(&timerCfg);
+
+  const uint8_t pins[3] = {redPin, greenPin, bluePin};
+  for (int i = 0; i < 3; i++) {
+    ledc_channel_config_t ch = {};
+    ch.gpio_num = pins[i];
+    ch.speed_mode = LED_MODE;
+    ch.channel = LED_CHANNELS[i];
+    ch.intr_type = LEDC_INTR_DISABLE;
+    ch.timer_sel = LED_TIMER;
+    ch.duty = 0;
+    ch.hpoint = 0;
+    ch.flags.output_invert = 1; // active low: duty 0 == off
+    ledc_channel_config(&ch);
+  }
+  ledc_fade_func_install(0);
+
+  esp_timer_create_args_t args = {};
+  args.callback = onStepTimer;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "led_fx";
+  esp_timer_create(&args, &stepTimer);
+
+  ready = true;
+}
+
+void LedEffects::setColor(uint8_t r, uint8_t g, uint8_t b) {
+  setColor(((uint32_t)r << 16) | ((uint32_t)g << 8) | b);
+}
+
+void LedEffects::setColor(uint32_t c) {
+  stop();
+  color = c;
+  writeDuty(led::dutyForColor(c), 0);
+}
+
+void LedEffects::play(const led::Timeline &tl) {
+  stop();
+  if (tl.size() == 0) return;
+  timeline = tl;
+  playing = true;
+  startStep(0);
+}
+
+void LedEffects::stop() {
+  playing = false;
+  if (stepTimer) esp_timer_stop(stepTimer);
+}
+
+void LedEffects::onStepTimer(void *arg) {
+  auto *self = static_cast<LedEffects *>(arg);
+  if (!self->playing) return;
+
+  size_t next = self->stepIndex + 1;
+  if (next >= self->timeline.size()) {
+    if (!self->timeline.loops()) {
+      self->playing = false;
+      return;
+    }
+    next = 0;
+  }
+  self->startStep(next);
+}
+
+void LedEffects::startStep(size_t i) {
+  if (!ready) return;
+  const led::Step &s = timeline.step(i);
+  stepIndex = i;
+  color = s.color;
+  writeDuty(led::dutyForColor(s.color), s.fadeMs);
+
+  uint32_t stepMs = s.fadeMs + s.holdMs;
+  bool last = i + 1 >= timeline.size();
+  if (!last || timeline.loops()) {
+    esp_timer_start_once(stepTimer, (uint64_t)(stepMs > 0 ? stepMs : 1) * 1000);
+  } else {
+    // Final step of a one-shot effect: the hardware finishes the fade by itself
+    playing = false;
+  }
+}
+
+void LedEffects::writeDuty(const led::Duty &d, uint16_t fadeMs) {
+  if (!ready) return;
+  const uint16_t duty[3] = {d.r, d.g, d.b};
+  for (int i = 0; i < 3; i++) {
+    if (fadeMs == 0) {
+      ledc_set_duty(LED_MODE, LED_CHANNELS[i], duty[i]);
+      ledc_update_duty(LED_MODE, LED_CHANNELS[i]);
+    } else {
+      ledc_set_fade_with_time(LED_MODE, LED_CHANNELS[i], duty[i], fadeMs);
+      ledc_fade_start(LED_MODE, LED_CHANNELS[i], LEDC_FADE_NO_WAIT);
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <esp_timer.h>
+#include "LedTimeline.h"
+
+// RGB LED effects engine on the ESP32 LEDC peripheral.
+// Each step of a timeline is handed to the LEDC hardware fade unit, which
+// ramps the duty on its own; the CPU only runs one esp_timer callback per step
+// boundary to program the next one. Nothing needs to be called from loop().
+class LedEffects {
+public:
+  static LedEffects &getInstance();
+
+  LedEffects(const LedEffects &) = delete;
+  LedEffects &operator=(const LedEffects &) = delete;
+
+  // LEDs are active low, so the channels are configured with inverted output
+  void begin(uint8_t redPin, uint8_t greenPin, uint8_t bluePin);
+
+  // Gamma-corrected colour with no fade; cancels any running effect.
+  // Like play(), this waits for a hardware fade that is already in flight.
+  void setColor(uint8_t r, uint8_t g, uint8_t b);
+  void setColor(uint32_t color);
+
+  // Start an effect from the current colour. A fade already in flight on the
+  // hardware finishes first (at most one step's fadeMs)
+  void play(const led::Timeline &tl);
+  void stop();
+  bool isPlaying() const { return playing; }
+
+  uint32_t currentColor() const { return color; }
+
+private:
+  LedEffects() = default;
+
+  static void onStepTimer(void *arg);
+  void startStep(size_t i);
+  void writeDuty(const led::Duty &d, uint16_t fadeMs);
+
+  led::Timeline timeline;
+  size_t stepIndex = 0;
+  volatile bool playing = false;
+  bool ready = false;
+  uint32_t color = 0;
+  esp_timer_handle_t stepTimer = nullptr;
+};
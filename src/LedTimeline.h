@@ -0,0 +1,151 @@
+#pragma once
+
+// Hardware-independent description of an RGB LED effect, plus the gamma table
+// used to turn 8-bit colour values into LEDC duty. Nothing here touches the
+// ESP32, so the same timeline can be stepped through on the host
+// (see scripts/led_timeline_sim.cpp).
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace led {
+
+// LEDC duty resolution used for the RGB LED (13 bit at 5 kHz)
+constexpr uint8_t DutyBits = 13;
+constexpr uint16_t MaxDuty = (1u << DutyBits) - 1;
+
+// Gamma 2.2 correction, computed at compile time as x^2 * x^0.2
+// (fifth root by Newton's method, since std::pow isn't constexpr)
+constexpr double fifthRoot(double x) {
+  if (x <= 0.0) return 0.0;
+  double y = x < 1.0 ? 1.0 : x;
+  for (int i = 0; i < 40; i++) y = (4.0 * y + x / (y * y * y * y)) / 5.0;
+  return y;
+}
+
+struct GammaTable {
+  uint16_t duty[256];
+};
+
+constexpr GammaTable makeGammaTable() {
+  GammaTable t{};
+  for (int i = 0; i < 256; i++) {
+    double x = i / 255.0;
+    t.duty[i] = (uint16_t)(x * x * fifthRoot(x) * MaxDuty + 0.5);
+  }
+  return t;
+}
+
+inline constexpr GammaTable gammaTable = makeGammaTable();
+static_assert(gammaTable.duty[0] == 0, "gamma table must start dark");
+static_assert(gammaTable.duty[255] == MaxDuty, "gamma table must end at full duty");
+
+constexpr uint16_t gammaDuty(uint8_t v) { return gammaTable.duty[v]; }
+
+struct Duty {
+  uint16_t r, g, b;
+};
+
+constexpr Duty dutyForColor(uint32_t c) {
+  return Duty{gammaDuty((uint8_t)(c >> 16)), gammaDuty((uint8_t)(c >> 8)), gammaDuty((uint8_t)c)};
+}
+
+// One step of an effect: fade linearly (in duty) to `color` over fadeMs, then hold it
+struct Step {
+  uint32_t color;
+  uint16_t fadeMs;
+  uint16_t holdMs;
+};
+
+class Timeline {
+public:
+  static constexpr size_t MaxSteps = 8;
+
+  Timeline() = default;
+
+  void clear() { count = 0; }
+  bool add(uint32_t color, uint16_t fadeMs, uint16_t holdMs) {
+    if (count >= MaxSteps) return false;
+    steps[count++] = Step{color, fadeMs, holdMs};
+    return true;
+  }
+  void setLoop(bool l) { looping = l; }
+
+  size_t size() const { return count; }
+  const Step &step(size_t i) const { return steps[i]; }
+  bool loops() const { return looping; }
+
+  // Length of one pass through the steps
+  uint32_t durationMs() const {
+    uint32_t total = 0;
+    for (size_t i = 0; i < count; i++) total += steps[i].fadeMs + steps[i].holdMs;
+    return total;
+  }
+
+  // Duty the hardware is driving `t` ms after play() when the LED started at `from`.
+  // Mirrors the LEDC fade unit: a linear ramp in duty between gamma-corrected endpoints.
+  Duty sample(uint32_t t, uint32_t from) const {
+    Duty cur = dutyForColor(from);
+    uint32_t pass = durationMs();
+    if (count == 0) return cur;
+    if (looping && pass > 0 && t >= pass) {
+      // Every pass after the first starts from the last step's colour
+      cur = dutyForColor(steps[count - 1].color);
+      t %= pass;
+    }
+    for (size_t i = 0; i < count; i++) {
+      Duty to = dutyForColor(steps[i].color);
+      if (t < steps[i].fadeMs) {
+        return Duty{lerp(cur.r, to.r, t, steps[i].fadeMs), lerp(cur.g, to.g, t, steps[i].fadeMs),
+                    lerp(cur.b, to.b, t, steps[i].fadeMs)};
+      }
+      t -= steps[i].fadeMs;
+      cur = to;
+      if (t < steps[i].holdMs) return cur;
+      t -= steps[i].holdMs;
+    }
+    return cur;
+  }
+
+  // --- Ready-made effects ---
+
+  static Timeline fade(uint32_t color, uint16_t ms) {
+    Timeline tl;
+    tl.add(color, ms, 0);
+    return tl;
+  }
+
+  static Timeline breathe(uint32_t color, uint16_t periodMs) {
+    Timeline tl;
+    tl.add(color, periodMs / 2, 0);
+    tl.add(0x000000, periodMs - periodMs / 2, 0);
+    tl.setLoop(true);
+    return tl;
+  }
+
+  static Timeline blink(uint32_t color, uint16_t onMs, uint16_t offMs) {
+    Timeline tl;
+    tl.add(color, 0, onMs);
+    tl.add(0x000000, 0, offMs);
+    tl.setLoop(true);
+    return tl;
+  }
+
+  static Timeline sequence(const uint32_t *colors, size_t n, uint16_t fadeMs, uint16_t holdMs, bool loop = true) {
+    Timeline tl;
+    for (size_t i = 0; i < n; i++) tl.add(colors[i], fadeMs, holdMs);
+    tl.setLoop(loop);
+    return tl;
+  }
+
+private:
+  static uint16_t lerp(uint16_t a, uint16_t b, uint32_t t, uint32_t len) {
+    return (uint16_t)((int32_t)a + ((int32_t)b - (int32_t)a) * (int32_t)t / (int32_t)len);
+  }
+
+  Step steps[MaxSteps] = {};
+  size_t count = 0;
+  bool looping = false;
+};
+
+} // namespace led
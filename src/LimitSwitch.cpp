@@ -0,0 +1,86 @@
+#include "LimitSwitch.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+LimitSwitch::LimitSwitch(uint8_t pin, bool activeLow, uint32_t settleUs)
+    : pin(pin), activeLow(activeLow), deb(false, settleUs) {}
+
+void LimitSwitch::begin(Handler onChange, uint8_t mode) {
+  handler = onChange;
+  pinMode(pin, mode);
+  deb = Debounce(readPressed(), deb.settle(), deb.hold());
+
+  esp_timer_create_args_t args = {};
+  args.callback = onSettle;
+  args.arg = this;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "limit_sw";
+  esp_timer_create(&args, &timer);
+
+  attachInterruptArg(digitalPinToInterrupt(pin), edgeISR, this, CHANGE);
+}
+
+bool LimitSwitch::readPressed() const {
+  return (digitalRead(pin) == LOW) == activeLow;
+}
+
+// Only notes the time; the level is read once the contact has settled
+void IRAM_ATTR LimitSwitch::edgeISR(void *arg) {
+  LimitSwitch *self = static_cast<LimitSwitch *>(arg);
+  portENTER_CRITICAL_ISR(&self->lock);
+  bool start = self->deb.edge(esp_timer_get_time());
+  portEXIT_CRITICAL_ISR(&self->lock);
+  self->edgeCount++;
+  if (start) esp_timer_start_once(self->timer, self->deb.settle());
+}
+
+void LimitSwitch::onSettle(void *arg) {
+  LimitSwitch *self = static_cast<LimitSwitch *>(arg);
+  bool level = self->readPressed();
+  uint64_t now = esp_timer_get_time();
+  portENTER_CRITICAL(&self->lock);
+  Debounce::Result r = self->deb.expire(level, now);
+  uint32_t rearm = self->deb.rearmUs(now);
+  uint64_t firstEdge = self->deb.firstEdge();
+  portEXIT_CRITICAL(&self->lock);
+
+  Stats &st = self->st;
+  st.edges = self->edgeCount;
+  switch (r) {
+  case Debounce::CHANGED: {
+    if (self->handler) self->handler(level);
+    uint32_t us = esp_timer_get_time() - firstEdge;
+    if (level) {
+      st.presses++;
+      st.lastReactionUs = us;
+      st.totalReactionUs += us;
+      if (us > st.maxReactionUs) st.maxReactionUs = us;
+    } else {
+      st.releases++;
+    }
+    break;
+  }
+  case Debounce::REARM:
+    esp_timer_start_once(self->timer, rearm);
+    break;
+  case Debounce::GLITCH:
+    st.glitches++;
+    break;
+  default:
+    break;
+  }
+}
+
+bool LimitSwitch::takePress() {
+  uint32_t n = st.presses;
+  bool pressedSince = n != seenPresses;
+  seenPresses = n;
+  return pressedSince;
+}
+
+void LimitSwitch::report(Print &out) const {
+  reportf(out, "[limit] presses=%lu releases=%lu glitches=%lu edges=%lu reaction last=%luus mean=%luus max=%luus\n",
+               (unsigned long)st.presses, (unsigned long)st.releases, (unsigned long)st.glitches,
+               (unsigned long)st.edges, (unsigned long)st.lastReactionUs,
+               (unsigned long)(st.presses ? st.totalReactionUs / st.presses : 0), (unsigned long)st.maxReactionUs);
+}
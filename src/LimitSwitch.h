@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include "Debounce.h"
+
+class Print;
+
+// Interrupt-driven limit switch. A pin interrupt starts a short esp_timer
+// settle period (Debounce.h) and the handler runs from the timer as soon as
+// the new level is confirmed, typically ~1 ms after the contact closes,
+// however long loop() and lv_timer_handler() take. Use the handler for what
+// has to happen now (stopping or reversing the motor) and takePress() in
+// loop() for the UI. The handler runs in the esp_timer task, so it must not
+// block. The ESP32's GPIOs have no glitch filter; an RC filter on the switch
+// line reduces the edges the interrupt has to handle but isn't required.
+class LimitSwitch {
+public:
+  using Handler = void (*)(bool pressed);
+
+  struct Stats {
+    uint32_t presses = 0;
+    uint32_t releases = 0;
+    uint32_t glitches = 0;       // pulses shorter than the settle time
+    uint32_t edges = 0;          // pin interrupts, bounces included
+    uint32_t lastReactionUs = 0; // first edge until the handler returned
+    uint32_t maxReactionUs = 0;
+    uint64_t totalReactionUs = 0;
+  };
+
+  // Switches wired to ground with a pull-up read LOW when pressed
+  LimitSwitch(uint8_t pin, bool activeLow = true, uint32_t settleUs = 1000);
+
+  // GPIO 34-39 have no internal pull-ups; use an external resistor there
+  void begin(Handler onChange, uint8_t mode = INPUT_PULLUP);
+
+  bool pressed() const { return deb.level(); }
+  // True once for every press since the last call
+  bool takePress();
+
+  const Stats &stats() const { return st; }
+  void report(Print &out) const;
+
+private:
+  static void edgeISR(void *arg);
+  static void onSettle(void *arg);
+  bool readPressed() const;
+
+  uint8_t pin;
+  bool activeLow;
+  Handler handler = nullptr;
+  esp_timer_handle_t timer = nullptr;
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+  Debounce deb;
+  volatile uint32_t edgeCount = 0;
+  uint32_t seenPresses = 0;
+  Stats st;
+};
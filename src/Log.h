@@ -0,0 +1,27 @@
+#pragma once
+
+#include "LogSink.h"
+
+// Logging front end. By default lines are formatted on the device and queued
+// as text on the LogSink. Build with -DLOG_DEFERRED=1 to send binary records
+// instead (DeferredLog.h): the format strings stay on the host, in the table
+// scripts/intern_logs.py writes next to the firmware, and
+// scripts/telemetry_decode.py --strings expands them back into text.
+//
+// The format string must be a single string literal so the build script can
+// find it. Both modes filter on LogSink's level before doing any work.
+#ifndef LOG_DEFERRED
+#define LOG_DEFERRED 0
+#endif
+
+#if LOG_DEFERRED
+#include "DeferredLog.h"
+#define LOG_AT(level, fmt, ...) DEFERRED_LOG(level, fmt, ##__VA_ARGS__)
+#else
+#define LOG_AT(level, fmt, ...) LogSink::getInstance().log(level, fmt, ##__VA_ARGS__)
+#endif
+
+#define LOG_TRACE(fmt, ...) LOG_AT(LogSink::LEVEL_TRACE, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...) LOG_AT(LogSink::LEVEL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...) LOG_AT(LogSink::LEVEL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_ERROR(fmt, ...) LOG_AT(LogSink::LEVEL_ERROR, fmt, ##__VA_ARGS__)
@@ -0,0 +1,172 @@
+#include "LogSink.h"
+#include "ReportPrint.h"
+#include "SerialOwner.h"
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+LogSink &LogSink::getInstance() {
+  static LogSink instance;
+  return instance;
+}
+
+void LogSink::begin(Print &out, Level minLevel) {
+  port = &out;
+  level = minLevel;
+  if (!task) {
+    // Low priority on core 0; loop() runs on core 1 and never waits for the UART
+    xTaskCreatePinnedToCore(writerTask, "log", 3072, this, 1, &task, 0);
+  }
+  if (task) xTaskNotifyGive(task); // lines logged before begin()
+}
+
+void LogSink::log(Level lvl, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  vlog(lvl, fmt, args);
+  va_end(args);
+}
+
+void LogSink::vlog(Level lvl, const char *fmt, va_list args) {
+  if (!enabled(lvl)) {
+    st.filtered++;
+    return;
+  }
+  char line[MaxLine + 1];
+  int n = vsnprintf(line, sizeof(line), fmt, args);
+  if (n < 0) return;
+  if ((size_t)n >= sizeof(line)) {
+    st.truncated++;
+    n = sizeof(line) - 1;
+  }
+  if (n == 0 || line[n - 1] != '\n') {
+    if ((size_t)n == MaxLine) n--;
+    line[n++] = '\n';
+  }
+  enqueue(line, n);
+}
+
+void LogSink::write(Level lvl, const char *text) {
+  if (!enabled(lvl)) {
+    st.filtered++;
+    return;
+  }
+  size_t n = strlen(text);
+  if (n > MaxLine) {
+    st.truncated++;
+    n = MaxLine;
+  }
+  enqueue(text, n);
+}
+
+// Collects a line and queues it at the newline, or in MaxLine pieces
+class LogSink::LinePrint : public Print {
+public:
+  size_t write(uint8_t c) override {
+    line[len++] = (char)c;
+    if (c == '\n' || len == MaxLine) flushLine();
+    return 1;
+  }
+  size_t write(const uint8_t *buf, size_t size) override {
+    for (size_t i = 0; i < size; i++) write(buf[i]);
+    return size;
+  }
+
+private:
+  void flushLine() {
+    LogSink &sink = getInstance();
+    if (sink.enabled(LEVEL_USER)) sink.enqueue(line, len);
+    else sink.st.filtered++;
+    len = 0;
+  }
+
+  char line[MaxLine];
+  size_t len = 0;
+};
+
+Print &LogSink::printer() {
+  static LinePrint instance;
+  return instance;
+}
+
+void LogSink::lvglPrint(const char *buf) {
+  static const char *const prefixes[] = {"[Trace]", "[Info]", "[Warn]", "[Error]", "[User]"};
+  Level lvl = LEVEL_USER;
+  for (uint8_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+    if (strncmp(buf, prefixes[i], strlen(prefixes[i])) == 0) {
+      lvl = (Level)i;
+      break;
+    }
+  }
+  getInstance().write(lvl, buf);
+}
+
+// The whole line goes in or none of it, so a full ring never leaves half lines
+void LogSink::enqueue(const char *text, size_t len) {
+  bool queued = false;
+  portENTER_CRITICAL(&lock);
+  if (len <= RingSize - used) {
+    size_t at = head;
+    size_t first = RingSize - at < len ? RingSize - at : len;
+    memcpy(ring + at, text, first);
+    memcpy(ring, text + first, len - first);
+    head = (head + len) % RingSize;
+    used += len;
+    if (used > st.maxUsed) st.maxUsed = used;
+    st.lines++;
+    queued = true;
+  } else {
+    st.overflows++;
+  }
+  portEXIT_CRITICAL(&lock);
+  if (queued && task) xTaskNotifyGive(task);
+}
+
+void LogSink::writerTask(void *arg) {
+  LogSink *self = static_cast<LogSink *>(arg);
+  bool done = true;
+  for (;;) {
+    // While the port is busy with a frame or packet, try again a tick later
+    ulTaskNotifyTake(pdTRUE, done ? portMAX_DELAY : 1);
+    done = self->drain();
+  }
+}
+
+// Only this task removes data, so the bytes between tail and head stay put
+// while they are written without holding the lock. Returns false if lines
+// are left because another stream owns the port.
+bool LogSink::drain() {
+  for (;;) {
+    portENTER_CRITICAL(&lock);
+    size_t n = used;
+    size_t tail = (head + RingSize - used) % RingSize;
+    portEXIT_CRITICAL(&lock);
+    if (n == 0 || !port) return true;
+    if (!SerialOwner::claim(SerialOwner::WRITER_LOG)) return false;
+
+    if (n > RingSize - tail) n = RingSize - tail;
+    port->write((const uint8_t *)ring + tail, n);
+    // The ring holds whole lines, so this ends on a line unless it stopped at
+    // the end of the ring or in a piece of a long report line
+    if (ring[tail + n - 1] == '\n') SerialOwner::release(SerialOwner::WRITER_LOG);
+
+    portENTER_CRITICAL(&lock);
+    used -= n;
+    st.bytes += n;
+    portEXIT_CRITICAL(&lock);
+  }
+}
+
+void LogSink::flush(uint32_t timeoutMs) {
+  uint32_t start = millis();
+  while (used > 0 && millis() - start < timeoutMs) {
+    if (task || !drain()) delay(1);
+  }
+  if (port) port->flush();
+}
+
+void LogSink::report(Print &out) const {
+  reportf(out, "[log] lines=%lu filtered=%lu overflows=%lu truncated=%lu bytes=%lu ring max=%lu/%u\n",
+               (unsigned long)st.lines, (unsigned long)st.filtered, (unsigned long)st.overflows,
+               (unsigned long)st.truncated, (unsigned long)st.bytes, (unsigned long)st.maxUsed, (unsigned)RingSize);
+}
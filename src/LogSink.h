@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class Print;
+
+// Asynchronous log output. Callers copy each line into a fixed ring buffer
+// and return; a low priority background task writes the ring to the port, so
+// logging never waits for the UART (a 100 byte line takes ~9 ms at 115200
+// baud). Lines below the level are dropped before they are formatted, and a
+// line that doesn't fit in the ring is dropped whole and counted rather than
+// blocking. Safe to call from any task, but not from interrupts.
+//
+// The port is shared with Telemetry and ScreenCapture, so the writer task only
+// writes while it owns the port (SerialOwner.h) and gives it back at the end
+// of a line. Text printed straight to the port from elsewhere would land
+// inside their frames; report() output goes through printer() instead.
+class LogSink {
+public:
+  // Same order as LVGL's LV_LOG_LEVEL_* values
+  enum Level : uint8_t {
+    LEVEL_TRACE = 0,
+    LEVEL_INFO,
+    LEVEL_WARN,
+    LEVEL_ERROR,
+    LEVEL_USER,
+    LEVEL_NONE,
+  };
+
+  struct Stats {
+    uint32_t lines = 0;      // queued
+    uint32_t filtered = 0;   // below the level
+    uint32_t overflows = 0;  // dropped because the ring was full
+    uint32_t truncated = 0;  // longer than MaxLine
+    uint32_t bytes = 0;      // written to the port
+    uint32_t maxUsed = 0;    // ring high-water mark
+  };
+
+  static constexpr size_t RingSize = 4096;
+  static constexpr size_t MaxLine = 160;
+
+  static LogSink &getInstance();
+
+  LogSink(const LogSink &) = delete;
+  LogSink &operator=(const LogSink &) = delete;
+
+  // Starts the writer task; lines logged before this are kept in the ring
+  void begin(Print &out, Level minLevel = LEVEL_INFO);
+
+  void setLevel(Level lvl) { level = lvl; }
+  bool enabled(Level lvl) const { return lvl >= level && lvl < LEVEL_NONE; }
+
+  // Format and queue a line (a newline is added if missing)
+  void log(Level lvl, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+  void vlog(Level lvl, const char *fmt, va_list args);
+  // Queue preformatted text
+  void write(Level lvl, const char *text);
+
+  // Print that queues whatever is written to it at LEVEL_USER, a line at a
+  // time, for report(Print &) output. Lines longer than MaxLine go out in
+  // pieces. Only for one task (loop()).
+  Print &printer();
+
+  // LVGL print callback; takes the level from the "[Warn]" style prefix
+  static void lvglPrint(const char *buf);
+
+  // Block until everything queued has been written, e.g. before a restart
+  void flush(uint32_t timeoutMs = 1000);
+
+  // Lines queued and not yet written
+  bool pending() const { return used > 0; }
+  const Stats &stats() const { return st; }
+  void report(Print &out) const;
+
+private:
+  LogSink() = default;
+
+  class LinePrint;
+
+  void enqueue(const char *text, size_t len);
+  static void writerTask(void *arg);
+  bool drain();
+
+  Print *port = nullptr;
+  volatile Level level = LEVEL_INFO;
+  TaskHandle_t task = nullptr;
+  portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+  char ring[RingSize];
+  size_t head = 0; // next byte to write into
+  size_t used = 0;
+
+  Stats st;
+};
@@ -23,6 +23,9 @@
  */
 
 #include "MainInterface.h"
+#include "SensorManager.h"
+#include "MemoryMonitor.h"
+#include <math.h>
 #include <stdio.h>
 
 /**
@@ -35,6 +38,10 @@ MainInterface::MainInterface()
   headerContainer = nullptr;
   headerLabel = nullptr;
   tempLabel = nullptr;
+  humidityLabel = nullptr;
+  trendButton = nullptr;
+  chartScreen = nullptr;
+  history = nullptr;
 }
 
 /**
@@ -52,6 +59,8 @@ MainInterface::~MainInterface()
  */
 void MainInterface::init()
 {
+  MemoryMonitor::Scope tag(MemoryMonitor::TAG_UI);
+
   // Create main screen container
   mainScreen = lv_obj_create(NULL);
   // Set portrait orientation (240x320)
@@ -69,19 +78,35 @@ void MainInterface::init()
   // Create UI components in order (top to bottom)
   createHeader();
 
+  // Pre-render the value glyphs (white on the black screen background) so
+  // changing a reading is a straight blit instead of re-rasterising the font
+  valueGlyphs.build(&lv_font_montserrat_28, lv_color_hex(0xFFFFFF), lv_color_hex(0x000000));
+
   // Create temperature display directly on mainScreen
   tempLabel = lv_label_create(mainScreen);
   lv_obj_set_style_text_font(tempLabel, &lv_font_montserrat_28, 0);
   lv_obj_set_style_text_color(tempLabel, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
-  lv_label_set_text(tempLabel, "Temperature:\n--.-°C");
+  lv_label_set_text(tempLabel, "Temperature:");
   lv_obj_align(tempLabel, LV_ALIGN_TOP_MID, 0, 50);
+  tempValue.create(mainScreen, valueGlyphs, 200);
+  tempValue.setText("--.-°C");
 
   // Create humidity display directly on mainScreen
   humidityLabel = lv_label_create(mainScreen);
   lv_obj_set_style_text_font(humidityLabel, &lv_font_montserrat_28, 0);
   lv_obj_set_style_text_color(humidityLabel, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
-  lv_label_set_text(humidityLabel, "Humidity:\n--.-%");
+  lv_label_set_text(humidityLabel, "Humidity:");
   lv_obj_align_to(humidityLabel, tempLabel, LV_ALIGN_OUT_BOTTOM_MID, 0, 20);
+  humidityValue.create(mainScreen, valueGlyphs, 200);
+  humidityValue.setText("--.-%");
+
+  // Button to switch to the trend chart
+  trendButton = lv_btn_create(mainScreen);
+  lv_obj_t *trendLabel = lv_label_create(trendButton);
+  lv_label_set_text(trendLabel, "Trend");
+  lv_obj_add_event_cb(trendButton, showChart, LV_EVENT_CLICKED, this);
+
+  createChartScreen();
 
   // Activate the screen
   lv_scr_load(mainScreen);
@@ -110,6 +135,57 @@ void MainInterface::createHeader()
   lv_obj_set_style_text_color(headerLabel, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
 }
 
+/**
+ * Creates the trend chart screen
+ * The chart keeps its own pixel buffer and is updated column by column,
+ * so it keeps sweeping in the background while the main screen is shown
+ */
+void MainInterface::createChartScreen()
+{
+  chartScreen = lv_obj_create(NULL);
+  lv_obj_set_size(chartScreen, 240, 320);
+  lv_obj_set_style_bg_color(chartScreen, lv_color_hex(0x000000), LV_PART_MAIN);
+  lv_obj_set_style_pad_all(chartScreen, 0, 0);
+  lv_obj_clear_flag(chartScreen, LV_OBJ_FLAG_SCROLLABLE);
+
+  lv_obj_t *title = lv_label_create(chartScreen);
+  lv_obj_set_style_text_color(title, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+  lv_label_set_text(title, "Trend");
+  lv_obj_align(title, LV_ALIGN_TOP_MID, 0, 10);
+
+  // Temperature 0-50 °C in orange, humidity 0-100 % in blue
+  lv_obj_t *chart = trendChart.create(chartScreen);
+  trendChart.setSeries(0, lv_color_hex(0xFF8C00), 0.0f, 50.0f);
+  trendChart.setSeries(1, lv_color_hex(0x1E90FF), 0.0f, 100.0f);
+  if (chart)
+  {
+    lv_obj_align(chart, LV_ALIGN_TOP_MID, 0, 40);
+  }
+
+  lv_obj_t *legend = lv_label_create(chartScreen);
+  lv_obj_set_style_text_color(legend, lv_color_hex(0xFFFFFF), LV_PART_MAIN);
+  lv_label_set_text(legend, "Temp 0-50°C / Humidity 0-100%");
+  lv_obj_align(legend, LV_ALIGN_TOP_MID, 0, 150);
+
+  lv_obj_t *back = lv_btn_create(chartScreen);
+  lv_obj_t *backLabel = lv_label_create(back);
+  lv_label_set_text(backLabel, "Back");
+  lv_obj_align(back, LV_ALIGN_BOTTOM_MID, 0, -20);
+  lv_obj_add_event_cb(back, showMain, LV_EVENT_CLICKED, this);
+}
+
+void MainInterface::showChart(lv_event_t *e)
+{
+  MainInterface *self = static_cast<MainInterface *>(lv_event_get_user_data(e));
+  lv_scr_load(self->chartScreen);
+}
+
+void MainInterface::showMain(lv_event_t *e)
+{
+  MainInterface *self = static_cast<MainInterface *>(lv_event_get_user_data(e));
+  lv_scr_load(self->mainScreen);
+}
+
 /**
  * Creates the scrollable content area
  * This area fills the remaining space below header
@@ -123,19 +199,52 @@ void MainInterface::createHeader()
 
 void MainInterface::update()
 {
-  // Placeholder: update logic if needed
+  // Append any new sensor readings to the trend chart
+  if (history)
+  {
+    trendChart.poll(*history);
+  }
+}
+
+void MainInterface::setHistory(const SensorManager *sensors)
+{
+  history = sensors;
+}
+
+/**
+ * Sensor values are clamped to what fits the readout, and a missing
+ * reading shows dashes, so every value is drawn from the glyph cache
+ * with a bounded width
+ */
+static float clampReading(float v, float lo, float hi)
+{
+  return v < lo ? lo : (v > hi ? hi : v);
 }
 
 void MainInterface::setTemperature(float tempC)
 {
-  char buf[32];
-  snprintf(buf, sizeof(buf), "Temperature:\n%.1f°C", tempC);
-  lv_label_set_text(tempLabel, buf);
+  char buf[GlyphReadout::MaxText];
+  if (isnan(tempC))
+  {
+    snprintf(buf, sizeof(buf), "--.-°C");
+  }
+  else
+  {
+    snprintf(buf, sizeof(buf), "%.1f°C", clampReading(tempC, -99.9f, 999.9f));
+  }
+  tempValue.setText(buf);
 }
 
 void MainInterface::setHumidity(float humidity)
 {
-  char buf[32];
-  snprintf(buf, sizeof(buf), "Humidity:\n%.1f%%", humidity);
-  lv_label_set_text(humidityLabel, buf);
+  char buf[GlyphReadout::MaxText];
+  if (isnan(humidity))
+  {
+    snprintf(buf, sizeof(buf), "--.-%%");
+  }
+  else
+  {
+    snprintf(buf, sizeof(buf), "%.1f%%", clampReading(humidity, 0.0f, 100.0f));
+  }
+  humidityValue.setText(buf);
 }
@@ -25,6 +25,10 @@
 
 #include <lvgl.h>
 #include <string>
+#include "GlyphCache.h"
+#include "TrendChart.h"
+
+class SensorManager;
 
 using std::string;
 
@@ -41,8 +45,22 @@ private:
   lv_obj_t *tempLabel;
   lv_obj_t *humidityLabel;
 
+  // Sensor values are drawn from pre-rendered glyphs
+  GlyphCache valueGlyphs;
+  GlyphReadout tempValue;
+  GlyphReadout humidityValue;
+
+  // Trend screen: temperature and humidity history
+  lv_obj_t *trendButton;
+  lv_obj_t *chartScreen;
+  TrendChart trendChart;
+  const SensorManager *history;
+
   // Helper Methods
   void createHeader();
+  void createChartScreen();
+  static void showChart(lv_event_t *e);
+  static void showMain(lv_event_t *e);
 
 public:
   MainInterface();
@@ -54,6 +72,9 @@ public:
   // Methods to update sensor values
   void setTemperature(float tempC);
   void setHumidity(float humidity);
+
+  // Source for the trend chart; new readings are pulled in update()
+  void setHistory(const SensorManager *sensors);
 };
 
 #endif // MAIN_INTERFACE_H
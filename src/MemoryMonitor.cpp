@@ -0,0 +1,212 @@
+#include "MemoryMonitor.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <lvgl.h>
+#include "EventBus.h"
+#include "Events.h"
+#include "ReportPrint.h"
+
+MemoryMonitor &MemoryMonitor::getInstance() {
+  static MemoryMonitor instance;
+  return instance;
+}
+
+const char *MemoryMonitor::tagName(Tag tag) {
+  static const char *const names[TagCount] = {"TemplateCode", "SensorManager", "MainInterface", "storage", "images"};
+  return tag < TagCount ? names[tag] : "?";
+}
+
+uint32_t MemoryMonitor::heapFree() {
+  return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+// 0 before lv_init(), when the pool can't be walked yet
+uint32_t MemoryMonitor::lvglFree() {
+  if (!lv_is_initialized()) return 0;
+  lv_mem_monitor_t mon;
+  lv_mem_monitor(&mon);
+  return mon.free_size;
+}
+
+MemoryMonitor::Scope::Scope(Tag tag) : tag(tag), heapFree(MemoryMonitor::heapFree()), lvglFree(MemoryMonitor::lvglFree()) {
+  MemoryMonitor &m = getInstance();
+  outer = m.innermost;
+  m.innermost = this;
+}
+
+MemoryMonitor::Scope::~Scope() {
+  MemoryMonitor &m = getInstance();
+  int32_t heapUsed = (int32_t)(heapFree - MemoryMonitor::heapFree());
+  uint32_t lvglNow = MemoryMonitor::lvglFree();
+  // A scope that ran lv_init() has no pool reading to compare against
+  int32_t lvglUsed = lvglFree && lvglNow ? (int32_t)(lvglFree - lvglNow) : 0;
+
+  TagStats &t = m.tags[tag];
+  t.heapBytes += heapUsed - nestedHeap;
+  t.lvglBytes += lvglUsed - nestedLvgl;
+  if (t.heapBytes > t.heapPeak) t.heapPeak = t.heapBytes;
+
+  if (outer) {
+    outer->nestedHeap += heapUsed;
+    outer->nestedLvgl += lvglUsed;
+  }
+  m.innermost = outer;
+}
+
+void MemoryMonitor::attribute(Tag tag, int32_t heapBytes) {
+  TagStats &t = tags[tag];
+  t.heapBytes += heapBytes;
+  if (t.heapBytes > t.heapPeak) t.heapPeak = t.heapBytes;
+  if (innermost) innermost->nestedHeap += heapBytes;
+}
+
+void MemoryMonitor::begin(const Thresholds &thresholds) {
+  limits = thresholds;
+  watchTask(xTaskGetCurrentTaskHandle(), "loop");
+  sample();
+}
+
+bool MemoryMonitor::watchTask(const char *name) {
+  return watchTask(xTaskGetHandle(name), name);
+}
+
+bool MemoryMonitor::watchTask(TaskHandle_t task, const char *name) {
+  if (!task || taskCount >= MaxTasks) return false;
+  tasks[taskCount++] = {task, name, UINT32_MAX};
+  return true;
+}
+
+const MemoryMonitor::Sample &MemoryMonitor::sample() {
+  Sample &s = history[head];
+  s.ms = millis();
+  s.freeHeap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  s.largestBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  s.minFreeHeap = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+
+  s.lvglFree = 0;
+  s.lvglUsedPct = 0;
+  s.lvglFragPct = 0;
+  if (lv_is_initialized()) {
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    s.lvglFree = mon.free_size;
+    s.lvglUsedPct = mon.used_pct;
+    s.lvglFragPct = mon.frag_pct;
+  }
+
+  // The ESP-IDF port reports the high-water mark in bytes
+  s.minStackFree = UINT16_MAX;
+  for (size_t i = 0; i < taskCount; i++) {
+    uint32_t free = uxTaskGetStackHighWaterMark(tasks[i].task);
+    tasks[i].minFree = free;
+    if (free < s.minStackFree) s.minStackFree = free;
+  }
+
+  head = (head + 1) % HistorySize;
+  if (count < HistorySize) count++;
+  check(s);
+  return s;
+}
+
+int32_t MemoryMonitor::trendBytesPerMin() const {
+  if (count < 2) return 0;
+  size_t first = (head + HistorySize - count) % HistorySize;
+  uint32_t t0 = history[first].ms;
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for (size_t i = 0; i < count; i++) {
+    const Sample &s = history[(first + i) % HistorySize];
+    double x = (double)(uint32_t)(s.ms - t0);
+    double y = s.freeHeap;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  double d = count * sxx - sx * sx;
+  if (d <= 0) return 0;
+  return (int32_t)((count * sxy - sx * sy) / d * 60000.0);
+}
+
+// Each alarm clears only once the value is back past the limit by 1/8, so a
+// value hovering around a threshold doesn't raise it on every sample
+void MemoryMonitor::check(const Sample &s) {
+  auto under = [&](Alarm a, uint32_t value, uint32_t limit) {
+    return value < ((active & a) ? limit + limit / 8 : limit);
+  };
+
+  raise(ALARM_HEAP_LOW, under(ALARM_HEAP_LOW, s.freeHeap, limits.minFreeHeap), s.freeHeap, limits.minFreeHeap);
+  raise(ALARM_FRAGMENTED, under(ALARM_FRAGMENTED, s.largestBlock, limits.minLargestBlock), s.largestBlock,
+        limits.minLargestBlock);
+
+  uint32_t lvglLimit = (active & ALARM_LVGL_FULL) ? limits.maxLvglUsedPct * 7 / 8 : limits.maxLvglUsedPct;
+  raise(ALARM_LVGL_FULL, s.lvglUsedPct > lvglLimit, s.lvglUsedPct, limits.maxLvglUsedPct);
+
+  const Watched *lowest = nullptr;
+  for (size_t i = 0; i < taskCount; i++) {
+    if (!lowest || tasks[i].minFree < lowest->minFree) lowest = &tasks[i];
+  }
+  if (lowest) {
+    raise(ALARM_STACK_LOW, under(ALARM_STACK_LOW, lowest->minFree, limits.minStackFree), lowest->minFree,
+          limits.minStackFree, lowest->name);
+  }
+
+  // Only trust the trend once half the history is filled
+  int32_t perMin = trendBytesPerMin();
+  bool leaking = false;
+  uint32_t secondsLeft = UINT32_MAX;
+  if (count >= HistorySize / 2 && perMin < 0 && s.freeHeap > limits.minFreeHeap) {
+    secondsLeft = (uint32_t)((uint64_t)(s.freeHeap - limits.minFreeHeap) * 60 / (uint32_t)-perMin);
+    uint32_t horizon = (active & ALARM_HEAP_TREND) ? limits.trendHorizonS + limits.trendHorizonS / 8
+                                                   : limits.trendHorizonS;
+    leaking = secondsLeft < horizon;
+  }
+  raise(ALARM_HEAP_TREND, leaking, secondsLeft, limits.trendHorizonS);
+}
+
+void MemoryMonitor::raise(Alarm alarm, bool on, uint32_t value, uint32_t limit, const char *task) {
+  bool was = active & alarm;
+  if (on == was) return;
+  if (on) {
+    active |= alarm;
+    alarmCount++;
+  } else {
+    active &= ~alarm;
+  }
+  MemoryAlarm e;
+  e.alarm = alarm;
+  e.active = on;
+  e.value = value;
+  e.limit = limit;
+  e.task = task;
+  EventBus::publish(e);
+}
+
+void MemoryMonitor::exportCsv(Print &out) const {
+  out.print("ms,free_heap,largest_block,min_free_heap,lvgl_free,lvgl_used_pct,lvgl_frag_pct,min_stack_free\n");
+  size_t first = (head + HistorySize - count) % HistorySize;
+  for (size_t i = 0; i < count; i++) {
+    const Sample &s = history[(first + i) % HistorySize];
+    reportf(out, "%lu,%lu,%lu,%lu,%lu,%u,%u,%u\n", (unsigned long)s.ms, (unsigned long)s.freeHeap,
+                 (unsigned long)s.largestBlock, (unsigned long)s.minFreeHeap, (unsigned long)s.lvglFree,
+                 (unsigned)s.lvglUsedPct, (unsigned)s.lvglFragPct, (unsigned)s.minStackFree);
+  }
+}
+
+void MemoryMonitor::report(Print &out) const {
+  if (count == 0) return;
+  const Sample &s = last();
+  reportf(out, "[mem] heap free=%lu min=%lu largest=%lu trend=%ldB/min lvgl used=%u%% frag=%u%% free=%lu "
+               "alarms=0x%02x raised=%lu\n",
+               (unsigned long)s.freeHeap, (unsigned long)s.minFreeHeap, (unsigned long)s.largestBlock,
+               (long)trendBytesPerMin(), (unsigned)s.lvglUsedPct, (unsigned)s.lvglFragPct, (unsigned long)s.lvglFree,
+               (unsigned)active, (unsigned long)alarmCount);
+  out.print("[mem] stack free");
+  for (size_t i = 0; i < taskCount; i++) {
+    reportf(out, " %s=%lu", tasks[i].name, (unsigned long)tasks[i].minFree);
+  }
+  out.print("\n[mem] held heap/lvgl");
+  for (uint8_t t = 0; t < TagCount; t++) {
+    reportf(out, " %s=%ld/%ld", tagName((Tag)t), (long)tags[t].heapBytes, (long)tags[t].lvglBytes);
+  }
+  out.print("\n");
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class Print;
+
+// Heap, LVGL pool and task stack monitoring. sample() is called periodically
+// (a scheduler task in main.cpp) and records free heap, the largest free
+// block (fragmentation), the lowest free heap ever seen, LVGL pool use and the
+// stack high-water mark of each watched task. Samples are kept in a short
+// history, used to fit a free heap trend and exported with exportCsv() or as
+// telemetry. Crossing a threshold raises a MemoryAlarm event, and so does a
+// falling trend that will reach the free heap threshold within the horizon,
+// so a slow leak is reported well before allocations start to fail.
+//
+// Allocations are attributed to subsystems with a Scope around the code that
+// makes them: the change in free heap and LVGL pool over the scope is added
+// to its tag (minus what nested scopes claimed). This works from heap totals,
+// not by hooking malloc, so other tasks allocating at the same time would be
+// counted too; in practice only loop() allocates. Each scope walks the LVGL
+// pool twice, so code on the render path reports its own allocations with
+// attribute() instead.
+class MemoryMonitor {
+public:
+  enum Tag : uint8_t {
+    TAG_TEMPLATE, // TemplateCode: display, touch, LVGL setup
+    TAG_SENSORS,  // SensorManager
+    TAG_UI,       // MainInterface screens, trend chart, glyph cache
+    TAG_STORAGE,  // FileManager, SD card
+    TAG_IMAGES,   // CompressedImage cache and streaming buffers
+    TagCount
+  };
+
+  enum Alarm : uint8_t {
+    ALARM_HEAP_LOW = 1 << 0,   // free heap under minFreeHeap
+    ALARM_FRAGMENTED = 1 << 1, // largest free block under minLargestBlock
+    ALARM_LVGL_FULL = 1 << 2,  // LVGL pool use over maxLvglUsedPct
+    ALARM_STACK_LOW = 1 << 3,  // a watched task has less than minStackFree left
+    ALARM_HEAP_TREND = 1 << 4, // free heap will reach minFreeHeap within trendHorizonS
+  };
+
+  struct Thresholds {
+    uint32_t minFreeHeap = 24 * 1024;
+    uint32_t minLargestBlock = 8 * 1024;
+    uint8_t maxLvglUsedPct = 85;
+    uint32_t minStackFree = 512; // bytes
+    uint32_t trendHorizonS = 600;
+  };
+
+  struct Sample {
+    uint32_t ms;
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+    uint32_t minFreeHeap; // lowest since boot
+    uint32_t lvglFree;
+    uint8_t lvglUsedPct;
+    uint8_t lvglFragPct;
+    uint16_t minStackFree; // smallest high-water mark of the watched tasks
+  };
+
+  struct TagStats {
+    int32_t heapBytes = 0; // net bytes held
+    int32_t lvglBytes = 0;
+    int32_t heapPeak = 0;
+  };
+
+  // Counts bytes allocated while it is alive against a tag
+  class Scope {
+  public:
+    explicit Scope(Tag tag);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    friend class MemoryMonitor;
+    Tag tag;
+    uint32_t heapFree;
+    uint32_t lvglFree;
+    int32_t nestedHeap = 0;
+    int32_t nestedLvgl = 0;
+    Scope *outer;
+  };
+
+  static constexpr size_t HistorySize = 32;
+  static constexpr size_t MaxTasks = 6;
+
+  static MemoryMonitor &getInstance();
+
+  MemoryMonitor(const MemoryMonitor &) = delete;
+  MemoryMonitor &operator=(const MemoryMonitor &) = delete;
+
+  // Watches the calling task (loop()) and takes the first sample
+  void begin() { begin(Thresholds()); }
+  void begin(const Thresholds &limits);
+  // By name (e.g. "log", "esp_timer") or handle; false if unknown or full
+  bool watchTask(const char *name);
+  bool watchTask(TaskHandle_t task, const char *name);
+
+  const Sample &sample();
+  const Sample &last() const { return history[(head + HistorySize - 1) % HistorySize]; }
+
+  // Least squares slope of free heap over the history, bytes per minute
+  int32_t trendBytesPerMin() const;
+  uint8_t alarms() const { return active; }
+  const TagStats &tagStats(Tag tag) const { return tags[tag]; }
+  // Adds heap bytes allocated (or, negative, freed) to a tag directly. An
+  // enclosing Scope leaves them out of its own tag.
+  void attribute(Tag tag, int32_t heapBytes);
+  static const char *tagName(Tag tag);
+
+  // History as CSV, oldest first
+  void exportCsv(Print &out) const;
+  void report(Print &out) const;
+
+private:
+  struct Watched {
+    TaskHandle_t task;
+    const char *name;
+    uint32_t minFree;
+  };
+
+  MemoryMonitor() = default;
+
+  static uint32_t heapFree();
+  static uint32_t lvglFree();
+  void check(const Sample &s);
+  void raise(Alarm alarm, bool on, uint32_t value, uint32_t limit, const char *task = nullptr);
+
+  Thresholds limits;
+  Sample history[HistorySize] = {};
+  size_t head = 0;
+  size_t count = 0;
+  Watched tasks[MaxTasks] = {};
+  size_t taskCount = 0;
+  TagStats tags[TagCount];
+  Scope *innermost = nullptr;
+  uint8_t active = 0;
+  uint32_t alarmCount = 0;
+};
@@ -1,13 +1,31 @@
 #include "PeriodicScheduler.h"
+#include "EventBus.h"
+#include "Events.h"
+#include <algorithm>
+#ifdef ARDUINO
 #include <Arduino.h>
+#include "ReportPrint.h"
+#else
+// Host builds (scripts/scheduler_sim.cpp) supply the clock
+unsigned long millis();
+unsigned long micros();
+#endif
 
-int PeriodicScheduler::addTask(Task cb, uint32_t intervalMs) {
+int PeriodicScheduler::addTask(Task cb, uint32_t intervalMs, const char *name, Priority priority, uint32_t costUs) {
+#if STATIC_ALLOC
+  if (tasks.full()) return -1;
+#endif
   Entry e;
   e.cb = cb;
   e.interval = intervalMs;
   e.lastRun = millis();
   e.active = true;
+  e.priority = priority;
+  e.estimateUs = costUs;
+  e.slack = 0;
+  e.name = name;
   tasks.push_back(e);
+  due.reserve(tasks.size());
   return (int)tasks.size() - 1;
 }
 
@@ -16,13 +34,163 @@ void PeriodicScheduler::removeTask(int id) {
   tasks[id].active = false;
 }
 
-void PeriodicScheduler::update(uint32_t now) {
+void PeriodicScheduler::setSlack(int id, uint32_t slackMs) {
+  if (id < 0 || id >= (int)tasks.size()) return;
+  Entry &e = tasks[id];
+  e.slack = slackMs;
+  // Put the task on a grid of its interval so tasks with related intervals
+  // (100, 500, 2000 ms...) come due at the same moments
+  if (slackMs && e.interval) {
+    uint32_t now = millis();
+    e.lastRun = now - now % e.interval;
+  }
+}
+
+#if SCHEDULER_STATS
+static uint8_t jitterBucket(uint32_t lateMs) {
+  uint8_t b = 0;
+  while (lateMs && b < PeriodicScheduler::JitterBuckets - 1) {
+    lateMs >>= 1;
+    b++;
+  }
+  return b;
+}
+#endif
+
+void PeriodicScheduler::update(uint32_t now, uint32_t availableUs) {
+  if (now == 0) now = millis();
+
+  due.clear();
+  for (size_t i = 0; i < tasks.size(); i++) {
+    const Entry &e = tasks[i];
+    if (e.active && (uint32_t)(now - e.lastRun) >= e.interval) due.push_back((int)i);
+  }
+  if (due.empty()) return;
+
+  // Highest priority first, then the task that is furthest behind
+  std::sort(due.begin(), due.end(), [&](int a, int b) {
+    const Entry &ea = tasks[a];
+    const Entry &eb = tasks[b];
+    if (ea.priority != eb.priority) return ea.priority < eb.priority;
+    return (now - ea.lastRun - ea.interval) > (now - eb.lastRun - eb.interval);
+  });
+
+  uint32_t limit = budget ? budget : UINT32_MAX;
+  if (availableUs < limit) limit = availableUs;
+  uint32_t start = micros();
+  bool ranAny = false;
+  bool deferred = false;
+  if (!carrying) batchRuns = batchSlackRuns = batchAvoided = 0;
+
+  for (int id : due) {
+    Entry &e = tasks[id];
+    // Earlier tasks in this pass take time, so each one is measured (and
+    // rescheduled) from when it actually starts, not from the top of update()
+    uint32_t at = millis();
+    if ((int32_t)(at - now) < 0) at = now;
+    uint32_t late = at - e.lastRun - e.interval;
+    uint32_t spent = micros() - start;
+    bool fits = spent + e.estimateUs <= limit || (!ranAny && limit == budget);
+    bool starving = late >= e.interval;
+    if (e.priority != PRIORITY_HIGH && !fits && !starving) {
+      // Stays due; picked up again by the next update()
+#if SCHEDULER_STATS
+      e.st.deferrals++;
+#endif
+      deferred = true;
+      continue;
+    }
+    if (slackOn && e.slack && late > 0 && late <= e.slack) batchSlackRuns++;
+    run(e, at, late);
+    ranAny = true;
+    runCount++;
+    batchRuns++;
+  }
+  // Work carried over runs on the next pass without sleeping, so it is part
+  // of the same wakeup
+  if (ranAny && !carrying) batchCount++;
+  uint32_t avoided = std::min(batchSlackRuns, batchRuns ? batchRuns - 1 : 0);
+  avoidedCount += avoided - batchAvoided;
+  batchAvoided = avoided;
+  carrying = deferred;
+}
+
+void PeriodicScheduler::run(Entry &e, uint32_t now, uint32_t late) {
+  if (e.slack == 0 || e.interval == 0) {
+    e.lastRun = now;
+  } else if (late <= e.slack) {
+    e.lastRun = now - late; // ran within its slack: keep the grid phase
+  } else {
+    e.lastRun = now - now % e.interval; // fell well behind: back onto the grid
+  }
+  if (!e.cb) return;
+  uint32_t start = micros();
+  e.cb();
+  uint32_t exec = micros() - start;
+
+  // Queued so listeners don't run inside the scheduler's budget
+  if (e.interval && exec > e.interval * 1000) EventBus::post(TaskOverrun{e.name, exec, e.interval});
+
+  // Follow the measured cost, rising quickly and decaying slowly
+  e.estimateUs = exec > e.estimateUs ? (e.estimateUs + exec) / 2 : e.estimateUs - (e.estimateUs - exec) / 8;
+
+#if SCHEDULER_STATS
+  TaskStats &s = e.st;
+  s.runs++;
+  s.execTotalUs += exec;
+  if (exec < s.execMinUs) s.execMinUs = exec;
+  if (exec > s.execMaxUs) s.execMaxUs = exec;
+  if (e.interval && exec > e.interval * 1000) s.overruns++;
+  if (e.interval) s.missedPeriods += late / e.interval;
+  if (late > s.jitterMaxMs) s.jitterMaxMs = late;
+  s.jitter[jitterBucket(late)]++;
+#else
+  (void)late;
+#endif
+}
+
+uint32_t PeriodicScheduler::msUntilNextDue(uint32_t now) const {
   if (now == 0) now = millis();
+  uint32_t best = UINT32_MAX;
   for (auto &e : tasks) {
     if (!e.active) continue;
-    if ((uint32_t)(now - e.lastRun) >= e.interval) {
-      e.lastRun = now;
-      if (e.cb) e.cb();
+    uint32_t elapsed = now - e.lastRun;
+    if (elapsed >= e.interval) return 0; // due and still waiting (deferred by the budget)
+    uint32_t left = e.interval - elapsed + (slackOn ? e.slack : 0);
+    if (left < best) best = left;
+  }
+  return best;
+}
+
+#if SCHEDULER_STATS
+const PeriodicScheduler::TaskStats *PeriodicScheduler::stats(int id) const {
+  if (id < 0 || id >= (int)tasks.size()) return nullptr;
+  return &tasks[id].st;
+}
+
+void PeriodicScheduler::resetStats() {
+  for (auto &e : tasks) e.st = TaskStats();
+}
+#endif
+
+void PeriodicScheduler::dumpStats(Print &out) const {
+#if SCHEDULER_STATS && defined(ARDUINO)
+  for (size_t i = 0; i < tasks.size(); i++) {
+    const Entry &e = tasks[i];
+    const TaskStats &s = e.st;
+    reportf(out, "[sched] %s every=%lums slack=%lums runs=%lu exec min/avg/max=%lu/%lu/%luus est=%luus overruns=%lu missed=%lu deferred=%lu jitter max=%lums hist=",
+                 e.name ? e.name : "task", (unsigned long)e.interval, (unsigned long)e.slack, (unsigned long)s.runs,
+                 (unsigned long)(s.runs ? s.execMinUs : 0), (unsigned long)s.execMeanUs(), (unsigned long)s.execMaxUs,
+                 (unsigned long)e.estimateUs, (unsigned long)s.overruns, (unsigned long)s.missedPeriods,
+                 (unsigned long)s.deferrals, (unsigned long)s.jitterMaxMs);
+    for (uint8_t b = 0; b < JitterBuckets; b++) {
+      reportf(out, b ? ",%lu" : "%lu", (unsigned long)s.jitter[b]);
     }
+    out.print("\n");
   }
+  reportf(out, "[sched] batches=%lu runs=%lu wakeups avoided=%lu\n", (unsigned long)batchCount,
+               (unsigned long)runCount, (unsigned long)wakeupsAvoided());
+#else
+  (void)out;
+#endif
 }
@@ -3,19 +3,113 @@
 #include <functional>
 #include <vector>
 #include <stdint.h>
+#include "StaticAlloc.h"
 
+// Per-task timing statistics; build with -DSCHEDULER_STATS=0 to compile them out
+#ifndef SCHEDULER_STATS
+#define SCHEDULER_STATS 1
+#endif
+
+// Task table size in STATIC_ALLOC builds, where it can't grow
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 16
+#endif
+
+class Print;
+
+// Cooperative periodic tasks for loop().
+// Each update() spends at most a time budget on due tasks, so a burst of
+// tasks coming due together can't push the next LVGL refresh back. Due tasks
+// run in priority order (then most overdue first) while their estimated cost
+// still fits; the rest stay due and carry over to the next loop. HIGH tasks
+// always run, and a task that has waited a whole interval runs regardless so
+// nothing starves.
+//
+// Tasks may also declare a slack: how late they are allowed to run. Tasks
+// with slack are put on a grid of their interval, so related intervals come
+// due together, and keep that phase when they run late. The next wakeup is
+// the latest time that still meets every task's due time plus slack, and
+// every task due by then runs in the same batch, so tasks share wakeups with
+// each other (and with LVGL refreshes) instead of each waking the loop.
+//
+// Slack is a trade for slow frame rates. When the frame period divides the
+// task intervals and is short, the batches land on frame deadlines: in
+// scripts/scheduler_sim.cpp with a 20 ms frame and a 5 ms budget, late frames
+// go from 33 to 90 a minute with slack (none at 16, 25 or 30 ms). Turn it
+// off with setSlackEnabled() while frames are that short; main.cpp does this
+// while the refresh governor is at its 20 ms active period.
 class PeriodicScheduler {
 public:
   using Task = std::function<void()>;
 
+  enum Priority : uint8_t {
+    PRIORITY_HIGH = 0, // latency-critical (UI); never deferred
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+  };
+
+#if SCHEDULER_STATS
+  // Jitter histogram buckets, in ms late: 0, 1, 2-3, 4-7, 8-15, 16-31, 32-63, 64+
+  static constexpr uint8_t JitterBuckets = 8;
+
+  struct TaskStats {
+    uint32_t runs = 0;
+    uint32_t overruns = 0;       // runs that took longer than the interval
+    uint32_t missedPeriods = 0;  // whole periods skipped because a run started late
+    uint32_t deferrals = 0;      // times the task was due but pushed to a later loop by the budget
+    uint32_t execMinUs = UINT32_MAX;
+    uint32_t execMaxUs = 0;
+    uint64_t execTotalUs = 0;
+    uint32_t jitterMaxMs = 0;    // worst start delay after the due time
+    uint32_t jitter[JitterBuckets] = {};
+
+    uint32_t execMeanUs() const { return runs ? (uint32_t)(execTotalUs / runs) : 0; }
+  };
+#endif
+
   PeriodicScheduler() = default;
 
   // Add a repeating task; returns the index that can be used to remove the task
-  int addTask(Task cb, uint32_t intervalMs);
+  // (-1 if the table is full in a STATIC_ALLOC build).
+  // costUs is the expected run time, refined from measurements as the task runs.
+  // The name is only used by dumpStats().
+  int addTask(Task cb, uint32_t intervalMs, const char *name = nullptr, Priority priority = PRIORITY_NORMAL,
+              uint32_t costUs = 0);
   void removeTask(int id);
 
-  // Call from loop() to execute pending tasks
-  void update(uint32_t now = 0);
+  // Upper limit on task time per update() (0 = unlimited, run everything due)
+  void setBudget(uint32_t budgetUs) { budget = budgetUs; }
+
+  // How late a task may run so its wakeup can be merged with others (default 0)
+  void setSlack(int id, uint32_t slackMs);
+  // Ignore every task's slack while off: tasks wake the loop when due. For
+  // short frame periods, see the note on slack above.
+  void setSlackEnabled(bool on) { slackOn = on; }
+  bool slackEnabled() const { return slackOn; }
+
+  // Call from loop() to execute pending tasks. availableUs further limits the
+  // budget for this call, e.g. to the time left before LVGL's next deadline.
+  void update(uint32_t now = 0, uint32_t availableUs = UINT32_MAX);
+
+  // Milliseconds until the loop next has to call update(): the earliest due
+  // time plus slack over all tasks (0 if a task is waiting now, UINT32_MAX if
+  // there are no active tasks)
+  uint32_t msUntilNextDue(uint32_t now = 0) const;
+
+  // Batches are wakeups that ran at least one task (including any work carried
+  // over to the passes straight after). A run saved a wakeup when its task
+  // waited within its slack for a batch that ran other tasks too; at most
+  // all but one run of a batch count. Always 0 without slack.
+  uint32_t batches() const { return batchCount; }
+  uint32_t wakeupsAvoided() const { return avoidedCount; }
+
+#if SCHEDULER_STATS
+  // nullptr for an unknown id
+  const TaskStats *stats(int id) const;
+  void resetStats();
+#endif
+  // One line per task; prints nothing when statistics are compiled out
+  void dumpStats(Print &out) const;
 
 private:
   struct Entry {
@@ -23,6 +117,33 @@ private:
     uint32_t interval;
     uint32_t lastRun;
     bool active;
+    Priority priority;
+    uint32_t estimateUs; // running estimate of the cost
+    uint32_t slack;
+    const char *name;
+#if SCHEDULER_STATS
+    TaskStats st;
+#endif
   };
+
+  void run(Entry &e, uint32_t now, uint32_t late);
+
+#if STATIC_ALLOC
+  StaticVector<Entry, SCHEDULER_MAX_TASKS> tasks;
+  StaticVector<int, SCHEDULER_MAX_TASKS> due;
+#else
   std::vector<Entry> tasks;
+  std::vector<int> due; // scratch list for update(), kept to avoid reallocating
+#endif
+  uint32_t budget = 0;
+  uint32_t batchCount = 0;
+  uint32_t runCount = 0;
+  uint32_t avoidedCount = 0;
+  // The current batch: runs, runs that waited within their slack, and what
+  // it has added to avoidedCount so far
+  uint32_t batchRuns = 0;
+  uint32_t batchSlackRuns = 0;
+  uint32_t batchAvoided = 0;
+  bool carrying = false; // tasks were deferred by the last update()
+  bool slackOn = true;
 };
@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include "LedEffects.h"
 
 // For RGB LED
 #define RED_LED_PIN 4
@@ -22,10 +23,9 @@ uint8_t getBlueValueFromColor(uint32_t c)
 
 void setColor(uint8_t R, uint8_t G, uint8_t B)
 {
-    // Note: LEDs are "active low", meaning HIGH == off, LOW == on
-    analogWrite(RED_LED_PIN, 255 - R);
-    analogWrite(GREEN_LED_PIN, 255 - G);
-    analogWrite(BLUE_LED_PIN, 255 - B);
+    // Note: LEDs are "active low"; LedEffects drives the LEDC channels inverted
+    // and applies gamma correction so equal steps look equally bright
+    LedEffects::getInstance().setColor(R, G, B);
 }
 
 void ChangeRGBColor(uint32_t color)
@@ -35,10 +35,13 @@ void ChangeRGBColor(uint32_t color)
 
 void initRGBled()
 {
-    // set all three pins to output mode
-    pinMode(RED_LED_PIN, OUTPUT);
-    pinMode(GREEN_LED_PIN, OUTPUT);
-    pinMode(BLUE_LED_PIN, OUTPUT);
+    // Attach all three pins to LEDC channels (off until a colour is set)
+    LedEffects::getInstance().begin(RED_LED_PIN, GREEN_LED_PIN, BLUE_LED_PIN);
+}
+
+void playRGBEffect(const led::Timeline &effect)
+{
+    LedEffects::getInstance().play(effect);
 }
 
 uint32_t randomColor()
@@ -1,9 +1,12 @@
 #ifndef _RGB_LED_DRIVER_H_
 #define _RGB_LED_DRIVER_H_
 
+#include "LedTimeline.h"
+
 void ChangeRGBColor(uint32_t color);            // uses 32-bit color code such as 0xFFd251
 void setColor(uint8_t R, uint8_t G, uint8_t B); // uses individual 8-bit values for R, G, and B
 void initRGBled();
+void playRGBEffect(const led::Timeline &effect); // e.g. led::Timeline::breathe(RGB_COLOR_3, 2000)
 uint32_t randomColor();
 
 #define RGB_COLOR_1 0xFF0000
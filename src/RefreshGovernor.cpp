@@ -0,0 +1,94 @@
+#include "RefreshGovernor.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+void RefreshGovernor::begin(lv_disp_t *d, lv_indev_t *i) {
+  begin(d, i, Config());
+}
+
+void RefreshGovernor::begin(lv_disp_t *d, lv_indev_t *i, const Config &c) {
+  cfg = c;
+  disp = d;
+  indev = i;
+  uint32_t now = millis();
+  startMs = now;
+  lastUpdate = now;
+  lastActivity = now;
+  period = 0;
+  applyPeriod(cfg.activePeriodMs);
+}
+
+void RefreshGovernor::notifyActivity() {
+  lastActivity = millis();
+  if (period != cfg.activePeriodMs) {
+    applyPeriod(cfg.activePeriodMs);
+    // Poll and redraw on the very next lv_timer_handler() instead of waiting
+    // out whatever was left of the idle period
+    if (indev && indev->driver->read_timer) lv_timer_ready(indev->driver->read_timer);
+    if (disp && disp->refr_timer) lv_timer_ready(disp->refr_timer);
+  }
+}
+
+void RefreshGovernor::update(uint32_t now) {
+  if (!disp) return;
+  if (now == 0) now = millis();
+
+  // Running animations count as activity so they stay smooth
+  if (lv_anim_count_running() > 0) lastActivity = now;
+
+  uint32_t quiet = now - lastActivity;
+  uint32_t target = cfg.activePeriodMs;
+  if (quiet > cfg.holdMs && cfg.decayStepMs > 0) {
+    uint32_t steps = (quiet - cfg.holdMs) / cfg.decayStepMs + 1;
+    while (steps-- > 0 && target < cfg.idlePeriodMs) target *= 2;
+    if (target > cfg.idlePeriodMs) target = cfg.idlePeriodMs;
+  }
+  if (target != period) applyPeriod(target);
+
+  // Account for the timer ticks skipped since the last update
+  uint32_t dt = now - lastUpdate;
+  lastUpdate = now;
+  if (period > cfg.activePeriodMs) {
+    avoidedTicksMilli += (uint64_t)dt * 1000 / cfg.activePeriodMs - (uint64_t)dt * 1000 / period;
+  }
+}
+
+void RefreshGovernor::recordPoll(uint32_t us) {
+  // Exponential moving average, weight 1/8
+  avgPollUs = avgPollUs == 0 ? us : avgPollUs - (avgPollUs >> 3) + (us >> 3);
+}
+
+void RefreshGovernor::recordRefresh(uint32_t renderMs) {
+  uint32_t us = renderMs * 1000;
+  avgRefreshUs = avgRefreshUs == 0 ? us : avgRefreshUs - (avgRefreshUs >> 3) + (us >> 3);
+  refreshes++;
+}
+
+uint32_t RefreshGovernor::avoidedTicks() const {
+  return (uint32_t)(avoidedTicksMilli / 1000);
+}
+
+uint32_t RefreshGovernor::savedMs() const {
+  // Each skipped tick would have cost at least one touch poll; the refresh
+  // timer run it also skipped isn't counted (see the header)
+  return (uint32_t)(avoidedTicksMilli * avgPollUs / 1000000ULL);
+}
+
+uint32_t RefreshGovernor::savedMsPerHour() const {
+  uint32_t uptime = lastUpdate - startMs;
+  if (uptime == 0) return 0;
+  return (uint32_t)((uint64_t)savedMs() * 3600000ULL / uptime);
+}
+
+void RefreshGovernor::report(Print &out) const {
+  reportf(out, "[refresh] period=%lums poll=%luus render=%luus frames=%lu skipped=%lu saved>=%lums (%lums/h)\n",
+               (unsigned long)period, (unsigned long)avgPollUs, (unsigned long)avgRefreshUs,
+               (unsigned long)refreshes, (unsigned long)avoidedTicks(), (unsigned long)savedMs(),
+               (unsigned long)savedMsPerHour());
+}
+
+void RefreshGovernor::applyPeriod(uint32_t ms) {
+  period = ms;
+  if (disp && disp->refr_timer) lv_timer_set_period(disp->refr_timer, ms);
+  if (indev && indev->driver->read_timer) lv_timer_set_period(indev->driver->read_timer, ms);
+}
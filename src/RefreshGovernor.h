@@ -0,0 +1,68 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stdint.h>
+
+class Print;
+
+// Activity-aware refresh governor for LVGL.
+// Runs the display refresh timer and touch read timer at a fast rate while the
+// user is interacting or animations are running, then decays step by step to a
+// low idle rate once the screen has been static for a while. A touch wake puts
+// both timers straight back on the fast rate.
+class RefreshGovernor {
+public:
+  struct Config {
+    uint32_t activePeriodMs = 20;  // refresh + touch poll period while active
+    uint32_t idlePeriodMs = 200;   // period once fully decayed
+    uint32_t holdMs = 2000;        // stay at the active rate this long after activity
+    uint32_t decayStepMs = 1000;   // double the period every step after the hold
+  };
+
+  RefreshGovernor() = default;
+
+  void begin(lv_disp_t *disp, lv_indev_t *indev);
+  void begin(lv_disp_t *disp, lv_indev_t *indev, const Config &cfg);
+
+  // Call whenever something user-visible happens (touch, wake IRQ, new data)
+  void notifyActivity();
+
+  // Call from loop() before lv_timer_handler()
+  void update(uint32_t now = 0);
+
+  // Cost samples used to estimate the CPU time saved
+  void recordPoll(uint32_t us);
+  void recordRefresh(uint32_t renderMs);
+
+  uint32_t currentPeriod() const { return period; }
+  bool isIdle() const { return period >= cfg.idlePeriodMs; }
+
+  // Timer ticks skipped compared to running at the active rate all the time
+  uint32_t avoidedTicks() const;
+  // Estimated CPU time saved by those ticks. This is a lower bound: it only
+  // counts the touch poll each tick would have made (timed by recordPoll()).
+  // The refresh timer runs that were skipped as well aren't counted. Nothing
+  // times them, because on a static screen they find nothing to redraw and
+  // never reach the monitor callback.
+  uint32_t savedMs() const;
+  uint32_t savedMsPerHour() const;
+  void report(Print &out) const;
+
+private:
+  void applyPeriod(uint32_t ms);
+
+  Config cfg;
+  lv_disp_t *disp = nullptr;
+  lv_indev_t *indev = nullptr;
+
+  uint32_t period = 0;
+  uint32_t lastActivity = 0;
+  uint32_t lastUpdate = 0;
+  uint32_t startMs = 0;
+
+  // Ticks avoided in 1/1000 tick units, plus running cost averages
+  uint64_t avoidedTicksMilli = 0;
+  uint32_t avgPollUs = 0;
+  uint32_t avgRefreshUs = 0;
+  uint32_t refreshes = 0;
+};
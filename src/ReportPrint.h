@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+// printf for report() lines without the heap. Arduino's Print::printf()
+// formats into a 64-byte stack buffer and mallocs a bigger one for anything
+// longer, which STATIC_ALLOC builds forbid once setup() has locked the heap.
+// Output past ReportLine characters is cut off.
+static constexpr size_t ReportLine = 256;
+
+inline size_t reportf(Print &out, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+inline size_t reportf(Print &out, const char *fmt, ...) {
+  char line[ReportLine];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  if ((size_t)n >= sizeof(line)) n = sizeof(line) - 1;
+  return out.write((const uint8_t *)line, n);
+}
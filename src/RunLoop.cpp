@@ -0,0 +1,89 @@
+#include "RunLoop.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+
+TaskHandle_t RunLoop::loopTask = nullptr;
+
+void RunLoop::begin() {
+  begin(Config());
+}
+
+void RunLoop::begin(const Config &c) {
+  cfg = c;
+  loopTask = xTaskGetCurrentTaskHandle();
+  startUs = esp_timer_get_time();
+
+  if (cfg.lightSleep && cfg.wakePin >= 0) {
+    gpio_wakeup_enable((gpio_num_t)cfg.wakePin, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+  }
+}
+
+void RunLoop::waitFor(uint32_t ms) {
+  if (ms == 0 || loopTask == nullptr) return;
+  if (ms > cfg.maxWaitMs) ms = cfg.maxWaitMs;
+
+  int64_t start = esp_timer_get_time();
+  bool woken;
+  if (cfg.lightSleep && ms >= cfg.lightSleepMinMs && sleepLight(ms)) {
+    woken = false;
+    st.lightSleeps++;
+  } else {
+    // Any notification given while we were busy is still pending and makes
+    // this return immediately, so a wake between checks is never lost
+    woken = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) != 0;
+  }
+  int64_t slept = esp_timer_get_time() - start;
+
+  st.waits++;
+  st.idleUs += slept;
+  if (woken) {
+    st.earlyWakes++;
+  } else if (slept > (int64_t)ms * 1000) {
+    uint32_t late = (uint32_t)(slept - (int64_t)ms * 1000);
+    st.totalLateUs += late;
+    if (late > st.maxLateUs) st.maxLateUs = late;
+  }
+}
+
+bool RunLoop::sleepLight(uint32_t ms) {
+  // Don't sleep over a pending wake, and let the UART finish before its clock stops
+  if (ulTaskNotifyTake(pdTRUE, 0) != 0) return false;
+  Serial.flush();
+
+  esp_sleep_enable_timer_wakeup((uint64_t)ms * 1000);
+  int64_t start = esp_timer_get_time();
+  if (esp_light_sleep_start() != ESP_OK) return false;
+  st.lightSleepUs += esp_timer_get_time() - start;
+  return true;
+}
+
+void RunLoop::wake() {
+  if (loopTask) xTaskNotifyGive(loopTask);
+}
+
+void IRAM_ATTR RunLoop::wakeFromISR() {
+  if (!loopTask) return;
+  BaseType_t higherPrioWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(loopTask, &higherPrioWoken);
+  portYIELD_FROM_ISR(higherPrioWoken);
+}
+
+uint32_t RunLoop::idlePermille() const {
+  uint64_t elapsed = esp_timer_get_time() - startUs;
+  if (elapsed == 0) return 0;
+  return (uint32_t)(st.idleUs * 1000 / elapsed);
+}
+
+void RunLoop::report(Print &out) const {
+  uint32_t idle = idlePermille();
+  uint32_t lateWaits = st.waits - st.earlyWakes;
+  reportf(out, "[runloop] waits=%lu early=%lu light=%lu idle=%lu.%lu%% sleep=%llums late avg=%luus max=%luus\n",
+               (unsigned long)st.waits, (unsigned long)st.earlyWakes, (unsigned long)st.lightSleeps,
+               (unsigned long)(idle / 10), (unsigned long)(idle % 10),
+               (unsigned long long)(st.lightSleepUs / 1000),
+               (unsigned long)(lateWaits ? st.totalLateUs / lateWaits : 0), (unsigned long)st.maxLateUs);
+}
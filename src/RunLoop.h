@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+class Print;
+
+// Tickless idle for loop(): instead of a fixed delay, loop() works out when the
+// next piece of work is due (LVGL timers, scheduler tasks) and blocks until
+// then. Touch IRQs or other tasks can cut the wait short with wake().
+// Long gaps can optionally be spent in ESP32 light sleep.
+class RunLoop {
+public:
+  struct Config {
+    uint32_t maxWaitMs = 1000;      // never block longer than this
+    bool lightSleep = false;        // use light sleep for long gaps
+    uint32_t lightSleepMinMs = 50;  // only light sleep for gaps at least this long
+    int8_t wakePin = -1;            // active-low GPIO that wakes from light sleep (touch IRQ)
+  };
+
+  struct Stats {
+    uint32_t waits = 0;          // number of times loop() blocked
+    uint32_t earlyWakes = 0;     // waits cut short by wake()
+    uint32_t lightSleeps = 0;    // waits spent in light sleep
+    uint64_t idleUs = 0;         // total time blocked (including light sleep)
+    uint64_t lightSleepUs = 0;   // part of idleUs spent in light sleep
+    uint32_t maxLateUs = 0;      // worst overshoot past the requested deadline
+    uint64_t totalLateUs = 0;    // sum of overshoots, for the mean
+  };
+
+  RunLoop() = default;
+
+  // Must be called from the loop task itself
+  void begin();
+  void begin(const Config &cfg);
+
+  // Block until `ms` has passed or someone calls wake()
+  void waitFor(uint32_t ms);
+
+  // Wake loop() early; safe to call from any task
+  static void wake();
+  // Same, from an interrupt handler
+  static void wakeFromISR();
+
+  const Stats &stats() const { return st; }
+  // Share of wall time spent idle since begin(), in 0.1 % units
+  uint32_t idlePermille() const;
+  void report(Print &out) const;
+
+private:
+  bool sleepLight(uint32_t ms);
+
+  Config cfg;
+  Stats st;
+  uint64_t startUs = 0;
+  static TaskHandle_t loopTask;
+};
@@ -0,0 +1,247 @@
+#include "ScreenCapture.h"
+#include "Crc.h"
+#include "SerialOwner.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+#include <string.h>
+
+ScreenCapture &ScreenCapture::getInstance() {
+  static ScreenCapture instance;
+  return instance;
+}
+
+void ScreenCapture::begin(Stream &p, uint32_t frameIntervalMs) {
+  port = &p;
+  intervalMs = frameIntervalMs;
+  resetRows();
+}
+
+void ScreenCapture::start() {
+  if (!port) return;
+  running = true;
+  needKeyframe = true; // sent from service() once the ring is empty
+}
+
+void ScreenCapture::stop() {
+  running = false;
+  needKeyframe = false;
+  keyframeRow = -1;
+}
+
+void ScreenCapture::resetRows() {
+  memset(rowSpan, 0xFF, sizeof(rowSpan));
+}
+
+// FNV-1a over the 16-bit pixels of one row segment
+static uint32_t hashRow(const lv_color_t *px, lv_coord_t w) {
+  uint32_t h = 2166136261u;
+  for (lv_coord_t i = 0; i < w; i++) {
+    h = (h ^ px[i].full) * 16777619u;
+  }
+  return h;
+}
+
+// Same packet coding as CompressedImage: runs of 2+ equal pixels as
+// (0x80 | n-1, pixel), everything else as (n-1, n literal pixels)
+static size_t encodeRow(const lv_color_t *px, lv_coord_t w, uint8_t *out) {
+  uint8_t *o = out;
+  lv_coord_t i = 0;
+  lv_coord_t litStart = 0;
+  auto flushLiterals = [&](lv_coord_t end) {
+    while (litStart < end) {
+      lv_coord_t n = end - litStart;
+      if (n > 128) n = 128;
+      *o++ = (uint8_t)(n - 1);
+      for (lv_coord_t k = 0; k < n; k++) {
+        uint16_t c = px[litStart + k].full;
+        *o++ = c & 0xFF;
+        *o++ = c >> 8;
+      }
+      litStart += n;
+    }
+  };
+
+  while (i < w) {
+    lv_coord_t run = 1;
+    while (i + run < w && run < 128 && px[i + run].full == px[i].full) run++;
+    if (run >= 2) {
+      flushLiterals(i);
+      uint16_t c = px[i].full;
+      *o++ = 0x80 | (uint8_t)(run - 1);
+      *o++ = c & 0xFF;
+      *o++ = c >> 8;
+      i += run;
+      litStart = i;
+    } else {
+      i++;
+    }
+  }
+  flushLiterals(w);
+  return o - out;
+}
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+void ScreenCapture::tee(const lv_area_t *area, const lv_color_t *pixels) {
+  if (!running || needKeyframe) return;
+  lv_coord_t w = area->x2 - area->x1 + 1;
+  if (area->x1 < 0 || area->y1 < 0 || w > MaxWidth) return;
+
+  uint32_t start = micros();
+  uint32_t span = ((uint32_t)area->x1 << 16) | (uint16_t)area->x2;
+  for (lv_coord_t y = area->y1; y <= area->y2 && y < MaxRows; y++) {
+    const lv_color_t *row = pixels + (size_t)(y - area->y1) * w;
+    uint32_t h = hashRow(row, w);
+    if (rowSpan[y] == span && rowHash[y] == h) {
+      st.rowsSkipped++;
+      continue;
+    }
+
+    put16(scratch, area->x1);
+    put16(scratch + 2, y);
+    put16(scratch + 4, w);
+    size_t len = encodeRow(row, w, scratch + 6);
+    if (!queuePacket(PACKET_ROW, scratch, 6 + len)) {
+      // Host is now out of sync; resend everything once the ring has drained
+      st.overflows++;
+      lostData = true;
+      needKeyframe = true;
+      break;
+    }
+    rowHash[y] = h;
+    rowSpan[y] = span;
+    st.rowsSent++;
+    st.rawBytes += (uint32_t)w * 2;
+    st.encodedBytes += len;
+  }
+  st.encodeUs += micros() - start;
+}
+
+bool ScreenCapture::queuePacket(uint8_t type, const uint8_t *payload, size_t len) {
+  if (len + Overhead > freeSpace()) return false;
+  uint8_t hdr[6] = {0xA5, 0x5A, type, seq++, (uint8_t)(len & 0xFF), (uint8_t)(len >> 8)};
+  uint16_t crc = crc16(hdr + 2, 4);
+  crc = crc16(payload, len, crc);
+  uint8_t tail[2] = {(uint8_t)(crc & 0xFF), (uint8_t)(crc >> 8)};
+  ringWrite(hdr, sizeof(hdr));
+  ringWrite(payload, len);
+  ringWrite(tail, sizeof(tail));
+  return true;
+}
+
+void ScreenCapture::ringWrite(const uint8_t *data, size_t len) {
+  size_t tail = (head + used) % RingSize;
+  size_t first = RingSize - tail;
+  if (first > len) first = len;
+  memcpy(ring + tail, data, first);
+  memcpy(ring, data + first, len - first);
+  used += len;
+}
+
+// Sends whole packets only while this stream owns the port, so telemetry
+// frames go out between packets and never inside one
+void ScreenCapture::drain() {
+  int room = port->availableForWrite();
+  while (used > 0 && room > 0) {
+    if (packetLeft == 0) {
+      if (!SerialOwner::claim(SerialOwner::WRITER_CAPTURE)) return;
+      // Packets are queued whole, so head is at a header: A5 5A type seq len
+      size_t len = ring[(head + 4) % RingSize] | (ring[(head + 5) % RingSize] << 8);
+      packetLeft = len + Overhead;
+    }
+    size_t chunk = RingSize - head;
+    if (chunk > used) chunk = used;
+    if (chunk > packetLeft) chunk = packetLeft;
+    if (chunk > (size_t)room) chunk = room;
+    port->write(ring + head, chunk);
+    head = (head + chunk) % RingSize;
+    used -= chunk;
+    room -= chunk;
+    packetLeft -= chunk;
+    if (packetLeft == 0) SerialOwner::release(SerialOwner::WRITER_CAPTURE);
+  }
+}
+
+void ScreenCapture::sendKeyframe() {
+  lv_disp_t *disp = lv_disp_get_default();
+  if (!disp) return;
+  uint8_t payload[4];
+  put16(payload, disp->driver->hor_res);
+  put16(payload + 2, disp->driver->ver_res);
+  if (!queuePacket(PACKET_KEYFRAME, payload, sizeof(payload))) return;
+
+  resetRows();
+  needKeyframe = false;
+  lostData = false;
+  keyframeRow = 0;
+  st.keyframes++;
+}
+
+// Redraw the next band of the screen once the previous one has been flushed
+// and sent, so the whole keyframe goes out without overflowing the ring
+void ScreenCapture::nextKeyframeBand() {
+  lv_disp_t *disp = lv_disp_get_default();
+  if (!disp || disp->inv_p > 0 || used > 0) return;
+  lv_coord_t height = disp->driver->ver_res;
+  if (keyframeRow >= height) {
+    keyframeRow = -1;
+    return;
+  }
+  lv_coord_t last = keyframeRow + KeyframeBand - 1;
+  if (last >= height) last = height - 1;
+  lv_area_t band;
+  lv_area_set(&band, 0, keyframeRow, disp->driver->hor_res - 1, last);
+  lv_obj_invalidate_area(lv_scr_act(), &band);
+  keyframeRow = last + 1;
+}
+
+void ScreenCapture::service(uint32_t now) {
+  if (!port) return;
+  if (now == 0) now = millis();
+
+  while (port->available() > 0) {
+    switch (port->read()) {
+    case 'C':
+      start();
+      break;
+    case 'X':
+      stop();
+      break;
+    case 'K':
+      if (running) needKeyframe = true;
+      break;
+    default:
+      break;
+    }
+  }
+
+  if (running) {
+    if (needKeyframe && used == 0) sendKeyframe();
+    if (keyframeRow >= 0) nextKeyframeBand();
+    // Frame markers tell the host the canvas is complete up to here
+    if (!needKeyframe && keyframeRow < 0 && now - lastFrame >= intervalMs) {
+      uint8_t payload[5];
+      put16(payload, frameNo & 0xFFFF);
+      put16(payload + 2, frameNo >> 16);
+      payload[4] = lostData ? 1 : 0;
+      if (queuePacket(PACKET_FRAME, payload, sizeof(payload))) {
+        frameNo++;
+        st.frames++;
+        lastFrame = now;
+      }
+    }
+  }
+  drain();
+}
+
+void ScreenCapture::report(Print &out) const {
+  uint32_t ratio = st.rawBytes ? (uint32_t)(st.encodedBytes * 100 / st.rawBytes) : 0;
+  uint32_t perRow = st.rowsSent ? (uint32_t)(st.encodeUs / st.rowsSent) : 0;
+  reportf(out, "[capture] %s frames=%lu keyframes=%lu rows=%lu unchanged=%lu rle=%lu%% encode=%luus/row overflows=%lu\n",
+               running ? "on" : "off", (unsigned long)st.frames, (unsigned long)st.keyframes,
+               (unsigned long)st.rowsSent, (unsigned long)st.rowsSkipped, (unsigned long)ratio,
+               (unsigned long)perRow, (unsigned long)st.overflows);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+class Stream;
+
+// Remote screenshots over the serial port, rebuilt on the host with
+// scripts/capture_to_png.py.
+//
+// Every area LVGL flushes is teed into the capture stream, so the stream is
+// already a delta against the previous frame: nothing is sent for a static
+// screen except a small frame marker. Rows whose content is identical to what
+// was last sent for the same span are skipped, and the rest are RLE coded the
+// same way as CompressedImage assets. Packets are queued in a ring buffer that
+// service() drains only as fast as the UART accepts, so rendering never waits
+// on Serial. If the ring overflows the stream resynchronises with a keyframe
+// once it has drained: the screen is redrawn in bands of KeyframeBand rows,
+// each one only after the previous band has been sent, so a keyframe never
+// needs more ring space than one band. The port is shared with Telemetry and
+// LogSink (see SerialOwner.h); the streams take turns between packets.
+//
+// Packet: A5 5A, u8 type, u8 seq, u16 len, payload, u16 CRC-16 of type..payload
+//   'K' keyframe   u16 width, u16 height            (host clears its canvas)
+//   'R' row        u16 x, u16 y, u16 w, RLE pixels
+//   'F' frame      u32 frame number, u8 flags        (host writes a PNG)
+// Host commands (single bytes): 'C' start, 'X' stop, 'K' request keyframe.
+class ScreenCapture {
+public:
+  struct Stats {
+    uint32_t frames = 0;
+    uint32_t keyframes = 0;
+    uint32_t rowsSent = 0;
+    uint32_t rowsSkipped = 0;   // unchanged since the last capture
+    uint32_t overflows = 0;     // rows dropped because the ring was full
+    uint64_t rawBytes = 0;      // RGB565 bytes of the rows sent
+    uint64_t encodedBytes = 0;  // after RLE, excluding packet overhead
+    uint64_t encodeUs = 0;
+  };
+
+  static constexpr size_t RingSize = 8 * 1024;
+  static constexpr lv_coord_t MaxRows = 320;
+  static constexpr lv_coord_t MaxWidth = 320;
+  static constexpr lv_coord_t KeyframeBand = 8;
+
+  static ScreenCapture &getInstance();
+
+  ScreenCapture(const ScreenCapture &) = delete;
+  ScreenCapture &operator=(const ScreenCapture &) = delete;
+
+  // Port for packets and host commands; capture stays off until started
+  void begin(Stream &port, uint32_t frameIntervalMs = 250);
+  void start();
+  void stop();
+  bool active() const { return running; }
+
+  // Call from the display flush callback with the area just sent to the panel
+  void tee(const lv_area_t *area, const lv_color_t *pixels);
+
+  // Call from loop(): reads host commands, emits frame markers and drains the ring
+  void service(uint32_t now = 0);
+  bool txPending() const { return used != 0; }
+
+  const Stats &stats() const { return st; }
+  void report(Print &out) const;
+
+private:
+  ScreenCapture() = default;
+
+  enum : uint8_t { PACKET_KEYFRAME = 'K', PACKET_ROW = 'R', PACKET_FRAME = 'F' };
+  static constexpr size_t Overhead = 8; // sync, type, seq, len, crc
+
+  size_t freeSpace() const { return RingSize - used; }
+  bool queuePacket(uint8_t type, const uint8_t *payload, size_t len);
+  void ringWrite(const uint8_t *data, size_t len);
+  void drain();
+  void resetRows();
+  void sendKeyframe();
+  void nextKeyframeBand();
+
+  Stream *port = nullptr;
+  uint32_t intervalMs = 250;
+  uint32_t lastFrame = 0;
+  uint32_t frameNo = 0;
+  bool running = false;
+  bool needKeyframe = false;
+  bool lostData = false;
+  lv_coord_t keyframeRow = -1; // next band to redraw, -1 when no keyframe is in progress
+  uint8_t seq = 0;
+
+  uint8_t ring[RingSize];
+  size_t head = 0; // next byte to send
+  size_t used = 0;
+  size_t packetLeft = 0; // bytes of the packet at head still to send
+
+  // What was last sent for each row: hash of the pixels and the span they covered
+  uint32_t rowHash[MaxRows];
+  uint32_t rowSpan[MaxRows];
+
+  // One encoded row packet payload: header plus worst case RLE
+  uint8_t scratch[6 + MaxWidth * 2 + (MaxWidth + 127) / 128];
+
+  Stats st;
+};
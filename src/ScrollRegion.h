@@ -0,0 +1,86 @@
+#pragma once
+
+// Row bookkeeping for the panel's hardware vertical scroll (TemplateCode's
+// setScrollRegion()/scrollBy()). Nothing here touches the display, so the
+// mapping can be checked on the host (see scripts/scroll_sim.cpp).
+//
+// Frame memory rows [top, top + rows) form a ring. offset is the ring row
+// shown at the top of the scroll area, so glass row top + i shows memory row
+// top + (offset + i) % rows. Rows outside the region map to themselves.
+
+#include <stdint.h>
+
+class ScrollRegion {
+public:
+  // A run of frame memory rows
+  struct Span {
+    uint16_t first;
+    uint16_t count;
+  };
+
+  // panelRows is how many rows the display has along the scroll axis
+  bool set(uint16_t top, uint16_t rows, uint16_t panelRows) {
+    if (rows == 0 || (uint32_t)top + rows > panelRows) return false;
+    regionTop = top;
+    regionRows = rows;
+    offset = 0;
+    lastScroll = 0;
+    return true;
+  }
+
+  void clear() { regionRows = 0; }
+  bool active() const { return regionRows != 0; }
+  uint16_t top() const { return regionTop; }
+  uint16_t rows() const { return regionRows; }
+  // Memory row shown at the top of the scroll area (the VSCSAD value)
+  uint16_t startRow() const { return regionTop + offset; }
+
+  // Positive lines move the content up and expose new rows at the bottom
+  void scrollBy(int16_t lines) {
+    if (!active()) return;
+    int32_t o = ((int32_t)offset + lines) % regionRows;
+    if (o < 0) o += regionRows;
+    offset = o;
+    lastScroll = lines;
+  }
+
+  int32_t screenToMemory(int32_t y) const {
+    if (!inside(y)) return y;
+    return regionTop + (y - regionTop + offset) % regionRows;
+  }
+
+  int32_t memoryToScreen(int32_t y) const {
+    if (!inside(y)) return y;
+    return regionTop + (y - regionTop + regionRows - offset) % regionRows;
+  }
+
+  // Memory rows revealed by the last scrollBy(); the run can wrap around the
+  // end of the region, so it is returned as up to two spans
+  uint8_t exposed(Span out[2]) const {
+    if (!active() || lastScroll == 0) return 0;
+    uint16_t count = lastScroll > 0 ? lastScroll : -lastScroll;
+    if (count > regionRows) count = regionRows;
+
+    // Scrolling up by n reveals, at the bottom of the glass, the n memory rows
+    // that just left the top; scrolling down reveals the n rows now at the top
+    int32_t first = lastScroll > 0 ? (int32_t)offset - count : offset;
+    if (first < 0) first += regionRows;
+
+    uint16_t firstRun = regionRows - first;
+    if (count <= firstRun) {
+      out[0] = {(uint16_t)(regionTop + first), count};
+      return 1;
+    }
+    out[0] = {(uint16_t)(regionTop + first), firstRun};
+    out[1] = {regionTop, (uint16_t)(count - firstRun)};
+    return 2;
+  }
+
+private:
+  bool inside(int32_t y) const { return active() && y >= regionTop && y < regionTop + regionRows; }
+
+  uint16_t regionTop = 0;
+  uint16_t regionRows = 0; // 0 means off
+  uint16_t offset = 0;
+  int16_t lastScroll = 0;
+};
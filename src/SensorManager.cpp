@@ -1,45 +1,121 @@
 #include "SensorManager.h"
-#include <DHT.h>
+#include "EventBus.h"
+#include "Events.h"
+#include "MemoryMonitor.h"
+#include <DHT.h> // sensor type constants (DHT11, DHT22, ...)
 #include <Arduino.h>
 
 SensorManager::SensorManager(uint8_t dhtPin, uint8_t dhtType, uint32_t intervalMs)
-  : pin(dhtPin), type(dhtType), interval(intervalMs), lastRead(0), tmp(NAN), hum(NAN), dht(nullptr)
+  : pin(dhtPin), type(dhtType), interval(intervalMs), lastRead(0), tmp(NAN), hum(NAN)
 {}
 
 void SensorManager::begin() {
-  if (!dht) {
-    dht = new DHT(pin, type);
-    dht->begin();
-  }
+  MemoryMonitor::Scope tag(MemoryMonitor::TAG_SENSORS);
+  // Idle level of the data line is high
+  pinMode(pin, INPUT_PULLUP);
 }
 
 void SensorManager::update() {
-  if (!dht) {
-    dht = new DHT(pin, type);
-    dht->begin();
-  }
   unsigned long now = millis();
   if ((uint32_t)(now - lastRead) < interval) return;
+  if (reader.running()) return;
   lastRead = now;
+  if (!CoroutineRunner::getInstance().start(reader)) record(NAN, NAN);
+}
 
-  float t = dht->readTemperature();
-  float h = dht->readHumidity();
+void SensorManager::DhtRead::step(uint32_t now) {
+  CO_BEGIN();
+  // Release the line for a moment, then hold it low long enough to wake the
+  // sensor (at least 18 ms for a DHT11, 1 ms for the others)
+  pinMode(sensors.pin, INPUT_PULLUP);
+  CO_SLEEP_MS(1);
+  pinMode(sensors.pin, OUTPUT);
+  digitalWrite(sensors.pin, LOW);
+  CO_SLEEP_MS(sensors.type == DHT11 ? 20 : 2);
+
+  if (!readBits()) {
+    sensors.record(NAN, NAN);
+  } else if (sensors.type == DHT11) {
+    float t = data[2];
+    if (data[3] & 0x80) t = -1 - t;
+    sensors.record(t + (data[3] & 0x0F) * 0.1f, data[0] + data[1] * 0.1f);
+  } else if (sensors.type == DHT12) {
+    float t = data[2] + (data[3] & 0x0F) * 0.1f;
+    if (data[2] & 0x80) t = -t;
+    sensors.record(t, data[0] + data[1] * 0.1f);
+  } else {
+    float t = (((data[2] & 0x7F) << 8) | data[3]) * 0.1f;
+    if (data[2] & 0x80) t = -t;
+    sensors.record(t, ((data[0] << 8) | data[1]) * 0.1f);
+  }
+  CO_END();
+}
+
+// Microseconds the line stayed at level, or 0 on timeout or if it was
+// already past that level (the pulse was missed)
+static uint32_t pulseWidth(uint8_t pin, int level) {
+  if (digitalRead(pin) != level) return 0;
+  uint32_t start = micros();
+  while (digitalRead(pin) == level) {
+    if (micros() - start > 1000) return 0;
+  }
+  uint32_t width = micros() - start;
+  return width ? width : 1;
+}
 
+// The sensor answers 20-40 us after the line is released, so the transfer
+// itself (up to ~5 ms) has to be timed with interrupts off. It runs from
+// CoroutineRunner::service(), outside the scheduler's budget: the sensors
+// task is only charged the ~100 us it takes to start the read.
+bool SensorManager::DhtRead::readBits() {
+  static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  uint8_t p = sensors.pin;
+  uint32_t widths[80];
+  bool ok = true;
+
+  portENTER_CRITICAL(&mux);
+  pinMode(p, INPUT_PULLUP);
+  delayMicroseconds(55);
+  // 80 us low, 80 us high, then each bit is 50 us low followed by 26-28 us
+  // (0) or 70 us (1) high
+  if (!pulseWidth(p, LOW) || !pulseWidth(p, HIGH)) ok = false;
+  // Stop at the first missed pulse rather than waiting out every timeout
+  // with interrupts off
+  for (int i = 0; ok && i < 80; i += 2) {
+    widths[i] = pulseWidth(p, LOW);
+    widths[i + 1] = widths[i] ? pulseWidth(p, HIGH) : 0;
+    ok = widths[i + 1] != 0;
+  }
+  portEXIT_CRITICAL(&mux);
+  if (!ok) return false;
+
+  for (int i = 0; i < 5; i++) data[i] = 0;
+  for (int i = 0; i < 40; i++) {
+    uint32_t low = widths[2 * i], high = widths[2 * i + 1];
+    data[i / 8] <<= 1;
+    if (high > low) data[i / 8] |= 1;
+  }
+  return data[4] == (uint8_t)(data[0] + data[1] + data[2] + data[3]);
+}
+
+void SensorManager::record(float t, float h) {
   // Only sample when values are valid
   if (!isnan(t)) tmp = t;
   if (!isnan(h)) hum = h;
 
-  // If we have a callback and values changed significantly - fire it
-  if (cb) {
-    bool changed = false;
-    if (isnan(lastTemperature()) || fabs(tmp - lastTemperature()) >= 0.1f) changed = true;
-    if (isnan(lastHumidity()) || fabs(hum - lastHumidity()) >= 0.1f) changed = true;
-    if (changed) cb(tmp, hum);
-  }
+  // Record every read so the history keeps a fixed time base
+  Sample &slot = history[samples % HistorySize];
+  slot.tempTenths = isnan(t) ? NoValue : (int16_t)lroundf(t * 10.0f);
+  slot.humidityTenths = isnan(h) ? NoValue : (int16_t)lroundf(h * 10.0f);
+  samples++;
+
+  EventBus::publish(SensorReading{t, h});
 }
 
-void SensorManager::onChange(Callback c) {
-  cb = c;
+bool SensorManager::sampleAt(uint32_t seq, Sample &out) const {
+  if (seq >= samples || samples - seq > HistorySize) return false;
+  out = history[seq % HistorySize];
+  return true;
 }
 
 float SensorManager::lastTemperature() const { return tmp; }
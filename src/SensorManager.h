@@ -1,29 +1,60 @@
 #pragma once
 
-#include <functional>
+#include <stddef.h>
 #include <stdint.h>
-class DHT;
+#include "Coroutine.h"
 
 class SensorManager {
 public:
-  using Callback = std::function<void(float tempC, float humidity)>;
+  // One entry per read, in tenths of a unit; NoValue marks a failed read
+  struct Sample {
+    int16_t tempTenths;
+    int16_t humidityTenths;
+  };
+  static constexpr int16_t NoValue = INT16_MIN;
+  static constexpr size_t HistorySize = 900; // 30 minutes at the default 2 s interval
 
   SensorManager(uint8_t dhtPin, uint8_t dhtType, uint32_t intervalMs = 2000);
   void begin();
-  void update(); // immediate read; intended to be called by scheduler
-
-  void onChange(Callback cb);
+  // Starts a read if the interval has passed; intended to be called by the
+  // scheduler. The sensor wake-up runs as a coroutine, so only the ~5 ms bit
+  // transfer blocks loop() (previously ~25 ms with the DHT library).
+  // Every finished read is published on the EventBus as a SensorReading
+  void update();
 
   float lastTemperature() const;
   float lastHumidity() const;
 
+  // History ring. Samples are numbered from 0 for the first read; only the
+  // newest HistorySize of them are kept.
+  uint32_t sampleCount() const { return samples; }
+  uint32_t intervalMs() const { return interval; }
+  bool sampleAt(uint32_t seq, Sample &out) const;
+
 private:
+  // Start signal, wake-up wait and 40-bit transfer of one DHT read
+  class DhtRead : public Coroutine {
+  public:
+    explicit DhtRead(SensorManager &owner) : sensors(owner) {}
+
+  protected:
+    void step(uint32_t now) override;
+
+  private:
+    bool readBits();
+    SensorManager &sensors;
+    uint8_t data[5] = {};
+  };
+
+  void record(float t, float h);
+
   uint8_t pin;
   uint8_t type;
   uint32_t interval;
   uint32_t lastRead;
   float tmp; 
   float hum;
-  Callback cb;
-  DHT *dht;
+  DhtRead reader{*this};
+  Sample history[HistorySize];
+  uint32_t samples = 0;
 };
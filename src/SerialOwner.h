@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdint.h>
+#include <freertos/FreeRTOS.h>
+
+// Decides which stream may write to the shared serial port: Telemetry frames,
+// ScreenCapture packets or LogSink text lines. A writer claims the port before
+// the first byte of a frame, packet or line and gives it back after the last
+// one. The port only changes hands at those boundaries, so no stream is ever
+// spliced into another. LogSink writes from its own task on the other core,
+// so claims and releases are taken under a spinlock.
+class SerialOwner {
+public:
+  enum Writer : uint8_t {
+    WRITER_NONE = 0,
+    WRITER_TELEMETRY,
+    WRITER_CAPTURE,
+    WRITER_LOG,
+  };
+
+  // False while another writer is partway through a frame, packet or line.
+  // The first writer refused gets the next turn, so a long run of capture
+  // packets can't starve telemetry or the log, or the other way round.
+  static bool claim(Writer w) {
+    bool ok = false;
+    portENTER_CRITICAL(&lock);
+    if (owner == w) {
+      ok = true;
+    } else if (owner == WRITER_NONE && (waiting == WRITER_NONE || waiting == w)) {
+      owner = w;
+      waiting = WRITER_NONE;
+      ok = true;
+    } else if (waiting == WRITER_NONE) {
+      waiting = w;
+    }
+    portEXIT_CRITICAL(&lock);
+    return ok;
+  }
+  static void release(Writer w) {
+    portENTER_CRITICAL(&lock);
+    if (owner == w) owner = WRITER_NONE;
+    portEXIT_CRITICAL(&lock);
+  }
+  static Writer current() { return owner; }
+
+private:
+  static inline volatile Writer owner = WRITER_NONE;
+  static inline volatile Writer waiting = WRITER_NONE;
+  static inline portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+};
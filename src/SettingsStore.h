@@ -0,0 +1,203 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include "Crc.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Preferences.h>
+#endif
+
+// Where a SettingsStore keeps its blob
+class SettingsBackend {
+public:
+  virtual ~SettingsBackend() = default;
+  // Read up to len bytes into buf; returns the number of bytes read (0 if nothing stored)
+  virtual size_t load(void *buf, size_t len) = 0;
+  virtual bool save(const void *buf, size_t len) = 0;
+};
+
+#ifdef ARDUINO
+// NVS flash through Preferences, stored as a single blob under one key
+class NvsSettingsBackend : public SettingsBackend {
+public:
+  explicit NvsSettingsBackend(const char *ns, const char *key = "settings") : ns(ns), key(key) {}
+
+  size_t load(void *buf, size_t len) override {
+    if (!prefs.begin(ns, true)) return 0;
+    size_t n = prefs.getBytes(key, buf, len);
+    prefs.end();
+    return n;
+  }
+
+  bool save(const void *buf, size_t len) override {
+    if (!prefs.begin(ns, false)) return false;
+    size_t n = prefs.putBytes(key, buf, len);
+    prefs.end();
+    return n == len;
+  }
+
+private:
+  Preferences prefs;
+  const char *ns;
+  const char *key;
+};
+#endif
+
+// Plain RAM backend, for host builds and tests
+class MemorySettingsBackend : public SettingsBackend {
+public:
+  static constexpr size_t Capacity = 256;
+
+  size_t load(void *buf, size_t len) override {
+    size_t n = len < stored ? len : stored;
+    memcpy(buf, blob, n);
+    return n;
+  }
+
+  bool save(const void *buf, size_t len) override {
+    if (len > Capacity) return false;
+    memcpy(blob, buf, len);
+    stored = len;
+    writes++;
+    return true;
+  }
+
+  uint8_t blob[Capacity] = {};
+  size_t stored = 0;
+  uint32_t writes = 0;
+};
+
+// Typed settings with a RAM shadow and coalesced writes.
+// Reads always come from RAM. set() only marks the field dirty; the whole
+// struct is written as one versioned, CRC-checked blob once no change has
+// happened for quietMs (or on commit()), so dragging a slider costs one flash
+// write instead of hundreds. At boot the blob is read back in a single load.
+//
+//   struct Settings { int32_t travel; uint32_t speed; };
+//   NvsSettingsBackend nvs("app");
+//   SettingsStore<Settings, 1> settings(nvs, Settings{1000, 200});
+//   settings.set(&Settings::speed, 400u);   // from the slider callback
+//   settings.update();                       // from loop()
+template <typename T, uint16_t Version>
+class SettingsStore {
+  static_assert(std::is_trivially_copyable<T>::value, "settings must be a plain struct");
+
+public:
+  struct Stats {
+    uint32_t sets = 0;       // set() calls that changed a value
+    uint32_t commits = 0;    // blobs actually written
+    uint32_t unchanged = 0;  // set() calls with the value already stored
+    uint32_t loadErrors = 0; // boot loads rejected (missing, old version, bad CRC)
+  };
+
+  SettingsStore(SettingsBackend &backend, const T &defaults, uint32_t quietMs = 2000)
+      : backend(backend), defaults(defaults), shadow(defaults), quietMs(quietMs) {}
+
+  // Load the stored blob; falls back to the defaults if it is missing or invalid
+  bool begin() {
+    Blob b;
+    size_t n = backend.load(&b, sizeof(b));
+    bool valid = n == sizeof(b) && b.magic == Magic && b.version == Version && b.size == sizeof(T) &&
+                 b.crc == crc32(&b, offsetof(Blob, crc));
+    if (valid) {
+      shadow = b.data;
+    } else {
+      shadow = defaults;
+      st.loadErrors++;
+    }
+    dirtyMask = 0;
+    return valid;
+  }
+
+  const T &get() const { return shadow; }
+
+  template <typename F>
+  void set(F T::*field, const F &value) {
+    F &slot = shadow.*field;
+    if (memcmp(&slot, &value, sizeof(F)) == 0) {
+      st.unchanged++;
+      return;
+    }
+    slot = value;
+    size_t offset = reinterpret_cast<const uint8_t *>(&slot) - reinterpret_cast<const uint8_t *>(&shadow);
+    dirtyMask |= maskFor(offset, sizeof(F));
+    lastChange = now();
+    st.sets++;
+  }
+
+  // Bit i set = byte range [i * chunk, (i + 1) * chunk) of T changed since the last commit
+  uint32_t dirtyFields() const { return dirtyMask; }
+  bool dirty() const { return dirtyMask != 0; }
+
+  // Call from loop(): commits once the settings have been quiet long enough
+  void update() {
+    if (dirtyMask != 0 && now() - lastChange >= quietMs) commit();
+  }
+
+  // Write pending changes now (e.g. on shutdown)
+  bool commit() {
+    if (dirtyMask == 0) return true;
+    Blob b;
+    b.magic = Magic;
+    b.version = Version;
+    b.size = sizeof(T);
+    b.data = shadow;
+    b.crc = crc32(&b, offsetof(Blob, crc));
+    if (!backend.save(&b, sizeof(b))) return false;
+    dirtyMask = 0;
+    st.commits++;
+    return true;
+  }
+
+  void resetToDefaults() {
+    shadow = defaults;
+    dirtyMask = ~0u;
+    lastChange = now();
+  }
+
+  const Stats &stats() const { return st; }
+
+private:
+  static constexpr uint32_t Magic = 0x53544731; // "STG1"
+  static constexpr size_t Chunk = (sizeof(T) + 31) / 32;
+
+  struct Blob {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    T data;
+    uint32_t crc;
+  };
+
+  static uint32_t maskFor(size_t offset, size_t len) {
+    uint32_t mask = 0;
+    for (size_t i = offset / Chunk; i <= (offset + len - 1) / Chunk && i < 32; i++) mask |= 1u << i;
+    return mask;
+  }
+
+  static uint32_t now() {
+#ifdef ARDUINO
+    return millis();
+#else
+    return hostClock;
+#endif
+  }
+
+  SettingsBackend &backend;
+  const T defaults;
+  T shadow;
+  uint32_t quietMs;
+  uint32_t lastChange = 0;
+  uint32_t dirtyMask = 0;
+  Stats st;
+
+public:
+#ifndef ARDUINO
+  // Host builds drive time by hand
+  static inline uint32_t hostClock = 0;
+#endif
+};
@@ -0,0 +1,73 @@
+#include "SpiArbiter.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+static const char *const DEVICE_NAMES[SpiArbiter::DEVICE_COUNT] = {"display", "touch", "sd"};
+
+SpiArbiter &SpiArbiter::getInstance() {
+  static SpiArbiter instance;
+  return instance;
+}
+
+SpiArbiter::SpiArbiter() : windowStart(micros()) {}
+
+void SpiArbiter::acquire(Device d) {
+  owner = d;
+  acquiredAt = micros();
+}
+
+void SpiArbiter::release(Device d) {
+  if (owner != d) return;
+  uint32_t now = micros();
+  uint32_t held = now - acquiredAt;
+  busyUs[d] += held;
+  if (held > maxHoldUs[d]) maxHoldUs[d] = held;
+  if (d == DEVICE_TOUCH) lastTouchUs = now;
+  if (d == DEVICE_DISPLAY) flushPending = false;
+  owner = -1;
+}
+
+void SpiArbiter::setNextFlushIn(uint32_t us) {
+  flushPending = us != 0;
+  nextFlushUs = micros() + us;
+}
+
+bool SpiArbiter::sdMayRun(uint32_t estimateUs) {
+  if (owner >= 0) return false;
+  uint32_t now = micros();
+  // Don't push a pending flush back
+  bool hitsFlush = flushPending && (int32_t)(nextFlushUs - (now + estimateUs)) < 0;
+  // Keep the next touch slot free while touch is being polled
+  uint32_t sinceTouch = now - lastTouchUs;
+  bool hitsTouch = sinceTouch < touchSlotUs && sinceTouch + estimateUs > touchSlotUs;
+  if (hitsFlush || hitsTouch) {
+    sdDeferred++;
+    return false;
+  }
+  return true;
+}
+
+uint32_t SpiArbiter::utilisationPermille(Device d) const {
+  uint32_t window = micros() - windowStart;
+  if (window == 0) return 0;
+  return (uint32_t)((uint64_t)busyUs[d] * 1000 / window);
+}
+
+void SpiArbiter::resetWindow() {
+  windowStart = micros();
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+    busyUs[i] = 0;
+    maxHoldUs[i] = 0;
+  }
+  sdDeferred = 0;
+}
+
+void SpiArbiter::report(Print &out) {
+  for (int i = 0; i < DEVICE_COUNT; i++) {
+    uint32_t u = utilisationPermille((Device)i);
+    reportf(out, "[spi] %-7s busy=%lu.%lu%% max hold=%luus\n", DEVICE_NAMES[i], (unsigned long)(u / 10),
+                 (unsigned long)(u % 10), (unsigned long)maxHoldUs[i]);
+  }
+  reportf(out, "[spi] sd chunks deferred=%lu\n", (unsigned long)sdDeferred);
+  resetWindow();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stdint.h>
+
+class Print;
+
+// Arbitrates the shared VSPI bus between the display, the resistive touch
+// controller and the SD card. Everything runs on the loop task, so this is
+// about *when* each device gets the bus rather than locking:
+// - display flushes and touch samples always run when LVGL asks for them
+// - SD work is split into bounded chunks, and a chunk only starts if it will
+//   finish before the next expected display flush and the next touch slot
+// Busy time is recorded per device so the chunk size and touch slot can be tuned.
+class SpiArbiter {
+public:
+  enum Device : uint8_t {
+    DEVICE_DISPLAY = 0,
+    DEVICE_TOUCH,
+    DEVICE_SD,
+    DEVICE_COUNT,
+  };
+
+  static SpiArbiter &getInstance();
+
+  SpiArbiter(const SpiArbiter &) = delete;
+  SpiArbiter &operator=(const SpiArbiter &) = delete;
+
+  // Bracket every bus transaction so busy time is attributed to the device
+  void acquire(Device d);
+  void release(Device d);
+
+  // RAII helper: SpiArbiter::Lease lease(SpiArbiter::DEVICE_SD);
+  class Lease {
+  public:
+    explicit Lease(Device d) : dev(d) { getInstance().acquire(d); }
+    ~Lease() { getInstance().release(dev); }
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+  private:
+    Device dev;
+  };
+
+  // Touch is guaranteed a bus slot at least this often while it is being polled
+  void setTouchSlot(uint32_t periodUs) { touchSlotUs = periodUs; }
+
+  // Tell the arbiter when the next display flush is expected (0 = nothing pending)
+  void setNextFlushIn(uint32_t us);
+
+  // May an SD chunk expected to take estimateUs start now?
+  bool sdMayRun(uint32_t estimateUs);
+
+  // Bus utilisation per device over the current window, in 0.1 % units
+  uint32_t utilisationPermille(Device d) const;
+  void resetWindow();
+  void report(Print &out);
+
+private:
+  SpiArbiter();
+
+  uint32_t windowStart;
+  uint32_t busyUs[DEVICE_COUNT] = {};
+  uint32_t maxHoldUs[DEVICE_COUNT] = {};
+  uint32_t acquiredAt = 0;
+  int8_t owner = -1;
+
+  uint32_t touchSlotUs = 30000;
+  uint32_t lastTouchUs = 0;
+  bool flushPending = false;
+  uint32_t nextFlushUs = 0;
+  uint32_t sdDeferred = 0;
+};
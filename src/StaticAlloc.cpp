@@ -0,0 +1,91 @@
+#include "StaticAlloc.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+#include <stdlib.h>
+#include <new>
+#include <esp_rom_sys.h>
+
+volatile bool HeapGuard::isLocked = false;
+uint32_t HeapGuard::count = 0;
+uint32_t HeapGuard::bytes = 0;
+
+void HeapGuard::lock() {
+#if STATIC_ALLOC
+  isLocked = true;
+#endif
+}
+
+void HeapGuard::refuse(const char *what, size_t size, void *caller) {
+  // Straight to the ROM UART routine: Serial and the log task may allocate
+  esp_rom_printf("\nHeapGuard: %s(%u) after setup, called from %p\n", what, (unsigned)size, caller);
+  abort();
+}
+
+void *HeapGuard::allocate(size_t size, bool nothrow, void *caller) {
+  if (isLocked) refuse("operator new", size, caller);
+  void *p = malloc(size ? size : 1);
+  if (!p && !nothrow) {
+    esp_rom_printf("\nHeapGuard: out of memory allocating %u bytes, called from %p\n", (unsigned)size, caller);
+    abort();
+  }
+  count++;
+  bytes += size;
+  return p;
+}
+
+void HeapGuard::report(Print &out) {
+#if STATIC_ALLOC
+  reportf(out, "[heap] static mode, locked=%d new before lock=%lu (%lu B)\n", (int)isLocked, (unsigned long)count,
+               (unsigned long)bytes);
+#else
+  (void)out;
+#endif
+}
+
+#if STATIC_ALLOC
+// Replace the library's operator new so every C++ allocation is counted and
+// checked. delete isn't replaced: the default one frees with free(), which
+// matches. new[] is replaced too because GCC 8's libstdc++ doesn't route all
+// of its variants through operator new(size_t).
+void *operator new(size_t size) {
+  return HeapGuard::allocate(size, false, __builtin_return_address(0));
+}
+
+void *operator new[](size_t size) {
+  return HeapGuard::allocate(size, false, __builtin_return_address(0));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return HeapGuard::allocate(size, true, __builtin_return_address(0));
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return HeapGuard::allocate(size, true, __builtin_return_address(0));
+}
+
+// C allocations, with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc (the
+// *_static environments in platformio.ini). The linker sends every call to
+// malloc() in the firmware and the prebuilt libraries here instead; only
+// heap_caps_malloc() and pvPortMalloc() callers in ESP-IDF bypass it. free()
+// isn't wrapped.
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size) {
+  if (HeapGuard::locked()) HeapGuard::refuse("malloc", size, __builtin_return_address(0));
+  return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+  if (HeapGuard::locked()) HeapGuard::refuse("calloc", n * size, __builtin_return_address(0));
+  return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+  if (HeapGuard::locked()) HeapGuard::refuse("realloc", size, __builtin_return_address(0));
+  return __real_realloc(p, size);
+}
+}
+#endif
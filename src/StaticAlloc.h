@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Build with -DSTATIC_ALLOC=1 for units that run unattended for months: the
+// buffers that are otherwise malloc'd at startup or on demand (TemplateCode,
+// the scheduler's task table, the glyph cache, trend chart pixels and the
+// CompressedImage cache and stream state) live in static storage sized at
+// compile time, and HeapGuard::lock() at the end of setup() makes any later
+// heap allocation abort. Memory use is then fixed at link time and the heap
+// can't fragment. The sizes are set by the *_BYTES / *_MAX_* macros next to
+// each user; all of it comes out of the ESP32's static DRAM, so trim them if
+// the link overflows dram0_0_seg. Build one of the *_static environments in
+// platformio.ini: they add the malloc wrapping linker flags the mode needs.
+#ifndef STATIC_ALLOC
+#define STATIC_ALLOC 0
+#endif
+
+class Print;
+
+// Counts C++ heap allocations and, in STATIC_ALLOC builds, aborts on any
+// operator new, malloc, calloc or realloc made after lock(), printing the
+// size and caller so the panic backtrace (esp32_exception_decoder) shows
+// where it came from. Report lines are formatted with reportf()
+// (ReportPrint.h) because Print::printf mallocs for long lines. ESP-IDF code
+// that calls heap_caps_malloc() or pvPortMalloc() directly isn't checked;
+// MemoryMonitor's trend alarm covers that.
+class HeapGuard {
+public:
+  // No-op unless built with STATIC_ALLOC
+  static void lock();
+  static bool locked() { return isLocked; }
+
+  // Allocations through operator new before lock() (STATIC_ALLOC builds only)
+  static uint32_t allocations() { return count; }
+  static uint32_t allocatedBytes() { return bytes; }
+  static void report(Print &out);
+
+  // Used by the operator new and malloc replacements
+  static void *allocate(size_t size, bool nothrow, void *caller);
+  [[noreturn]] static void refuse(const char *what, size_t size, void *caller);
+
+private:
+  static volatile bool isLocked;
+  static uint32_t count;
+  static uint32_t bytes;
+};
+
+// Fixed-capacity replacement for the parts of std::vector used by
+// PeriodicScheduler. push_back() on a full vector is ignored; check full()
+// first.
+template <typename T, size_t N>
+class StaticVector {
+public:
+  static constexpr size_t capacity() { return N; }
+
+  void push_back(const T &v) {
+    if (n < N) items[n++] = v;
+  }
+  void clear() { n = 0; }
+  void reserve(size_t) {}
+  size_t size() const { return n; }
+  bool empty() const { return n == 0; }
+  bool full() const { return n == N; }
+
+  T &operator[](size_t i) { return items[i]; }
+  const T &operator[](size_t i) const { return items[i]; }
+  T *begin() { return items; }
+  T *end() { return items + n; }
+  const T *begin() const { return items; }
+  const T *end() const { return items + n; }
+
+private:
+  T items[N] = {};
+  size_t n = 0;
+};
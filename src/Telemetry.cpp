@@ -0,0 +1,138 @@
+#include "Telemetry.h"
+#include "Crc.h"
+#include "SerialOwner.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+#include <string.h>
+
+constexpr size_t Telemetry::RingSize[];
+
+Telemetry &Telemetry::getInstance() {
+  static Telemetry instance;
+  return instance;
+}
+
+void Telemetry::begin(Print &out) {
+  port = &out;
+}
+
+bool Telemetry::send(Schema schema, Priority priority, const void *body, size_t len) {
+  if (!port || schema >= SchemaCount || priority >= PriorityCount || len > MaxBody) return false;
+
+  // schema, seq, timestamp, body, crc
+  uint8_t raw[6 + MaxBody + 2];
+  uint32_t now = millis();
+  raw[0] = schema;
+  raw[1] = seq[schema]++; // advanced even if the frame is dropped, so the host sees the gap
+  raw[2] = now & 0xFF;
+  raw[3] = (now >> 8) & 0xFF;
+  raw[4] = (now >> 16) & 0xFF;
+  raw[5] = now >> 24;
+  memcpy(raw + 6, body, len);
+  uint16_t crc = crc16(raw, 6 + len);
+  raw[6 + len] = crc & 0xFF;
+  raw[7 + len] = crc >> 8;
+
+  // COBS adds one byte per 254, plus the delimiter
+  uint8_t frame[sizeof(raw) + 2];
+  size_t n = cobsEncode(raw, 8 + len, frame);
+  frame[n++] = 0;
+
+  if (!push(rings[priority], frame, n)) {
+    st.dropped[priority]++;
+    return false;
+  }
+  st.sent[priority]++;
+  return true;
+}
+
+// Consistent Overhead Byte Stuffing: removes every 0x00 from the frame so 0x00
+// can delimit frames, and the host can resync at the next delimiter
+size_t Telemetry::cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+  size_t code = 0; // position of the current block's length byte
+  size_t o = 1;
+  uint8_t run = 1;
+  for (size_t i = 0; i < len; i++) {
+    if (in[i] == 0) {
+      out[code] = run;
+      code = o++;
+      run = 1;
+      continue;
+    }
+    out[o++] = in[i];
+    if (++run == 0xFF) {
+      out[code] = run;
+      code = o++;
+      run = 1;
+    }
+  }
+  out[code] = run;
+  return o;
+}
+
+bool Telemetry::push(Ring &r, const uint8_t *frame, size_t len) {
+  size_t head = r.head.load(std::memory_order_relaxed);
+  size_t tail = r.tail.load(std::memory_order_acquire);
+  if (len > r.size - (head - tail)) return false;
+  for (size_t i = 0; i < len; i++) r.data[(head + i) % r.size] = frame[i];
+  r.head.store(head + len, std::memory_order_release);
+  return true;
+}
+
+bool Telemetry::txPending() const {
+  for (const Ring &r : rings) {
+    if (r.head.load(std::memory_order_acquire) != r.tail.load(std::memory_order_relaxed)) return true;
+  }
+  return false;
+}
+
+void Telemetry::service() {
+  if (!port) return;
+  int room = port->availableForWrite();
+  while (room > 0) {
+    // Only switch rings between frames; a partly sent frame is finished first
+    if (current < 0) {
+      for (int p = 0; p < PriorityCount && current < 0; p++) {
+        if (rings[p].head.load(std::memory_order_acquire) != rings[p].tail.load(std::memory_order_relaxed)) current = p;
+      }
+      if (current < 0) return;
+      // ScreenCapture is partway through a packet; try again next time
+      if (!SerialOwner::claim(SerialOwner::WRITER_TELEMETRY)) {
+        current = -1;
+        return;
+      }
+      // Extra delimiter in front, so text printed to the same port since the
+      // last frame ends up in a chunk of its own that the host discards
+      port->write((uint8_t)0);
+      st.bytes++;
+      if (--room == 0) return;
+    }
+
+    Ring &r = rings[current];
+    size_t tail = r.tail.load(std::memory_order_relaxed);
+    size_t head = r.head.load(std::memory_order_acquire);
+    size_t at = tail % r.size;
+    size_t chunk = head - tail;
+    if (chunk > r.size - at) chunk = r.size - at;
+    if (chunk > (size_t)room) chunk = room;
+
+    const uint8_t *end = static_cast<const uint8_t *>(memchr(r.data + at, 0, chunk));
+    if (end) chunk = end - (r.data + at) + 1;
+
+    port->write(r.data + at, chunk);
+    r.tail.store(tail + chunk, std::memory_order_release);
+    room -= chunk;
+    st.bytes += chunk;
+    if (end) {
+      current = -1;
+      SerialOwner::release(SerialOwner::WRITER_TELEMETRY);
+    }
+  }
+}
+
+void Telemetry::report(Print &out) const {
+  reportf(out, "[telemetry] sent=%lu/%lu/%lu dropped=%lu/%lu/%lu bytes=%lu\n", (unsigned long)st.sent[PRIORITY_HIGH],
+               (unsigned long)st.sent[PRIORITY_NORMAL], (unsigned long)st.sent[PRIORITY_LOW],
+               (unsigned long)st.dropped[PRIORITY_HIGH], (unsigned long)st.dropped[PRIORITY_NORMAL],
+               (unsigned long)st.dropped[PRIORITY_LOW], (unsigned long)st.bytes);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+class Print;
+
+// Binary telemetry over the serial port, decoded on the host with
+// scripts/telemetry_decode.py.
+//
+// Each message is encoded into a complete frame when it is sent and queued in
+// one of three rings, one per priority. service() hands bytes to the UART
+// driver only as fast as its TX buffer accepts them, highest priority ring
+// first, so loop() never blocks on Serial. When the host or the link can't
+// keep up, the low priority ring fills first and new messages for a full ring
+// are dropped and counted. Each ring has a single producer and a single
+// consumer and needs no locks. The port is shared with ScreenCapture and
+// LogSink (see SerialOwner.h); while a packet or log line is partly sent,
+// frames wait.
+//
+// Frame: 0x00, COBS(u8 schema, u8 seq, u32 ms, body, u16 CRC-16 of the
+// preceding bytes), 0x00. The leading delimiter keeps text logged to the same
+// port out of the frame. seq counts per schema, so the host can tell how many
+// messages of each type were lost.
+class Telemetry {
+public:
+  enum Priority : uint8_t {
+    PRIORITY_HIGH = 0,
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,
+    PriorityCount
+  };
+
+  // Schema IDs; the body layouts below must match scripts/telemetry_decode.py
+  enum Schema : uint8_t {
+    SCHEMA_SENSOR = 1,
+    SCHEMA_TASK = 2,
+    SCHEMA_FRAME = 3,
+    SCHEMA_LOG = 4, // batch of DeferredLog records, see DeferredLog.h
+    SCHEMA_MEMORY = 5,
+    SchemaCount
+  };
+
+  struct __attribute__((packed)) SensorBody {
+    int16_t tempTenths;      // INT16_MIN if the read failed
+    int16_t humidityTenths;
+  };
+
+  struct __attribute__((packed)) TaskBody {
+    uint8_t task;            // scheduler task id
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t deferrals;
+    uint32_t execMeanUs;
+    uint32_t execMaxUs;
+    uint32_t jitterMaxMs;
+  };
+
+  struct __attribute__((packed)) FrameBody {
+    uint16_t renderMs;
+    uint32_t bytesFlushed;
+  };
+
+  struct __attribute__((packed)) MemoryBody {
+    uint32_t freeHeap;
+    uint32_t largestBlock;
+    uint32_t minFreeHeap;   // lowest since boot
+    uint8_t lvglUsedPct;
+    uint8_t lvglFragPct;
+    uint16_t minStackFree;  // smallest task stack high-water mark, bytes
+    int32_t trendBytesPerMin;
+    uint8_t alarms;         // MemoryMonitor::Alarm bits
+  };
+
+  struct Stats {
+    uint32_t sent[PriorityCount] = {};    // frames queued
+    uint32_t dropped[PriorityCount] = {}; // frames lost to a full ring
+    uint32_t bytes = 0;                   // bytes handed to the UART
+  };
+
+  static constexpr size_t RingSize[PriorityCount] = {512, 1024, 1024};
+  static constexpr size_t MaxBody = 48;
+
+  static Telemetry &getInstance();
+
+  Telemetry(const Telemetry &) = delete;
+  Telemetry &operator=(const Telemetry &) = delete;
+
+  // Nothing is queued until begin() has been given a port
+  void begin(Print &out);
+
+  // Queue a message; false if it was dropped
+  bool send(Schema schema, Priority priority, const void *body, size_t len);
+  template <typename T>
+  bool send(Schema schema, Priority priority, const T &body) {
+    return send(schema, priority, &body, sizeof(T));
+  }
+
+  // Call from loop(): moves queued frames into the UART driver's TX buffer
+  void service();
+  bool txPending() const;
+
+  const Stats &stats() const { return st; }
+  void report(Print &out) const;
+
+private:
+  Telemetry() = default;
+
+  struct Ring {
+    uint8_t *data;
+    size_t size;
+    std::atomic<size_t> head{0}; // written by the producer
+    std::atomic<size_t> tail{0}; // written by the consumer
+  };
+
+  static size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out);
+  bool push(Ring &r, const uint8_t *frame, size_t len);
+
+  Print *port = nullptr;
+  uint8_t seq[SchemaCount] = {};
+
+  uint8_t highData[RingSize[PRIORITY_HIGH]];
+  uint8_t normalData[RingSize[PRIORITY_NORMAL]];
+  uint8_t lowData[RingSize[PRIORITY_LOW]];
+  Ring rings[PriorityCount] = {{highData, RingSize[PRIORITY_HIGH]},
+                               {normalData, RingSize[PRIORITY_NORMAL]},
+                               {lowData, RingSize[PRIORITY_LOW]}};
+  int current = -1; // ring whose frame is partly sent; -1 between frames
+
+  Stats st;
+};
@@ -5,16 +5,26 @@
  */
 
 #include "TemplateCode.h"
+#include "RunLoop.h"
+#include "ScreenCapture.h"
+#include "EventBus.h"
+#include "LogSink.h"
+#include "Events.h"
+#include "MemoryMonitor.h"
+#include "StaticAlloc.h"
+#include "ReportPrint.h"
+#include <new>
 
 // Initialize static members
 TemplateCode *TemplateCode::instance = nullptr;
+volatile bool TemplateCode::touchIrq = false;
 lv_disp_draw_buf_t TemplateCode::draw_buf;
 lv_color_t TemplateCode::buf[SCREEN_WIDTH * SCREEN_HEIGHT / 10];
 
 TemplateCode::TemplateCode()
 #ifdef TOUCH_TYPE_RESISTIVE
     : mySpi(VSPI),
-      ts(XPT2046_CS, XPT2046_IRQ),
+      ts(XPT2046_CS), // IRQ handled here so it can also wake the run loop
       tft(SCREEN_WIDTH, SCREEN_HEIGHT)
 #elif defined(TOUCH_TYPE_CAPACITIVE)
     : ts(CST820_SDA, CST820_SCL, CST820_RST, CST820_INT),
@@ -29,13 +39,22 @@ TemplateCode &TemplateCode::getInstance()
 {
   if (instance == nullptr)
   {
+    MemoryMonitor::Scope tag(MemoryMonitor::TAG_TEMPLATE);
+#if STATIC_ALLOC
+    // Constructed in place on first use, as before, but not on the heap
+    alignas(TemplateCode) static uint8_t storage[sizeof(TemplateCode)];
+    instance = new (storage) TemplateCode();
+#else
     instance = new TemplateCode();
+#endif
   }
   return *instance;
 }
 
 bool TemplateCode::begin()
 {
+  MemoryMonitor::Scope tag(MemoryMonitor::TAG_TEMPLATE);
+
   // Serial will be initialized in main setup() at preferred baud rate
 
 #if LV_USE_LOG != 0
@@ -71,12 +90,21 @@ void TemplateCode::setupTouchscreen()
 #ifdef TOUCH_TYPE_RESISTIVE
   ts.begin(mySpi);
   ts.setRotation(1);
+  pinMode(XPT2046_IRQ, INPUT);
+  attachInterrupt(digitalPinToInterrupt(XPT2046_IRQ), touchISR, FALLING);
 #endif
 #ifdef TOUCH_TYPE_CAPACITIVE
   ts.begin();
+  attachInterrupt(digitalPinToInterrupt(CST820_INT), touchISR, FALLING);
 #endif
 }
 
+void IRAM_ATTR TemplateCode::touchISR()
+{
+  touchIrq = true;
+  RunLoop::wakeFromISR();
+}
+
 void TemplateCode::setupDisplay()
 {
   tft.begin();
@@ -87,14 +115,17 @@ void TemplateCode::setupDisplay()
   disp_drv.hor_res = SCREEN_WIDTH;
   disp_drv.ver_res = SCREEN_HEIGHT;
   disp_drv.flush_cb = flushDisplay;
+  disp_drv.monitor_cb = monitorRefresh;
   disp_drv.draw_buf = &draw_buf;
-  lv_disp_drv_register(&disp_drv);
+  lv_disp_t *disp = lv_disp_drv_register(&disp_drv);
 
   static lv_indev_drv_t indev_drv;
   lv_indev_drv_init(&indev_drv);
   indev_drv.type = LV_INDEV_TYPE_POINTER;
   indev_drv.read_cb = readTouchpad;
-  lv_indev_drv_register(&indev_drv);
+  lv_indev_t *indev = lv_indev_drv_register(&indev_drv);
+
+  governor.begin(disp, indev);
 }
 
 void TemplateCode::flushDisplay(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
@@ -103,23 +134,83 @@ void TemplateCode::flushDisplay(lv_disp_drv_t *disp_drv, const lv_area_t *area,
   uint32_t w = (area->x2 - area->x1 + 1);
   uint32_t h = (area->y2 - area->y1 + 1);
 
-  display.tft.startWrite();
-  display.tft.setAddrWindow(area->x1, area->y1, w, h);
-  display.tft.pushColors((uint16_t *)&color_p->full, w * h, true);
-  display.tft.endWrite();
+  {
+    SpiArbiter::Lease lease(SpiArbiter::DEVICE_DISPLAY);
+    display.tft.startWrite();
+    display.tft.setAddrWindow(area->x1, area->y1, w, h);
+    display.tft.pushColors((uint16_t *)&color_p->full, w * h, true);
+    display.tft.endWrite();
+  }
+
+  display.render.flushes++;
+  display.refreshBytes += w * h * sizeof(lv_color_t);
+
+  // Remote screenshots: queue the same pixels for the serial capture stream
+  ScreenCapture &capture = ScreenCapture::getInstance();
+  if (capture.active())
+  {
+    capture.tee(area, color_p);
+  }
 
   lv_disp_flush_ready(disp_drv);
 }
 
+void TemplateCode::monitorRefresh(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px)
+{
+  auto &display = getInstance();
+  display.governor.recordRefresh(time);
+
+  RenderStats &r = display.render;
+  uint32_t bytes = display.refreshBytes;
+  display.refreshBytes = 0;
+  r.refreshes++;
+  r.totalRenderMs += time;
+  r.bytesFlushed += bytes;
+  if (time > r.maxRenderMs)
+  {
+    r.maxRenderMs = time;
+  }
+  if (bytes > r.maxBytesPerRefresh)
+  {
+    r.maxBytesPerRefresh = bytes;
+  }
+  if ((display.budgetMs && time > display.budgetMs) || (display.budgetBytes && bytes > display.budgetBytes))
+  {
+    r.overBudget++;
+  }
+  EventBus::publish(FrameRendered{time, bytes});
+}
+
+void TemplateCode::setRenderBudget(uint32_t maxMs, uint32_t maxBytes)
+{
+  budgetMs = maxMs;
+  budgetBytes = maxBytes;
+}
+
+void TemplateCode::reportRender(Print &out) const
+{
+  uint32_t n = render.refreshes ? render.refreshes : 1;
+  reportf(out, "[render] refreshes=%lu flushes=%lu avg=%lums max=%lums bytes avg=%lu max=%lu over_budget=%lu\n",
+               (unsigned long)render.refreshes, (unsigned long)render.flushes,
+               (unsigned long)(render.totalRenderMs / n), (unsigned long)render.maxRenderMs,
+               (unsigned long)(render.bytesFlushed / n), (unsigned long)render.maxBytesPerRefresh,
+               (unsigned long)render.overBudget);
+}
+
 #ifdef TOUCH_TYPE_RESISTIVE
 void TemplateCode::readTouchpad(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
 {
   auto &display = getInstance();
-  bool touched = (display.ts.tirqTouched() && display.ts.touched());
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_TOUCH);
+  uint32_t start = micros();
+  bool touched = (display.touchPending() && display.ts.touched());
 
   if (!touched)
   {
+    touchIrq = false;
     data->state = LV_INDEV_STATE_REL;
+    display.governor.recordPoll(micros() - start);
+    display.publishTouch(false, 0, 0);
     return;
   }
 
@@ -129,7 +220,10 @@ void TemplateCode::readTouchpad(lv_indev_drv_t *indev_drv, lv_indev_data_t *data
 
   data->state = LV_INDEV_STATE_PR;
   data->point.x = touchX;
-  data->point.y = touchY;
+  data->point.y = display.screenToMemoryY(touchY);
+  display.governor.recordPoll(micros() - start);
+  display.governor.notifyActivity();
+  display.publishTouch(true, touchX, touchY);
 }
 #endif
 #ifdef TOUCH_TYPE_CAPACITIVE
@@ -137,29 +231,199 @@ void TemplateCode::readTouchpad(lv_indev_drv_t *indev_drv, lv_indev_data_t *data
 {
   auto &display = getInstance();
   uint16_t rawX, rawY;
-  if (display.ts.getTouch(&rawX, &rawY))
+  uint32_t start = micros();
+  bool touched = display.ts.getTouch(&rawX, &rawY);
+  display.governor.recordPoll(micros() - start);
+  if (touched)
   {
     // Map raw touchscreen coordinates to screen orientation
     data->state = LV_INDEV_STATE_PR;
     data->point.x = rawY;
-    data->point.y = 240 - rawX;
+    data->point.y = display.screenToMemoryY(240 - rawX);
+    display.governor.notifyActivity();
+    display.publishTouch(true, rawY, 240 - rawX);
   }
   else
   {
+    touchIrq = false;
     data->state = LV_INDEV_STATE_REL;
+    display.publishTouch(false, 0, 0);
   }
 }
 #endif
 
-void TemplateCode::update()
+/**
+ * Posts a TouchEvent when the finger goes down or comes up. Queued rather
+ * than published, so subscribers don't run inside LVGL's input read.
+ * A release reports the last pressed position.
+ */
+void TemplateCode::publishTouch(bool pressed, uint16_t x, uint16_t y)
+{
+  if (pressed)
+  {
+    lastTouchX = x;
+    lastTouchY = y;
+  }
+  if (pressed == touchDown)
+  {
+    return;
+  }
+  touchDown = pressed;
+  EventBus::post(TouchEvent{lastTouchX, lastTouchY, pressed});
+}
+
+// Cheap check for a new touch that doesn't go over SPI/I2C, so it can run every
+// loop even while the governor has slowed the real touch polling down
+bool TemplateCode::touchPending()
+{
+#ifdef TOUCH_TYPE_RESISTIVE
+  return touchIrq || digitalRead(XPT2046_IRQ) == LOW;
+#elif defined(TOUCH_TYPE_CAPACITIVE)
+  return touchIrq || digitalRead(CST820_INT) == LOW;
+#else
+  return false;
+#endif
+}
+
+uint32_t TemplateCode::update()
+{
+  if (touchPending())
+  {
+    governor.notifyActivity();
+  }
+  governor.update();
+  uint32_t due = lv_timer_handler();
+#ifdef TOUCH_TYPE_RESISTIVE
+  SpiArbiter::getInstance().setTouchSlot(governor.currentPeriod() * 1000);
+#endif
+  return due;
+}
+
+// Let the SPI arbiter know when the bus will next be needed by LVGL so bulk
+// SD transfers can be fitted in between. Straight after lv_timer_handler()
+// nothing is invalid yet, so this runs later in the loop, and the time comes
+// from the refresh timer rather than from the handler's next timer of any kind.
+void TemplateCode::updateFlushHint()
+{
+  lv_disp_t *disp = lv_disp_get_default();
+  uint32_t us = 0;
+  if (disp && disp->inv_p > 0 && disp->refr_timer)
+  {
+    lv_timer_t *timer = disp->refr_timer;
+    uint32_t elapsed = lv_tick_elaps(timer->last_run);
+    // 1 us rather than 0 (nothing pending) when the refresh is already due
+    us = elapsed >= timer->period ? 1 : (timer->period - elapsed) * 1000;
+  }
+  SpiArbiter::getInstance().setNextFlushIn(us);
+}
+
+bool TemplateCode::setScrollRegion(uint16_t top, uint16_t rows)
+{
+  // Only when the panel's rows run down LVGL's y axis, one for one
+  lv_disp_t *disp = lv_disp_get_default();
+  if (!disp || tft.getRotation() != 0 || lv_disp_get_ver_res(disp) != PANEL_ROWS)
+  {
+    return false;
+  }
+  if (!scroll.set(top, rows, lv_disp_get_ver_res(disp)))
+  {
+    return false;
+  }
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_DISPLAY);
+  writeScrollRegion(top, rows);
+  writeScrollStart();
+  return true;
+}
+
+void TemplateCode::clearScrollRegion()
+{
+  if (!scrolling())
+  {
+    return;
+  }
+  // Back to an identity mapping; the frame memory contents are now out of
+  // order on screen, so redraw everything
+  scroll.clear();
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_DISPLAY);
+  writeScrollRegion(0, PANEL_ROWS);
+  writeScrollStart();
+  lv_obj_invalidate(lv_scr_act());
+}
+
+void TemplateCode::scrollBy(int16_t lines)
+{
+  if (!scrolling())
+  {
+    return;
+  }
+  scroll.scrollBy(lines);
+  SpiArbiter::Lease lease(SpiArbiter::DEVICE_DISPLAY);
+  writeScrollStart();
+}
+
+void TemplateCode::writeScrollRegion(uint16_t top, uint16_t rows)
+{
+  // VSCRDEF: top fixed area, scroll area and bottom fixed area; must add up to 320
+  uint16_t bottom = PANEL_ROWS - top - rows;
+  tft.writecommand(ST7789_VSCRDEF);
+  tft.writedata(top >> 8);
+  tft.writedata(top & 0xFF);
+  tft.writedata(rows >> 8);
+  tft.writedata(rows & 0xFF);
+  tft.writedata(bottom >> 8);
+  tft.writedata(bottom & 0xFF);
+}
+
+void TemplateCode::writeScrollStart()
+{
+  // VSCSAD: frame memory row shown at the top of the scroll area
+  uint16_t start = scrolling() ? scroll.startRow() : 0;
+  tft.writecommand(ST7789_VSCSAD);
+  tft.writedata(start >> 8);
+  tft.writedata(start & 0xFF);
+}
+
+lv_coord_t TemplateCode::screenToMemoryY(lv_coord_t y) const
+{
+  return scroll.screenToMemory(y);
+}
+
+lv_coord_t TemplateCode::memoryToScreenY(lv_coord_t y) const
 {
-  lv_timer_handler();
+  return scroll.memoryToScreen(y);
+}
+
+uint8_t TemplateCode::exposedAreas(lv_area_t out[2]) const
+{
+  ScrollRegion::Span spans[2];
+  uint8_t n = scroll.exposed(spans);
+  lv_disp_t *disp = lv_disp_get_default();
+  if (!disp)
+  {
+    return 0;
+  }
+  lv_coord_t right = lv_disp_get_hor_res(disp) - 1;
+  for (uint8_t i = 0; i < n; i++)
+  {
+    lv_area_set(&out[i], 0, spans[i].first, right, spans[i].first + spans[i].count - 1);
+  }
+  return n;
+}
+
+void TemplateCode::invalidateExposed() const
+{
+  lv_area_t areas[2];
+  uint8_t n = exposedAreas(areas);
+  for (uint8_t i = 0; i < n; i++)
+  {
+    lv_obj_invalidate_area(lv_scr_act(), &areas[i]);
+  }
 }
 
 #if LV_USE_LOG != 0
 void TemplateCode::debugPrint(const char *buf)
 {
-  Serial.printf(buf);
-  Serial.flush();
+  // Queued for the log task, so LVGL logging doesn't stall rendering on the UART
+  LogSink::lvglPrint(buf);
 }
 #endif
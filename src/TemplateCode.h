@@ -18,6 +18,9 @@
 #include "CST820.h"
 #endif
 #include "RGBledDriver.h"
+#include "RefreshGovernor.h"
+#include "ScrollRegion.h"
+#include "SpiArbiter.h"
 
 class TemplateCode
 {
@@ -42,6 +45,11 @@ private:
   static constexpr uint16_t SCREEN_WIDTH = 320;
   static constexpr uint16_t SCREEN_HEIGHT = 240;
 
+  // ST7789 frame memory is 240x320; hardware scrolling runs along the 320 rows
+  static constexpr uint16_t PANEL_ROWS = 320;
+  static constexpr uint8_t ST7789_VSCRDEF = 0x33;
+  static constexpr uint8_t ST7789_VSCSAD = 0x37;
+
 #ifdef TOUCH_TYPE_RESISTIVE
   // Touch Calibration Values
   static constexpr uint16_t TOUCH_X_MIN = 200;
@@ -60,6 +68,9 @@ private:
 #endif
   TFT_eSPI tft;
 
+  // Adapts the LVGL refresh/touch poll rate to user activity
+  RefreshGovernor governor;
+
   // LVGL Buffer
   static lv_disp_draw_buf_t draw_buf;
   static lv_color_t buf[SCREEN_WIDTH * SCREEN_HEIGHT / 10];
@@ -75,7 +86,24 @@ private:
   void initializeLVGL();
   void setupTouchscreen();
   static void readTouchpad(lv_indev_drv_t *indev_drv, lv_indev_data_t *data);
+  static void monitorRefresh(lv_disp_drv_t *disp_drv, uint32_t time, uint32_t px);
   void setupDisplay();
+  bool touchPending();
+
+  // Touch interrupt: latches a pending touch and wakes the run loop
+  static volatile bool touchIrq;
+  static void touchISR();
+
+  // Press/release transitions are posted to the EventBus as TouchEvents
+  bool touchDown = false;
+  uint16_t lastTouchX = 0;
+  uint16_t lastTouchY = 0;
+  void publishTouch(bool pressed, uint16_t x, uint16_t y);
+
+  // Hardware scroll state (rows in LVGL coordinates)
+  ScrollRegion scroll;
+  void writeScrollRegion(uint16_t top, uint16_t rows);
+  void writeScrollStart();
 
 public:
   // Delete copy constructor and assignment operator
@@ -97,8 +125,77 @@ public:
   static void debugPrint(const char *buf);
 #endif
 
-  // Periodic tasks
-  void update();
+  // Periodic tasks; returns the ms until LVGL next needs servicing
+  uint32_t update();
+
+  // Tell the SPI arbiter when LVGL will next flush. Call after the scheduler
+  // tasks and event handlers, which invalidate widgets, and before SD work.
+  void updateFlushHint();
+
+  // Active-low touch interrupt pin, or -1 if there is none
+  static constexpr int8_t touchIrqPin()
+  {
+#ifdef TOUCH_TYPE_RESISTIVE
+    return XPT2046_IRQ;
+#elif defined(TOUCH_TYPE_CAPACITIVE)
+    return CST820_INT;
+#else
+    return -1;
+#endif
+  }
+
+  RefreshGovernor &refreshGovernor() { return governor; }
+
+  // Hardware vertical scrolling (ST7789 VSCRDEF/VSCSAD)
+  // Rows [top, top + rows) become a ring: scrollBy() moves what is shown with a
+  // single register write and the panel keeps everything else. LVGL keeps
+  // drawing in frame memory coordinates, so after scrolling only the rows that
+  // came into view need to be redrawn (see invalidateExposed()). Touch points
+  // are mapped back to frame memory rows automatically.
+  // The panel scrolls along its 320 rows, which are LVGL's y axis only in
+  // rotation 0 with a 320-row display driver. In any other orientation
+  // (including this template's 320x240 landscape driver) setScrollRegion()
+  // refuses and returns false.
+  bool setScrollRegion(uint16_t top, uint16_t rows);
+  void clearScrollRegion();
+  // Positive lines move the content up and expose new rows at the bottom
+  void scrollBy(int16_t lines);
+  bool scrolling() const { return scroll.active(); }
+
+  // Convert between where a row is seen on the glass and where it is in frame memory
+  lv_coord_t screenToMemoryY(lv_coord_t y) const;
+  lv_coord_t memoryToScreenY(lv_coord_t y) const;
+
+  // Frame memory strips revealed by the last scrollBy(); the strip can wrap
+  // around the end of the region, so it is returned as up to two areas
+  uint8_t exposedAreas(lv_area_t out[2]) const;
+  // Invalidate just the revealed strip on the active screen
+  void invalidateExposed() const;
+
+  // What each LVGL refresh costs: render time from the monitor callback and
+  // bytes pushed to the panel. Refreshes over the budget are counted so a UI
+  // change that suddenly redraws or flushes much more shows up in the report.
+  struct RenderStats
+  {
+    uint32_t refreshes = 0;
+    uint32_t flushes = 0;
+    uint32_t totalRenderMs = 0;
+    uint32_t maxRenderMs = 0;
+    uint64_t bytesFlushed = 0;
+    uint32_t maxBytesPerRefresh = 0;
+    uint32_t overBudget = 0;
+  };
+  const RenderStats &renderStats() const { return render; }
+  void resetRenderStats() { render = RenderStats(); }
+  // 0 disables a limit
+  void setRenderBudget(uint32_t maxMs, uint32_t maxBytes);
+  void reportRender(Print &out) const;
+
+private:
+  RenderStats render;
+  uint32_t refreshBytes = 0; // flushed so far in the current refresh
+  uint32_t budgetMs = 0;
+  uint32_t budgetBytes = 0;
 };
 
 #endif // TEMPLATE_CODE_H
@@ -0,0 +1,194 @@
+#include "TrendChart.h"
+#include "SensorManager.h"
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+
+TrendChart::~TrendChart() {
+#if !STATIC_ALLOC
+  free(pixels);
+#endif
+}
+
+lv_obj_t *TrendChart::create(lv_obj_t *parent) {
+  return create(parent, Config());
+}
+
+lv_obj_t *TrendChart::create(lv_obj_t *parent, const Config &c) {
+  cfg = c;
+  size_t bytes = (size_t)cfg.width * cfg.height * sizeof(lv_color_t);
+#if STATIC_ALLOC
+  pixels = bytes <= sizeof(storage) ? storage : nullptr;
+#else
+  free(pixels);
+  pixels = (lv_color_t *)malloc(bytes);
+#endif
+  if (!pixels) return nullptr;
+
+  img.header.cf = LV_IMG_CF_TRUE_COLOR;
+  img.header.always_zero = 0;
+  img.header.w = cfg.width;
+  img.header.h = cfg.height;
+  img.data_size = bytes;
+  img.data = (const uint8_t *)pixels;
+  clear();
+
+  object = lv_obj_create(parent);
+  lv_obj_remove_style_all(object);
+  lv_obj_set_size(object, cfg.width, cfg.height);
+  lv_obj_clear_flag(object, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_event_cb(object, drawEvent, LV_EVENT_DRAW_MAIN, this);
+  return object;
+}
+
+void TrendChart::setSeries(size_t index, lv_color_t color, float min, float max) {
+  if (index >= MaxSeries || !(max > min)) return;
+  SeriesState &s = series[index];
+  s.color = color;
+  s.min = min;
+  s.max = max;
+  s.used = true;
+}
+
+uint32_t TrendChart::spanMs(uint32_t sampleIntervalMs) const {
+  return (uint32_t)cfg.width * cfg.samplesPerColumn * sampleIntervalMs;
+}
+
+lv_coord_t TrendChart::rowFor(const SeriesState &s, float v) const {
+  float f = (v - s.min) / (s.max - s.min);
+  if (f < 0) f = 0;
+  if (f > 1) f = 1;
+  return (cfg.height - 1) - (lv_coord_t)lroundf(f * (cfg.height - 1));
+}
+
+void TrendChart::clear() {
+  head = 0;
+  bucketFill = 0;
+  for (SeriesState &s : series) {
+    s.hi = -1;
+    s.last = -1;
+    s.joinFrom = -1;
+  }
+  for (lv_coord_t x = 0; x < cfg.width; x++) drawColumn(x);
+}
+
+// Repaint one column: background and grid, then the current bucket of each series
+void TrendChart::drawColumn(lv_coord_t x) {
+  lv_coord_t step = cfg.gridLines ? cfg.height / cfg.gridLines : 0;
+  lv_color_t *px = pixels + x;
+  for (lv_coord_t y = 0; y < cfg.height; y++) {
+    px[(size_t)y * cfg.width] = (step && y > 0 && y % step == 0) ? cfg.grid : cfg.background;
+  }
+  if (x != head) return;
+
+  for (const SeriesState &s : series) {
+    if (!s.used || s.hi < s.lo) continue;
+    lv_coord_t lo = s.lo, hi = s.hi;
+    if (s.joinFrom >= 0) {
+      if (s.joinFrom < lo) lo = s.joinFrom;
+      if (s.joinFrom > hi) hi = s.joinFrom;
+    }
+    for (lv_coord_t y = lo; y <= hi; y++) px[(size_t)y * cfg.width] = s.color;
+  }
+}
+
+bool TrendChart::push(const float *values) {
+  bool started = false;
+  if (bucketFill >= cfg.samplesPerColumn) {
+    // Move on to the next column, overwriting the oldest one
+    head = head + 1 < cfg.width ? head + 1 : 0;
+    columns++;
+    started = true;
+    bucketFill = 0;
+    for (SeriesState &s : series) {
+      s.joinFrom = s.last;
+      s.hi = -1;
+    }
+  }
+
+  for (size_t i = 0; i < MaxSeries; i++) {
+    SeriesState &s = series[i];
+    if (!s.used) continue;
+    if (isnan(values[i])) {
+      s.last = -1; // leave a gap rather than joining across a failed read
+      continue;
+    }
+    lv_coord_t r = rowFor(s, values[i]);
+    if (s.hi < s.lo) {
+      s.lo = s.hi = r;
+    } else {
+      if (r < s.lo) s.lo = r;
+      if (r > s.hi) s.hi = r;
+    }
+    s.last = r;
+  }
+  bucketFill++;
+  drawColumn(head);
+  return started;
+}
+
+// Invalidate the columns from `first` up to the write column, `started`
+// columns on; one or two strips if that range wraps past the right edge
+void TrendChart::invalidate(lv_coord_t first, uint32_t started) {
+  if (!object) return;
+  if (started + 1 >= (uint32_t)cfg.width) {
+    lv_obj_invalidate(object);
+    return;
+  }
+  lv_area_t coords;
+  lv_obj_get_coords(object, &coords);
+  lv_area_t area = coords;
+  area.x1 = coords.x1 + first;
+  if (head >= first) {
+    area.x2 = coords.x1 + head;
+  } else {
+    area.x2 = coords.x2;
+    lv_obj_invalidate_area(object, &area);
+    area.x1 = coords.x1;
+    area.x2 = coords.x1 + head;
+  }
+  lv_obj_invalidate_area(object, &area);
+}
+
+void TrendChart::addSample(const float *values) {
+  if (!pixels) return;
+  uint32_t start = micros();
+  push(values);
+  invalidate(head, 0); // only the write column changed
+  uint32_t us = micros() - start;
+  avgUs = avgUs ? (avgUs * 7 + us) / 8 : us;
+}
+
+void TrendChart::poll(const SensorManager &sensors) {
+  if (!pixels) return;
+  uint32_t count = sensors.sampleCount();
+  uint32_t fits = (uint32_t)cfg.width * cfg.samplesPerColumn;
+  // First call, or we fell behind by more than the chart shows: skip ahead
+  if (!polled || count - nextSeq > fits) {
+    nextSeq = count > fits ? count - fits : 0;
+    polled = true;
+  }
+  if (nextSeq == count) return;
+
+  lv_coord_t first = head;
+  uint32_t started = 0;
+  SensorManager::Sample sample;
+  for (; nextSeq < count; nextSeq++) {
+    if (!sensors.sampleAt(nextSeq, sample)) continue;
+    float v[MaxSeries] = {
+        sample.tempTenths == SensorManager::NoValue ? NAN : sample.tempTenths / 10.0f,
+        sample.humidityTenths == SensorManager::NoValue ? NAN : sample.humidityTenths / 10.0f,
+    };
+    if (push(v)) started++;
+  }
+  invalidate(first, started);
+}
+
+void TrendChart::drawEvent(lv_event_t *e) {
+  auto *self = static_cast<TrendChart *>(lv_event_get_user_data(e));
+  lv_area_t coords;
+  lv_obj_get_coords(self->object, &coords);
+  lv_draw_img_dsc_t dsc;
+  lv_draw_img_dsc_init(&dsc);
+  lv_draw_img(lv_event_get_draw_ctx(e), &dsc, &coords, &self->img);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <lvgl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "StaticAlloc.h"
+
+// Largest chart (width x height) in STATIC_ALLOC builds; the default Config
+// is 200 x 100. create() fails for a bigger one.
+#ifndef TREND_CHART_MAX_PIXELS
+#define TREND_CHART_MAX_PIXELS (200 * 100)
+#endif
+
+class SensorManager;
+
+// Sweeping strip chart for SensorManager history.
+// Each pixel column holds one min/max bucket of samplesPerColumn readings per
+// series, so the drawing cost per sample is one column no matter how much
+// history is on screen. The pixel buffer is a ring of columns with a write
+// column that moves right one step per bucket and wraps to the left edge,
+// overwriting the oldest column, like a patient monitor trace. Nothing is
+// moved in memory or on screen, so a new sample only repaints and invalidates
+// the 1 px wide write column.
+class TrendChart {
+public:
+  static constexpr size_t MaxSeries = 2;
+
+  struct Config {
+    lv_coord_t width = 200;
+    lv_coord_t height = 100;
+    uint16_t samplesPerColumn = 4;  // 200 columns x 4 samples x 2 s = ~27 minutes
+    uint8_t gridLines = 4;          // horizontal divisions
+    lv_color_t background = lv_color_hex(0x000000);
+    lv_color_t grid = lv_color_hex(0x202020);
+  };
+
+  TrendChart() = default;
+  ~TrendChart();
+  TrendChart(const TrendChart &) = delete;
+  TrendChart &operator=(const TrendChart &) = delete;
+
+  lv_obj_t *create(lv_obj_t *parent);
+  lv_obj_t *create(lv_obj_t *parent, const Config &cfg);
+
+  // Fixed value range for a series; values outside are clamped to the edge
+  void setSeries(size_t index, lv_color_t color, float min, float max);
+
+  // Append one reading per series (NAN leaves a gap)
+  void addSample(const float *values);
+
+  // Pull any new readings from the sensor history. The first call backfills
+  // as much history as fits on the chart.
+  void poll(const SensorManager &sensors);
+
+  // Time covered by the full width of the chart
+  uint32_t spanMs(uint32_t sampleIntervalMs) const;
+
+  lv_obj_t *obj() const { return object; }
+  uint32_t columnsDrawn() const { return columns; }
+  uint32_t avgColumnUs() const { return avgUs; }
+
+private:
+  struct SeriesState {
+    lv_color_t color;
+    float min = 0;
+    float max = 1;
+    bool used = false;
+    lv_coord_t lo = 0;      // current bucket extent, in pixel rows
+    lv_coord_t hi = -1;
+    lv_coord_t last = -1;   // row of the newest sample, -1 if none
+    lv_coord_t joinFrom = -1; // last row of the previous column, used to join the trace
+  };
+
+  void clear();
+  bool push(const float *values); // returns true if a new column was started
+  void invalidate(lv_coord_t first, uint32_t started);
+  void drawColumn(lv_coord_t x);
+  lv_coord_t rowFor(const SeriesState &s, float v) const;
+  static void drawEvent(lv_event_t *e);
+
+  Config cfg;
+  SeriesState series[MaxSeries];
+  lv_obj_t *object = nullptr;
+  lv_color_t *pixels = nullptr;
+#if STATIC_ALLOC
+  lv_color_t storage[TREND_CHART_MAX_PIXELS];
+#endif
+  lv_img_dsc_t img = {};
+  lv_coord_t head = 0; // column the current bucket is drawn in
+  uint16_t bucketFill = 0;
+  uint32_t nextSeq = 0;
+  bool polled = false;
+  uint32_t columns = 0;
+  uint32_t avgUs = 0;
+};
@@ -0,0 +1,42 @@
+#include "WidgetBinding.h"
+#include "ReportPrint.h"
+#include <Arduino.h>
+
+WidgetBinding *WidgetBinding::first = nullptr;
+WidgetBinding::Stats WidgetBinding::st;
+
+WidgetBinding::WidgetBinding(uint32_t intervalMs) : intervalMs(intervalMs) {
+  next = first;
+  first = this;
+}
+
+WidgetBinding::~WidgetBinding() {
+  for (WidgetBinding **p = &first; *p; p = &(*p)->next) {
+    if (*p == this) {
+      *p = next;
+      break;
+    }
+  }
+}
+
+void WidgetBinding::serviceAll(uint32_t now) {
+  uint32_t start = micros();
+  if (now == 0) now = millis();
+  for (WidgetBinding *b = first; b; b = b->next) {
+    if (!b->widget || (!b->forced && now - b->sampledAt < b->intervalMs)) continue;
+    b->sampledAt = now;
+    b->forced = false;
+    st.samples++;
+    if (b->poll()) st.renders++;
+  }
+  uint32_t us = micros() - start;
+  st.loops++;
+  st.totalUs += us;
+  if (us > st.maxUs) st.maxUs = us;
+}
+
+void WidgetBinding::report(Print &out) {
+  reportf(out, "[binding] loops=%lu mean=%.2fus max=%luus samples=%lu renders=%lu\n", (unsigned long)st.loops,
+               st.loops ? (double)st.totalUs / st.loops : 0.0, (unsigned long)st.maxUs, (unsigned long)st.samples,
+               (unsigned long)st.renders);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <functional>
+#include <lvgl.h>
+
+class Print;
+
+// Shows a live value in an LVGL widget at a display rate instead of on every
+// loop() pass. Each binding samples its source every intervalMs; the widget is
+// only touched when the value changed and its text came out different, since
+// setting a label reallocates its text and invalidates it for a redraw even
+// when nothing visible changed. Call WidgetBinding::serviceAll() once per
+// loop(); it also measures what the bindings cost per pass.
+class WidgetBinding {
+public:
+  struct Stats {
+    uint32_t loops = 0;   // serviceAll() calls
+    uint32_t samples = 0; // source reads
+    uint32_t renders = 0; // widget updates
+    uint64_t totalUs = 0; // time spent in serviceAll()
+    uint32_t maxUs = 0;
+  };
+
+  WidgetBinding(const WidgetBinding &) = delete;
+  WidgetBinding &operator=(const WidgetBinding &) = delete;
+  virtual ~WidgetBinding();
+
+  // Bind to the widget once it exists (after ui_init()); nullptr detaches it
+  void begin(lv_obj_t *obj) {
+    widget = obj;
+    refresh();
+  }
+  void setInterval(uint32_t ms) { intervalMs = ms; }
+  // Show the current value on the next serviceAll(), e.g. after a screen change
+  void refresh() {
+    forced = true;
+    invalidate();
+  }
+
+  static void serviceAll(uint32_t now = 0);
+  static const Stats &stats() { return st; }
+  static void report(Print &out);
+
+protected:
+  explicit WidgetBinding(uint32_t intervalMs);
+
+  // Sample the source; true if the widget was updated
+  virtual bool poll() = 0;
+  // Forget what is on screen so the next poll() redraws
+  virtual void invalidate() = 0;
+
+  lv_obj_t *widget = nullptr;
+
+private:
+  uint32_t intervalMs;
+  uint32_t sampledAt = 0;
+  bool forced = true;
+  WidgetBinding *next = nullptr;
+
+  static WidgetBinding *first;
+  static Stats st;
+};
+
+// A number shown in a label through a printf format, e.g.
+//   LabelBinding<long> position([] { return stepper.currentPosition(); }, "%ld");
+template <typename T>
+class LabelBinding : public WidgetBinding {
+public:
+  static constexpr size_t MaxText = 24;
+
+  LabelBinding(std::function<T()> source, const char *fmt, uint32_t intervalMs = 100)
+      : WidgetBinding(intervalMs), source(source), fmt(fmt) {}
+
+protected:
+  bool poll() override {
+    T v = source();
+    if (shown && v == last) return false;
+    last = v;
+    shown = true;
+
+    char buf[MaxText];
+    snprintf(buf, sizeof(buf), fmt, v);
+    if (strcmp(buf, text) == 0) return false; // e.g. rounded to the same digits
+    memcpy(text, buf, sizeof(text));
+    lv_label_set_text(widget, text);
+    return true;
+  }
+
+  void invalidate() override {
+    shown = false;
+    text[0] = '\0';
+  }
+
+private:
+  std::function<T()> source;
+  const char *fmt;
+  T last{};
+  bool shown = false;
+  char text[MaxText] = "";
+};
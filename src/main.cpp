@@ -16,8 +16,20 @@
 
 #include <LovyanGFX.hpp> // Display library: https://github.com/lovyan03/LovyanGFX
 #include "CST820.h"      // Custom I2C driver for CST820 capacitive touchscreen
+#include "I2CBus.h"      // Shared I2C bus with prioritised transaction queue
 #include "PeriodicScheduler.h"
+#include "RunLoop.h"
+#include "Coroutine.h"
+#include "EventBus.h"
+#include "Events.h"
 #include "SensorManager.h"
+#include "FileManager.h"
+#include "CompressedImage.h"
+#include "ScreenCapture.h"
+#include "Telemetry.h"
+#include "LogSink.h"
+#include "Log.h"
+#include "StaticAlloc.h"
 #include <DHT.h>
 
 /**
@@ -30,18 +42,31 @@ TemplateCode &templateCode = TemplateCode::getInstance();
 MainInterface mainInterface = MainInterface();
 
 // DHT11 sensor setup (external sensor)
-// Connect DHT11 data pin to GPIO21 or GPIO22 (choose one available)
-// DHT11 sensor setup (external sensor)
-// Connect DHT11 data pin to GPIO21 or GPIO22 (choose one available)
-#define DHTPIN 21 // Change to 22 if needed
+// Connect DHT11 data pin to GPIO21 or GPIO22 (choose one available). On the
+// capacitive board GPIO21 is the touch controller's interrupt line, and every
+// DHT transfer would look like a touch, so the sensor goes on GPIO22 there.
+#ifdef TOUCH_TYPE_CAPACITIVE
+#define DHTPIN 22
+#else
+#define DHTPIN 21
+#endif
 #define DHTTYPE DHT11
+static_assert(DHTPIN != TemplateCode::touchIrqPin(), "DHT data pin is the touch interrupt pin");
 
 // Scheduler for periodic tasks
 PeriodicScheduler scheduler;
+// Task slack is ignored while the display refreshes faster than this
+#define SLACK_MIN_FRAME_MS 30
+
+// Sleeps loop() until the next LVGL timer or scheduled task is due
+RunLoop runLoop;
 
 // Manager for sensors - DHT operations are abstracted here
 SensorManager sensorManager(DHTPIN, DHTTYPE, 2000);
 
+// SD card access; large writes are queued and drained between display flushes
+FileManager fileManager;
+
 /**
  * --------- Custom user functions ---------
  * Add any custom functions here so the main loop and setup functions are kept clean and easy to read.
@@ -99,6 +124,19 @@ public:
 LGFX_JustDisplay tft;
 CST820 touch(33, 32, 25, 21); // Touch: SDA, SCL, RST, INT
 
+// Reports the touch controller's chip ID once its reset sequence has finished
+class TouchProbe : public Coroutine
+{
+protected:
+  void step(uint32_t now) override
+  {
+    CO_BEGIN();
+    CO_WAIT_UNTIL(touch.ready());
+    LOG_INFO("CST820 Chip ID: 0x%02X", touch.chipID());
+    CO_END();
+  }
+} touchProbe;
+
 /**
  * ------------------
  * Setup fuction
@@ -121,36 +159,178 @@ void setup()
     } // Halt if initialization fails
   }
 
+  // Decoder for packed image assets (scripts/pack_image.py), with a 32 KB decoded-image cache
+  CompressedImage::begin(32 * 1024);
+
   // Initialize the main interface
   mainInterface.init();
 
-  // Register callback to update UI when sensors change
-  sensorManager.onChange([&](float t, float h){
-    if (!isnan(t)) mainInterface.setTemperature(t);
-    if (!isnan(h)) mainInterface.setHumidity(h);
-  });
+  // Count refreshes that take longer than 50 ms or push more than a full screen
+  templateCode.setRenderBudget(50, 240 * 320 * 2);
+
+  // SD card is optional; queued writes are dropped if it is missing.
+  // Fonts, images and screens can be loaded from it as "S:/path".
+  if (!fileManager.begin())
+  {
+    Serial.println("No SD card found.");
+  }
+  fileManager.registerLvglDriver('S');
+#if STATIC_ALLOC
+  // No file can be opened once the heap is locked at the end of setup(), so
+  // open the one queueAppend() will write to now (set the path to yours)
+  fileManager.openAppend("/data.csv");
+#endif
+
+  // The trend chart pulls readings from the sensor history
+  mainInterface.setHistory(&sensorManager);
+
+  // Show each sensor reading on the UI
+  EventBus::subscribe<SensorReading>([](const SensorReading &r, void *)
+                                     {
+    if (!isnan(r.tempC)) mainInterface.setTemperature(r.tempC);
+    if (!isnan(r.humidity)) mainInterface.setHumidity(r.humidity); });
+
+  // Binary telemetry (scripts/telemetry_decode.py): sensor samples are never
+  // dropped before scheduler stats, and per-frame timings go first
+  EventBus::subscribe<SensorReading>([](const SensorReading &r, void *)
+                                     {
+    Telemetry::SensorBody body;
+    body.tempTenths = isnan(r.tempC) ? INT16_MIN : (int16_t)lroundf(r.tempC * 10.0f);
+    body.humidityTenths = isnan(r.humidity) ? INT16_MIN : (int16_t)lroundf(r.humidity * 10.0f);
+    Telemetry::getInstance().send(Telemetry::SCHEMA_SENSOR, Telemetry::PRIORITY_HIGH, body); });
+  EventBus::subscribe<FrameRendered>([](const FrameRendered &f, void *)
+                                     {
+    Telemetry::FrameBody body;
+    body.renderMs = f.renderMs > UINT16_MAX ? UINT16_MAX : f.renderMs;
+    body.bytesFlushed = f.bytesFlushed;
+    Telemetry::getInstance().send(Telemetry::SCHEMA_FRAME, Telemetry::PRIORITY_LOW, body); });
+
+  // Memory samples as telemetry, and straight away at high priority when an alarm changes
+  static auto sendMemory = [](Telemetry::Priority prio)
+  {
+    MemoryMonitor &mem = MemoryMonitor::getInstance();
+    const MemoryMonitor::Sample &m = mem.last();
+    Telemetry::MemoryBody body;
+    body.freeHeap = m.freeHeap;
+    body.largestBlock = m.largestBlock;
+    body.minFreeHeap = m.minFreeHeap;
+    body.lvglUsedPct = m.lvglUsedPct;
+    body.lvglFragPct = m.lvglFragPct;
+    body.minStackFree = m.minStackFree;
+    body.trendBytesPerMin = mem.trendBytesPerMin();
+    body.alarms = mem.alarms();
+    Telemetry::getInstance().send(Telemetry::SCHEMA_MEMORY, prio, body);
+  };
+  EventBus::subscribe<MemoryAlarm>([](const MemoryAlarm &a, void *)
+                                   {
+    if (a.active)
+      LOG_WARN("[warn] memory alarm 0x%02x: %lu against limit %lu %s", a.alarm, (unsigned long)a.value,
+               (unsigned long)a.limit, a.task ? a.task : "");
+    else
+      LOG_INFO("memory alarm 0x%02x cleared", a.alarm);
+    sendMemory(Telemetry::PRIORITY_HIGH); });
+
+  // Log scheduler overruns and SD card problems
+  EventBus::subscribe<TaskOverrun>([](const TaskOverrun &o, void *)
+                                   { LOG_WARN("[warn] task %s took %luus (every %lums)", o.task ? o.task : "?",
+                                              (unsigned long)o.execUs, (unsigned long)o.intervalMs); });
+  EventBus::subscribe<StorageEvent>([](const StorageEvent &e, void *)
+                                    {
+    if (e.kind == StorageEvent::WRITE_FAILED)
+      LOG_WARN("[warn] SD write failed, %lu bytes dropped", (unsigned long)e.bytes); });
 
   // Schedule sensor reads and UI updates
-  scheduler.addTask(std::bind(&SensorManager::update, &sensorManager), 2000);
-  scheduler.addTask(std::bind(&MainInterface::update, &mainInterface), 100);
+  // UI work is never deferred; the sensor task only starts the DHT read coroutine
+  // (hence its 100 us cost), whose ~5 ms bit transfer then runs from
+  // CoroutineRunner::service(), outside the scheduler budget
+  // Slack lets the tasks share wakeups with each other and with LVGL refreshes
+  scheduler.setBudget(5000);
+  int sensorTask = scheduler.addTask(std::bind(&SensorManager::update, &sensorManager), 2000, "sensors",
+                                     PeriodicScheduler::PRIORITY_NORMAL, 100);
+  scheduler.setSlack(sensorTask, 500);
+  int uiTask = scheduler.addTask(std::bind(&MainInterface::update, &mainInterface), 100, "ui",
+                                 PeriodicScheduler::PRIORITY_HIGH, 500);
+  scheduler.setSlack(uiTask, 50);
+
+  // Report how much CPU time the adaptive refresh rate and idle sleeping are saving.
+  // Through the log, which takes turns on the port with telemetry and capture.
+  int reportTask = scheduler.addTask([&]()
+                                     {
+    Print &out = LogSink::getInstance().printer();
+    templateCode.refreshGovernor().report(out);
+    templateCode.reportRender(out);
+    runLoop.report(out);
+    I2CBus::getInstance().report(out);
+    SpiArbiter::getInstance().report(out);
+    CompressedImage::report(out);
+    fileManager.reportFs(out);
+    ScreenCapture::getInstance().report(out);
+    CoroutineRunner::getInstance().report(out);
+    EventBus::report(out);
+    Telemetry::getInstance().report(out);
+    LogSink::getInstance().report(out);
+    MemoryMonitor::getInstance().report(out);
+    HeapGuard::report(out);
+#if LOG_DEFERRED
+    DeferredLog::getInstance().report(out);
+#endif
+    scheduler.dumpStats(out); }, 60000, "report", PeriodicScheduler::PRIORITY_LOW, 5000);
+  scheduler.setSlack(reportTask, 10000);
+
+  // Heap, LVGL pool and stack high-water marks every 10 s; 32 samples of history for the trend
+  int memoryTask = scheduler.addTask([]()
+                                     {
+    MemoryMonitor::getInstance().sample();
+    sendMemory(Telemetry::PRIORITY_NORMAL); }, 10000, "memory", PeriodicScheduler::PRIORITY_LOW, 300);
+  scheduler.setSlack(memoryTask, 2000);
+
+#if SCHEDULER_STATS
+  // Scheduler statistics as telemetry, one message per task
+  int telemetryTask = scheduler.addTask([&]()
+                                        {
+    for (int id = 0; const PeriodicScheduler::TaskStats *st = scheduler.stats(id); id++)
+    {
+      Telemetry::TaskBody body;
+      body.task = id;
+      body.runs = st->runs;
+      body.overruns = st->overruns;
+      body.deferrals = st->deferrals;
+      body.execMeanUs = st->execMeanUs();
+      body.execMaxUs = st->execMaxUs;
+      body.jitterMaxMs = st->jitterMaxMs;
+      Telemetry::getInstance().send(Telemetry::SCHEMA_TASK, Telemetry::PRIORITY_NORMAL, body);
+    } }, 5000, "telemetry", PeriodicScheduler::PRIORITY_LOW, 500);
+  scheduler.setSlack(telemetryTask, 1000);
+#endif
 
   /* Add custom setup code here. */
 
-  // Initialize I2C for CST820 (if not already done in CST820::begin)
-  // Wire.begin(I2C_SDA, I2C_SCL); // CST820::begin() should handle this
+  // I2C is owned by I2CBus; CST820::begin() starts it on the touch pins.
+  // Other I2C devices should use I2CBus::submit() rather than Wire directly.
 
-  // Initialize touchscreen
+  // Initialize touchscreen; the reset sequence continues in the background
   touch.begin();
 
-  // Debug: Read CST820 chip ID
-  uint8_t chip_id = touch.readChipID();
-  Serial.print("CST820 Chip ID: 0x");
-  Serial.println(chip_id, HEX);
+  // Debug: print the CST820 chip ID once the touch controller is up
+  CoroutineRunner::getInstance().start(touchProbe);
 
   Serial.begin(115200);
   delay(500);
+
+  // LVGL log lines and warnings are written by a background task; raise the
+  // level to LEVEL_WARN or LEVEL_NONE to quieten them
+  LogSink::getInstance().begin(Serial, LogSink::LEVEL_INFO);
   Serial.println("🧪 Touch + Display test starting...");
 
+  // Memory monitor: watches loop() and the background tasks' stacks, alarms go to the log
+  MemoryMonitor::getInstance().begin();
+  MemoryMonitor::getInstance().watchTask("log");
+  MemoryMonitor::getInstance().watchTask("esp_timer");
+
+  // Remote screenshots: scripts/capture_to_png.py sends 'C' to start the capture stream
+  ScreenCapture::getInstance().begin(Serial);
+  Telemetry::getInstance().begin(Serial);
+
   // Enable backlight (GPIO 27 must be HIGH)
   pinMode(27, OUTPUT);
   digitalWrite(27, HIGH);
@@ -164,7 +344,15 @@ void setup()
   tft.setCursor(30, 100);
   tft.println("Touch to draw");
 
-  Serial.println("✅ Setup complete");
+  // Touch IRQ wakes loop() early; set lightSleep to also use light sleep for long idle gaps
+  RunLoop::Config runLoopCfg;
+  runLoopCfg.wakePin = TemplateCode::touchIrqPin();
+  runLoop.begin(runLoopCfg);
+
+  // With -DSTATIC_ALLOC=1 any operator new or malloc from here on aborts
+  HeapGuard::lock();
+
+  LOG_INFO("✅ Setup complete");
 }
 
 /**
@@ -178,12 +366,53 @@ void loop()
 {
 
   // Run the update logic for the template code (includes LVGL handling)
-  templateCode.update();
+  uint32_t lvglDue = templateCode.update();
 
   // Sensor reads are handled by SensorManager registered with the PeriodicScheduler
 
-  // Scheduler handles periodic sensor reads and UI updates
-  scheduler.update();
+  // Slack only pays off once the refresh period has decayed: at the 20 ms
+  // active period it makes more frames late (scripts/scheduler_sim.cpp)
+  scheduler.setSlackEnabled(templateCode.refreshGovernor().currentPeriod() >= SLACK_MIN_FRAME_MS);
+
+  // Scheduler handles periodic sensor reads and UI updates, using at most the
+  // time left before LVGL's next timer; anything that doesn't fit carries over
+  scheduler.update(0, lvglDue < UINT32_MAX / 1000 ? lvglDue * 1000 : UINT32_MAX);
+
+  // Run queued (non-touch) I2C transactions within a small time budget
+  I2CBus::getInstance().service();
+
+  // Resume device sequences (touch reset, DHT reads) whose waits are over
+  CoroutineRunner::getInstance().service();
 
-  delay(10); // Small delay - scheduler controls update frequency
+  // Deliver events posted since the last pass (touch, overruns, storage)
+  EventBus::dispatchQueued();
+
+  // Write at most one queued SD chunk if it fits between display flushes,
+  // now that this pass's widget updates have been invalidated
+  templateCode.updateFlushHint();
+  fileManager.service();
+
+  // Host capture commands, frame markers and non-blocking capture output
+  ScreenCapture::getInstance().service();
+#if LOG_DEFERRED
+  DeferredLog::getInstance().service();
+#endif
+  Telemetry::getInstance().service();
+
+  // Sleep until whichever comes first: the next LVGL timer, the next scheduled task or a touch
+  uint32_t taskDue = I2CBus::getInstance().pending() || EventBus::pending() ? 0 : scheduler.msUntilNextDue();
+  uint32_t coroutineDue = CoroutineRunner::getInstance().msUntilNextResume();
+  if (coroutineDue < taskDue)
+  {
+    taskDue = coroutineDue;
+  }
+  if (fileManager.appendPending() && taskDue > 1)
+  {
+    taskDue = 1; // come back soon for the next SD chunk
+  }
+  if ((ScreenCapture::getInstance().txPending() || Telemetry::getInstance().txPending()) && taskDue > 2)
+  {
+    taskDue = 2; // keep the UART fed while capture or telemetry packets are queued
+  }
+  runLoop.waitFor(lvglDue < taskDue ? lvglDue : taskDue);
 }
@@ -79,10 +79,11 @@
    HAL SETTINGS
  *====================*/
 
-/*Default display refresh period. LVG will redraw changed areas with this period time*/
+/*Default display refresh period. LVG will redraw changed areas with this period time
+ *(Starting value only: RefreshGovernor retunes it at runtime based on activity)*/
 #define LV_DISP_DEF_REFR_PERIOD 30      /*[ms]*/
 
-/*Input device read period in milliseconds*/
+/*Input device read period in milliseconds (also retuned by RefreshGovernor)*/
 #define LV_INDEV_DEF_READ_PERIOD 30     /*[ms]*/
 
 /*Use a custom tick source that tells the elapsed time in milliseconds.
@@ -146,7 +147,7 @@
  *With complex image decoders (e.g. PNG or JPG) caching can save the continuous open/decode of images.
  *However the opened images might consume additional RAM.
  *0: to disable caching*/
-#define LV_IMG_CACHE_DEF_SIZE 0
+#define LV_IMG_CACHE_DEF_SIZE 4   /*Keeps CompressedImage assets open between redraws*/
 
 /*Number of stops allowed per gradient. Increase this to allow more stops.
  *This adds (sizeof(lv_color_t) + 1) bytes per additional stop*/
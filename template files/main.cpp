@@ -8,7 +8,10 @@
 #include "RGBledDriver.h" // The custom functions for controlling the RGB LED.
 #include <MobaTools.h>    // For the non-blocking stepper motor and button logic.
 #include <Preferences.h>  // Used for persistent storage of settings and other information that should be saved between reboots.
-#include <ezButton.h>     // For handling the limit switch.
+#include <esp_system.h>
+#include "SettingsStore.h" // RAM shadow of the settings with coalesced, CRC-checked NVS writes.
+#include "WidgetBinding.h" // Rate-limited label updates, so redraws don't compete with step generation.
+#include "LimitSwitch.h"   // Interrupt-driven limit switch, reacts within ~1 ms whatever loop() is doing.
 
 /*Using LVGL with Arduino requires some extra steps:
  *Be sure to read the docs here: https://docs.lvgl.io/master/get-started/platforms/arduino.html  */
@@ -43,11 +46,15 @@ float motorAcc = 500;      // higher is longer ramp up time, too low motor will
 bool motorRunning = false;
 bool reverse = false;
 
+// The limit switch handler runs in the esp_timer task and loop() in its own, so the
+// direction is only flipped and handed to the stepper while holding this lock
+portMUX_TYPE motorLock = portMUX_INITIALIZER_UNLOCKED;
+
 // Limit Switch Setup
 #define LIMIT_SWITCH_PIN 35 // GPIO pin for the limit switch
 
-// Use ezButton library to handle the limit switch.
-ezButton limitSwitch(LIMIT_SWITCH_PIN);
+// Pressed pulls the pin LOW; 1 ms settle time after the first edge
+LimitSwitch limitSwitch(LIMIT_SWITCH_PIN, true, 1000);
 
 // Power On/Off
 #define ONOFF_PIN 1 // on CYD is U0TXD on P1 TX NOTE: Serial debug will no longer work
@@ -82,10 +89,29 @@ void my_print(const char *buf)
 struct Settings
 {
     int32_t travelDistance;
-    uint16_t maxSpeed;
-    uint16_t acceleration;
+    uint32_t maxSpeed;     // steps / 10sec
+    uint16_t acceleration; // ramp length
 };
 
+// Bump the version whenever the layout of Settings changes; stored blobs with another
+// version are ignored and the defaults below are used instead.
+NvsSettingsBackend settingsBackend("cyd");
+SettingsStore<Settings, 1> settings(settingsBackend, Settings{0, 200000, 500});
+
+// Live readouts: sampled 10 times a second and redrawn only when the number changes.
+// Setting a label on every loop() pass reformats and invalidates it thousands of
+// times a second, which is CPU time taken from MobaTools.
+LabelBinding<long> speedReadout([]
+                                { return (long)stepper.getSpeedSteps(); }, "%ld", 100); //  steps / 10sec
+LabelBinding<long> positionReadout([]
+                                   { return (long)stepper.currentPosition(); }, "%ld", 100);
+
+// Flush pending settings when the firmware restarts (esp_restart, OTA update)
+void commitSettingsOnShutdown()
+{
+    settings.commit();
+}
+
 /* Display flushing */
 void my_disp_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
 {
@@ -120,10 +146,33 @@ void my_touchpad_read(lv_indev_drv_t *indev_drv, lv_indev_data_t *data)
     }
 }
 
-// Limit switch function to reverse motor direction when triggered
-void SWLimit()
+// Flip the direction and, if the motor is running, apply it straight away
+void reverseMotor()
 {
+    portENTER_CRITICAL(&motorLock);
     reverse = !reverse;
+    if (motorRunning)
+    {
+        stepper.rotate(reverse ? -1 : 1);
+    }
+    portEXIT_CRITICAL(&motorLock);
+}
+
+// Runs from the limit switch's timer as soon as a press is confirmed, not from loop(),
+// so the motor turns around without waiting for lv_timer_handler(). Keep it short.
+void onLimitSwitch(bool pressed)
+{
+    if (pressed)
+    {
+        reverseMotor();
+    }
+}
+
+// Limit switch function for the UI side of a trip, called from loop() after the
+// motor has already been reversed by onLimitSwitch()
+void SWLimit()
+{
+    // e.g. show the new direction on screen
 }
 
 void setup()
@@ -168,6 +217,16 @@ void setup()
     // lv_label_set_text( label, "Hello Ardino and LVGL!");
     // lv_obj_align( label, LV_ALIGN_CENTER, 0, 0 );
     ui_init();
+    speedReadout.begin(ui_SpeedLabel);
+    positionReadout.begin(ui_PositionLabel);
+
+    // Restore the saved settings (single blob read, falls back to defaults).
+    // Only the speed slider writes them back; no control changes the ramp yet, so it
+    // keeps its default until one calls settings.set(&Settings::acceleration, ...)
+    settings.begin();
+    motorSpeed = settings.get().maxSpeed;
+    motorAcc = settings.get().acceleration;
+    esp_register_shutdown_handler(commitSettingsOnShutdown);
 
     // Stepper motor configuration
     stepper.attach(STEP_PIN, DIR_PIN);
@@ -177,8 +236,8 @@ void setup()
     // Set GPIO to output to control the MOSFET
     pinMode(ONOFF_PIN, OUTPUT);
 
-    // Initialize limit switch
-    limitSwitch.setDebounceTime(50); // 50 ms debounce time
+    // Initialize limit switch (GPIO 35 has no internal pull-up, use an external one)
+    limitSwitch.begin(onLimitSwitch, INPUT);
 
     //    Serial.println("Setup done");
 }
@@ -186,26 +245,35 @@ void setup()
 void loop()
 {
 
-    // Run the stepper motor if enabled
+    // Run the stepper motor if enabled, in the current direction
+    portENTER_CRITICAL(&motorLock);
     if (motorRunning)
     {
-        stepper.rotate(reverse ? -1 : 1); // Rotate in the current direction
+        stepper.rotate(reverse ? -1 : 1);
     }
     else
     {
         stepper.rotate(0); // Stop rotating when motor is off
     }
+    portEXIT_CRITICAL(&motorLock);
 
-    // Update the limit switch state
-    limitSwitch.loop();
-    if (limitSwitch.isPressed())
+    // The motor has already reacted to the limit switch; update the UI
+    if (limitSwitch.takePress())
     {
         SWLimit(); // Call the limit switch function when triggered
     }
 
-    lv_label_set_text_fmt(ui_SpeedLabel, "%d", stepper.getSpeedSteps()); //  steps / 10sec
-    lv_label_set_text_fmt(ui_PositionLabel, "%d", stepper.currentPosition());
-
+    WidgetBinding::serviceAll(); /* speed and position labels, when due and changed */
+    // Readout cost per loop() pass and limit switch reaction times; needs Serial, which shares its TX pin with ONOFF_PIN
+    // static uint32_t lastReport = 0;
+    // if (millis() - lastReport >= 10000)
+    // {
+    //     lastReport = millis();
+    //     WidgetBinding::report(Serial);
+    //     limitSwitch.report(Serial); // worst-case reaction time of the limit switch
+    // }
+
+    settings.update();  /* write changed settings once they have been quiet for a while */
     lv_timer_handler(); /* let the GUI do its work */
 }
 
@@ -227,7 +295,7 @@ void stepperStop(lv_event_t *e)
 // Reverse Direction Button Function
 void stepperRev(lv_event_t *e)
 {
-    reverse = !reverse;
+    reverseMotor();
 }
 
 // Speed Slider Function
@@ -236,6 +304,7 @@ void stepperSpeed(lv_event_t *e)
     lv_obj_t *slider = lv_event_get_target(e);
     motorSpeed = lv_slider_get_value(slider); // Update motor speed from slider position ( steps / 10sec)
     stepper.setSpeedSteps(motorSpeed);        //  steps / 10sec
+    settings.set(&Settings::maxSpeed, (uint32_t)motorSpeed); // Saved after the slider is left alone
 }
 
 // Stepper Power on/off
@@ -249,4 +318,5 @@ void StepperPower_OFF(lv_event_t *e)
 {
     digitalWrite(ONOFF_PIN, LOW);
     motorRunning = false;
+    settings.commit(); // Likely to be switched off next, don't wait for the quiet period
 }